@@ -34,11 +34,12 @@
 
 typedef struct cJSON cJSON;
 
-typedef struct {
+typedef struct BlurConfig {
     bool blur;
     float blur_amount;
     char blur_output_fps[32];
     char blur_weighting[32];
+    char blur_mode[16];
     float* custom_weights;
     int custom_weights_count;
     bool interpolate;
@@ -46,6 +47,19 @@ typedef struct {
     char interpolation_method[32];
     int interpolation_block_size;
     float interpolation_mask_area;
+    char motion_vectors[32];
+    bool fused_interpolation;
+    char cache_dir[512];
+    char proxy_cache[512];
+    int proxy_scale;
+    int read_ahead_mb;
+    char input_io[16];
+    char raw_input[32];
+    float sequence_fps;
+    float start_time;
+    float end_time;
+    bool packet_index;
+    char output_io[16];
     bool pre_interpolation;
     char pre_interpolated_fps[32];
     int quality;
@@ -72,12 +86,19 @@ typedef struct {
     char codec[32];
     int bitrate;
     char pixel_format[32];
+    char encoder_preset[16];
+    char encoder_tune[16];
+    bool throughput;
+    char renditions[64];
+    float fragment_duration;
     int threads;
     bool verbose;
     bool debug;
     float timescale;
     bool pitch_correction;
     char ffmpeg_filters[1024];
+    struct BlurConfig* jobs;
+    int job_count;
 } BlurConfig;
 
 typedef struct cJSON {
@@ -401,14 +422,28 @@ BlurConfig* config_create(void) {
     config->blur_amount = 1.0f;
     strcpy(config->blur_output_fps, "60");
     strcpy(config->blur_weighting, "gaussian_sym");
+    strcpy(config->blur_mode, "frames");
     config->custom_weights = NULL;
     config->custom_weights_count = 0;
 
     config->interpolate = true;
     strcpy(config->interpolated_fps, "5x");
-    strcpy(config->interpolation_method, "rife");
+    strcpy(config->interpolation_method, "native");
     config->interpolation_block_size = 16;
     config->interpolation_mask_area = 0.0f;
+    strcpy(config->motion_vectors, "search");
+    config->fused_interpolation = true;
+    config->cache_dir[0] = '\0';
+    config->proxy_cache[0] = '\0';
+    config->proxy_scale = 1;
+    config->read_ahead_mb = 64;
+    strcpy(config->input_io, "default");
+    strcpy(config->raw_input, "auto");
+    config->sequence_fps = 25.0f;
+    config->start_time = 0.0f;
+    config->end_time = 0.0f;
+    config->packet_index = false;
+    strcpy(config->output_io, "default");
     config->pre_interpolation = false;
     strcpy(config->pre_interpolated_fps, "2x");
 
@@ -438,6 +473,11 @@ BlurConfig* config_create(void) {
     strcpy(config->codec, "h264");
     config->bitrate = 0;
     strcpy(config->pixel_format, "yuv420p");
+    config->encoder_preset[0] = '\0';
+    config->encoder_tune[0] = '\0';
+    config->throughput = false;
+    config->renditions[0] = '\0';
+    config->fragment_duration = 0.0f;
 
     config->threads = 0;
     config->verbose = false;
@@ -449,6 +489,15 @@ BlurConfig* config_create(void) {
     return config;
 }
 
+static void free_jobs(BlurConfig* config) {
+    for (int i = 0; i < config->job_count; i++) {
+        free(config->jobs[i].custom_weights);
+    }
+    free(config->jobs);
+    config->jobs = NULL;
+    config->job_count = 0;
+}
+
 void config_destroy(BlurConfig* config) {
     if (!config) return;
 
@@ -456,6 +505,7 @@ void config_destroy(BlurConfig* config) {
         free(config->custom_weights);
     }
 
+    free_jobs(config);
     free(config);
 }
 
@@ -496,51 +546,19 @@ static bool load_json_int(cJSON* json, const char* key, int* dest) {
     return false;
 }
 
-bool config_load_file(BlurConfig* config, const char* filename) {
-    FILE* fp = fopen(filename, "rb");
-    if (!fp) {
-        fprintf(stderr, "Error: Cannot open config file: %s\n", filename);
-        return false;
-    }
-
-    fseek(fp, 0, SEEK_END);
-    long size = ftell(fp);
-    fseek(fp, 0, SEEK_SET);
-
-    if (size <= 0) {
-        fprintf(stderr, "Error: Config file is empty or invalid: %s\n", filename);
-        fclose(fp);
-        return false;
-    }
-
-    char* buffer = (char*)malloc(size + 1);
-    if (!buffer) {
-        fprintf(stderr, "Error: Failed to allocate memory for config file\n");
-        fclose(fp);
-        return false;
-    }
-
-    size_t read_size = fread(buffer, 1, size, fp);
-    buffer[read_size] = '\0';
-    fclose(fp);
-
-    cJSON* json = cJSON_Parse(buffer);
-    free(buffer);
-
-    if (!json) {
-        fprintf(stderr, "Error: Invalid JSON in config file: %s\n", filename);
-        return false;
-    }
-
+static void load_json_settings(BlurConfig* config, cJSON* json) {
     load_json_bool(json, "blur", &config->blur);
     load_json_float(json, "blur_amount", &config->blur_amount);
     load_json_string(json, "blur_output_fps", config->blur_output_fps, sizeof(config->blur_output_fps));
     load_json_string(json, "blur_weighting", config->blur_weighting, sizeof(config->blur_weighting));
+    load_json_string(json, "blur_mode", config->blur_mode, sizeof(config->blur_mode));
 
     cJSON* weights_array = cJSON_GetObjectItem(json, "custom_weights");
     if (cJSON_IsArray(weights_array)) {
         int count = cJSON_GetArraySize(weights_array);
         if (count > 0) {
+            free(config->custom_weights);
+            config->custom_weights_count = 0;
             config->custom_weights = (float*)malloc(count * sizeof(float));
             if (config->custom_weights) {
                 config->custom_weights_count = count;
@@ -562,6 +580,19 @@ bool config_load_file(BlurConfig* config, const char* filename) {
     load_json_string(json, "interpolation_method", config->interpolation_method, sizeof(config->interpolation_method));
     load_json_int(json, "interpolation_block_size", &config->interpolation_block_size);
     load_json_float(json, "interpolation_mask_area", &config->interpolation_mask_area);
+    load_json_string(json, "motion_vectors", config->motion_vectors, sizeof(config->motion_vectors));
+    load_json_bool(json, "fused_interpolation", &config->fused_interpolation);
+    load_json_string(json, "cache_dir", config->cache_dir, sizeof(config->cache_dir));
+    load_json_string(json, "proxy_cache", config->proxy_cache, sizeof(config->proxy_cache));
+    load_json_int(json, "proxy_scale", &config->proxy_scale);
+    load_json_int(json, "read_ahead_mb", &config->read_ahead_mb);
+    load_json_string(json, "input_io", config->input_io, sizeof(config->input_io));
+    load_json_string(json, "raw_input", config->raw_input, sizeof(config->raw_input));
+    load_json_float(json, "sequence_fps", &config->sequence_fps);
+    load_json_float(json, "start_time", &config->start_time);
+    load_json_float(json, "end_time", &config->end_time);
+    load_json_bool(json, "packet_index", &config->packet_index);
+    load_json_string(json, "output_io", config->output_io, sizeof(config->output_io));
     load_json_bool(json, "pre_interpolation", &config->pre_interpolation);
     load_json_string(json, "pre_interpolated_fps", config->pre_interpolated_fps, sizeof(config->pre_interpolated_fps));
 
@@ -591,6 +622,11 @@ bool config_load_file(BlurConfig* config, const char* filename) {
     load_json_string(json, "codec", config->codec, sizeof(config->codec));
     load_json_int(json, "bitrate", &config->bitrate);
     load_json_string(json, "pixel_format", config->pixel_format, sizeof(config->pixel_format));
+    load_json_string(json, "encoder_preset", config->encoder_preset, sizeof(config->encoder_preset));
+    load_json_string(json, "encoder_tune", config->encoder_tune, sizeof(config->encoder_tune));
+    load_json_bool(json, "throughput", &config->throughput);
+    load_json_string(json, "renditions", config->renditions, sizeof(config->renditions));
+    load_json_float(json, "fragment_duration", &config->fragment_duration);
 
     load_json_int(json, "threads", &config->threads);
     load_json_bool(json, "verbose", &config->verbose);
@@ -598,6 +634,125 @@ bool config_load_file(BlurConfig* config, const char* filename) {
     load_json_float(json, "timescale", &config->timescale);
     load_json_bool(json, "pitch_correction", &config->pitch_correction);
     load_json_string(json, "ffmpeg_filters", config->ffmpeg_filters, sizeof(config->ffmpeg_filters));
+}
+
+static bool copy_job_config(BlurConfig* job, const BlurConfig* base) {
+    *job = *base;
+    job->jobs = NULL;
+    job->job_count = 0;
+    job->output_file[0] = '\0';
+
+    if (base->custom_weights) {
+        job->custom_weights = (float*)malloc(base->custom_weights_count * sizeof(float));
+        if (!job->custom_weights) {
+            job->custom_weights_count = 0;
+            return false;
+        }
+        memcpy(job->custom_weights, base->custom_weights, base->custom_weights_count * sizeof(float));
+    }
+    return true;
+}
+
+static bool load_json_jobs(BlurConfig* config, cJSON* jobs_array) {
+    int count = cJSON_GetArraySize(jobs_array);
+
+    free_jobs(config);
+    config->jobs = (BlurConfig*)calloc(count, sizeof(BlurConfig));
+    if (!config->jobs) {
+        fprintf(stderr, "Error: Failed to allocate memory for render jobs\n");
+        return false;
+    }
+
+    for (int i = 0; i < count; i++) {
+        cJSON* item = cJSON_GetArrayItem(jobs_array, i);
+        if (!cJSON_IsObject(item)) {
+            fprintf(stderr, "Error: Render job %d is not an object\n", i + 1);
+            free_jobs(config);
+            return false;
+        }
+
+        if (!copy_job_config(&config->jobs[i], config)) {
+            fprintf(stderr, "Error: Failed to allocate memory for render jobs\n");
+            free_jobs(config);
+            return false;
+        }
+        config->job_count = i + 1;
+
+        load_json_settings(&config->jobs[i], item);
+        load_json_string(item, "output_file", config->jobs[i].output_file, sizeof(config->jobs[i].output_file));
+    }
+
+    return true;
+}
+
+static void inherit_shared_settings(BlurConfig* job, const BlurConfig* base) {
+    strcpy(job->input_file, base->input_file);
+    strcpy(job->proxy_cache, base->proxy_cache);
+    strcpy(job->ffmpeg_filters, base->ffmpeg_filters);
+    strcpy(job->gpu_type, base->gpu_type);
+    job->proxy_scale = base->proxy_scale;
+    job->read_ahead_mb = base->read_ahead_mb;
+    strcpy(job->input_io, base->input_io);
+    strcpy(job->raw_input, base->raw_input);
+    job->sequence_fps = base->sequence_fps;
+    job->start_time = base->start_time;
+    job->end_time = base->end_time;
+    job->packet_index = base->packet_index;
+    job->gpu_decoding = base->gpu_decoding;
+    job->brightness = base->brightness;
+    job->saturation = base->saturation;
+    job->contrast = base->contrast;
+    job->gamma = base->gamma;
+    job->threads = base->threads;
+    job->verbose = base->verbose;
+    job->debug = base->debug;
+}
+
+bool config_load_file(BlurConfig* config, const char* filename) {
+    FILE* fp = fopen(filename, "rb");
+    if (!fp) {
+        fprintf(stderr, "Error: Cannot open config file: %s\n", filename);
+        return false;
+    }
+
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    if (size <= 0) {
+        fprintf(stderr, "Error: Config file is empty or invalid: %s\n", filename);
+        fclose(fp);
+        return false;
+    }
+
+    char* buffer = (char*)malloc(size + 1);
+    if (!buffer) {
+        fprintf(stderr, "Error: Failed to allocate memory for config file\n");
+        fclose(fp);
+        return false;
+    }
+
+    size_t read_size = fread(buffer, 1, size, fp);
+    buffer[read_size] = '\0';
+    fclose(fp);
+
+    cJSON* json = cJSON_Parse(buffer);
+    free(buffer);
+
+    if (!json) {
+        fprintf(stderr, "Error: Invalid JSON in config file: %s\n", filename);
+        return false;
+    }
+
+    load_json_settings(config, json);
+
+    cJSON* jobs_array = cJSON_GetObjectItem(json, "jobs");
+    if (cJSON_IsArray(jobs_array) && cJSON_GetArraySize(jobs_array) > 0) {
+        if (!load_json_jobs(config, jobs_array)) {
+            cJSON_Delete(json);
+            return false;
+        }
+    }
 
     cJSON_Delete(json);
     return true;
@@ -696,6 +851,26 @@ static void apply_preset(BlurConfig* config, const char* preset) {
     }
 }
 
+static float parse_time_value(const char* value) {
+    double seconds = 0;
+    const char* part = value;
+    char* end = NULL;
+
+    while (true) {
+        double field = strtod(part, &end);
+        if (end == part || field < 0) {
+            return -1.0f;
+        }
+        seconds = seconds * 60 + field;
+        if (*end != ':') {
+            break;
+        }
+        part = end + 1;
+    }
+
+    return *end == '\0' ? (float)seconds : -1.0f;
+}
+
 bool config_parse_args(BlurConfig* config, int argc, char* argv[]) {
     static struct option long_options[] = {
         {"help", no_argument, 0, 'h'},
@@ -705,6 +880,7 @@ bool config_parse_args(BlurConfig* config, int argc, char* argv[]) {
         {"blur-amount", required_argument, 0, 0},
         {"blur-output-fps", required_argument, 0, 0},
         {"blur-weighting", required_argument, 0, 0},
+        {"blur-mode", required_argument, 0, 0},
         {"custom-weights", required_argument, 0, 0},
         {"interpolate", no_argument, 0, 0},
         {"no-interpolate", no_argument, 0, 0},
@@ -712,6 +888,19 @@ bool config_parse_args(BlurConfig* config, int argc, char* argv[]) {
         {"interpolation-method", required_argument, 0, 0},
         {"interpolation-block-size", required_argument, 0, 0},
         {"interpolation-mask-area", required_argument, 0, 0},
+        {"motion-vectors", required_argument, 0, 0},
+        {"no-fused-interpolation", no_argument, 0, 0},
+        {"cache-dir", required_argument, 0, 0},
+        {"proxy-cache", required_argument, 0, 0},
+        {"proxy-scale", required_argument, 0, 0},
+        {"read-ahead", required_argument, 0, 0},
+        {"input-io", required_argument, 0, 0},
+        {"raw-input", required_argument, 0, 0},
+        {"sequence-fps", required_argument, 0, 0},
+        {"start", required_argument, 0, 0},
+        {"end", required_argument, 0, 0},
+        {"index", no_argument, 0, 0},
+        {"output-io", required_argument, 0, 0},
         {"pre-interpolation", no_argument, 0, 0},
         {"pre-interpolated-fps", required_argument, 0, 0},
         {"gpu", no_argument, 0, 0},
@@ -731,6 +920,11 @@ bool config_parse_args(BlurConfig* config, int argc, char* argv[]) {
         {"codec", required_argument, 0, 0},
         {"bitrate", required_argument, 0, 0},
         {"pixel-format", required_argument, 0, 0},
+        {"encoder-preset", required_argument, 0, 0},
+        {"tune", required_argument, 0, 0},
+        {"throughput", no_argument, 0, 0},
+        {"renditions", required_argument, 0, 0},
+        {"fragment", required_argument, 0, 0},
         {"brightness", required_argument, 0, 0},
         {"saturation", required_argument, 0, 0},
         {"contrast", required_argument, 0, 0},
@@ -794,6 +988,12 @@ bool config_parse_args(BlurConfig* config, int argc, char* argv[]) {
                     config->blur_weighting[sizeof(config->blur_weighting) - 1] = '\0';
                 }
             }
+            else if (strcmp(long_options[option_index].name, "blur-mode") == 0) {
+                if (optarg) {
+                    strncpy(config->blur_mode, optarg, sizeof(config->blur_mode) - 1);
+                    config->blur_mode[sizeof(config->blur_mode) - 1] = '\0';
+                }
+            }
             else if (strcmp(long_options[option_index].name, "custom-weights") == 0) {
                 if (optarg) {
                     char* weights_str = strdup(optarg);
@@ -845,6 +1045,63 @@ bool config_parse_args(BlurConfig* config, int argc, char* argv[]) {
             else if (strcmp(long_options[option_index].name, "interpolation-mask-area") == 0) {
                 if (optarg) config->interpolation_mask_area = (float)atof(optarg);
             }
+            else if (strcmp(long_options[option_index].name, "motion-vectors") == 0) {
+                if (optarg) {
+                    strncpy(config->motion_vectors, optarg, sizeof(config->motion_vectors) - 1);
+                    config->motion_vectors[sizeof(config->motion_vectors) - 1] = '\0';
+                }
+            }
+            else if (strcmp(long_options[option_index].name, "no-fused-interpolation") == 0) {
+                config->fused_interpolation = false;
+            }
+            else if (strcmp(long_options[option_index].name, "cache-dir") == 0) {
+                if (optarg) {
+                    strncpy(config->cache_dir, optarg, sizeof(config->cache_dir) - 1);
+                    config->cache_dir[sizeof(config->cache_dir) - 1] = '\0';
+                }
+            }
+            else if (strcmp(long_options[option_index].name, "proxy-cache") == 0) {
+                if (optarg) {
+                    strncpy(config->proxy_cache, optarg, sizeof(config->proxy_cache) - 1);
+                    config->proxy_cache[sizeof(config->proxy_cache) - 1] = '\0';
+                }
+            }
+            else if (strcmp(long_options[option_index].name, "proxy-scale") == 0) {
+                if (optarg) config->proxy_scale = atoi(optarg);
+            }
+            else if (strcmp(long_options[option_index].name, "read-ahead") == 0) {
+                if (optarg) config->read_ahead_mb = atoi(optarg);
+            }
+            else if (strcmp(long_options[option_index].name, "input-io") == 0) {
+                if (optarg) {
+                    strncpy(config->input_io, optarg, sizeof(config->input_io) - 1);
+                    config->input_io[sizeof(config->input_io) - 1] = '\0';
+                }
+            }
+            else if (strcmp(long_options[option_index].name, "raw-input") == 0) {
+                if (optarg) {
+                    strncpy(config->raw_input, optarg, sizeof(config->raw_input) - 1);
+                    config->raw_input[sizeof(config->raw_input) - 1] = '\0';
+                }
+            }
+            else if (strcmp(long_options[option_index].name, "sequence-fps") == 0) {
+                if (optarg) config->sequence_fps = (float)atof(optarg);
+            }
+            else if (strcmp(long_options[option_index].name, "start") == 0) {
+                if (optarg) config->start_time = parse_time_value(optarg);
+            }
+            else if (strcmp(long_options[option_index].name, "end") == 0) {
+                if (optarg) config->end_time = parse_time_value(optarg);
+            }
+            else if (strcmp(long_options[option_index].name, "index") == 0) {
+                config->packet_index = true;
+            }
+            else if (strcmp(long_options[option_index].name, "output-io") == 0) {
+                if (optarg) {
+                    strncpy(config->output_io, optarg, sizeof(config->output_io) - 1);
+                    config->output_io[sizeof(config->output_io) - 1] = '\0';
+                }
+            }
             else if (strcmp(long_options[option_index].name, "pre-interpolation") == 0) {
                 config->pre_interpolation = true;
             }
@@ -917,6 +1174,30 @@ bool config_parse_args(BlurConfig* config, int argc, char* argv[]) {
                     config->pixel_format[sizeof(config->pixel_format) - 1] = '\0';
                 }
             }
+            else if (strcmp(long_options[option_index].name, "encoder-preset") == 0) {
+                if (optarg) {
+                    strncpy(config->encoder_preset, optarg, sizeof(config->encoder_preset) - 1);
+                    config->encoder_preset[sizeof(config->encoder_preset) - 1] = '\0';
+                }
+            }
+            else if (strcmp(long_options[option_index].name, "tune") == 0) {
+                if (optarg) {
+                    strncpy(config->encoder_tune, optarg, sizeof(config->encoder_tune) - 1);
+                    config->encoder_tune[sizeof(config->encoder_tune) - 1] = '\0';
+                }
+            }
+            else if (strcmp(long_options[option_index].name, "throughput") == 0) {
+                config->throughput = true;
+            }
+            else if (strcmp(long_options[option_index].name, "renditions") == 0) {
+                if (optarg) {
+                    strncpy(config->renditions, optarg, sizeof(config->renditions) - 1);
+                    config->renditions[sizeof(config->renditions) - 1] = '\0';
+                }
+            }
+            else if (strcmp(long_options[option_index].name, "fragment") == 0) {
+                if (optarg) config->fragment_duration = (float)atof(optarg);
+            }
             else if (strcmp(long_options[option_index].name, "brightness") == 0) {
                 if (optarg) config->brightness = (float)atof(optarg);
             }
@@ -993,6 +1274,10 @@ bool config_parse_args(BlurConfig* config, int argc, char* argv[]) {
         return false;
     }
 
+    for (int i = 0; i < config->job_count; i++) {
+        inherit_shared_settings(&config->jobs[i], config);
+    }
+
     return true;
 }
 
@@ -1000,7 +1285,38 @@ void config_print(const BlurConfig* config) {
     printf("Motion Blur Configuration:\n");
     printf("=========================\n");
     printf("Input file: %s\n", config->input_file);
+    if (strcmp(config->input_io, "default") != 0) {
+        printf("Input I/O: %s\n", config->input_io);
+    }
+    if (strcmp(config->raw_input, "auto") != 0) {
+        printf("Raw input: %s\n", config->raw_input);
+    }
+    if (strchr(config->input_file, '%')) {
+        printf("Image sequence: %.3f fps\n", config->sequence_fps);
+    }
+    if (config->start_time > 0 || config->end_time > 0) {
+        if (config->end_time > 0) {
+            printf("Range: %.3f s - %.3f s\n", config->start_time, config->end_time);
+        }
+        else {
+            printf("Range: %.3f s - end\n", config->start_time);
+        }
+    }
+    if (config->packet_index) {
+        printf("Packet index: %s\n", strlen(config->cache_dir) > 0 ? config->cache_dir : "next to input");
+    }
     printf("Output file: %s\n", config->output_file);
+    if (strcmp(config->output_io, "default") != 0) {
+        printf("Output I/O: %s\n", config->output_io);
+    }
+    if (strlen(config->proxy_cache) > 0) {
+        printf("Proxy cache: %s (1/%d scale)\n", config->proxy_cache, config->proxy_scale);
+    }
+    for (int i = 0; i < config->job_count; i++) {
+        const BlurConfig* job = &config->jobs[i];
+        printf("Render job %d: %s (%s blur %.2f, %s, %s)\n", i + 1, job->output_file,
+            job->blur_mode, job->blur_amount, job->blur_output_fps, job->codec);
+    }
     printf("\n");
 
     printf("Blur Settings:\n");
@@ -1008,6 +1324,7 @@ void config_print(const BlurConfig* config) {
     printf("  Amount: %.2f\n", config->blur_amount);
     printf("  Output FPS: %s\n", config->blur_output_fps);
     printf("  Weighting: %s\n", config->blur_weighting);
+    printf("  Mode: %s\n", config->blur_mode);
     if (config->custom_weights && config->custom_weights_count > 0) {
         printf("  Custom weights (%d): ", config->custom_weights_count);
         for (int i = 0; i < config->custom_weights_count; i++) {
@@ -1024,6 +1341,11 @@ void config_print(const BlurConfig* config) {
         printf("  Method: %s\n", config->interpolation_method);
         printf("  Block size: %d\n", config->interpolation_block_size);
         printf("  Mask area: %.2f\n", config->interpolation_mask_area);
+        printf("  Motion vectors: %s\n", config->motion_vectors);
+        printf("  Fused with blur: %s\n", config->fused_interpolation ? "yes" : "no");
+        if (strlen(config->cache_dir) > 0) {
+            printf("  Motion cache: %s\n", config->cache_dir);
+        }
         printf("  Pre-interpolation: %s\n", config->pre_interpolation ? "yes" : "no");
         if (config->pre_interpolation) {
             printf("  Pre-interpolated FPS: %s\n", config->pre_interpolated_fps);
@@ -1039,6 +1361,21 @@ void config_print(const BlurConfig* config) {
         printf("  Bitrate: %d kbps\n", config->bitrate);
     }
     printf("  Pixel format: %s\n", config->pixel_format);
+    if (strlen(config->encoder_preset) > 0) {
+        printf("  Encoder preset: %s\n", config->encoder_preset);
+    }
+    if (strlen(config->encoder_tune) > 0) {
+        printf("  Encoder tune: %s\n", config->encoder_tune);
+    }
+    if (config->throughput) {
+        printf("  Throughput mode: yes\n");
+    }
+    if (strlen(config->renditions) > 0) {
+        printf("  Renditions: %s\n", config->renditions);
+    }
+    if (config->fragment_duration > 0) {
+        printf("  Fragment duration: %.2f s\n", config->fragment_duration);
+    }
     printf("\n");
 
     printf("GPU Acceleration:\n");
@@ -1087,17 +1424,65 @@ void config_print(const BlurConfig* config) {
     printf("\n");
 }
 
+static bool is_valid_encoder_tune(const char* codec, const char* tune) {
+    static const char* x264_tunes[] = { "film", "animation", "grain", "stillimage", "fastdecode", "zerolatency", "psnr", "ssim" };
+    static const char* x265_tunes[] = { "animation", "grain", "fastdecode", "zerolatency", "psnr", "ssim" };
+    static const char* metric_tunes[] = { "psnr", "ssim" };
+    static const char* svt_tunes[] = { "vq", "psnr", "ssim" };
+    const char** tunes = x264_tunes;
+    int count = (int)(sizeof(x264_tunes) / sizeof(x264_tunes[0]));
+
+    if (strcmp(codec, "h265") == 0 || strcmp(codec, "hevc") == 0) {
+        tunes = x265_tunes;
+        count = (int)(sizeof(x265_tunes) / sizeof(x265_tunes[0]));
+    }
+    else if (strcmp(codec, "av1") == 0) {
+        tunes = svt_tunes;
+        count = (int)(sizeof(svt_tunes) / sizeof(svt_tunes[0]));
+    }
+    else if (strcmp(codec, "vp9") == 0) {
+        tunes = metric_tunes;
+        count = (int)(sizeof(metric_tunes) / sizeof(metric_tunes[0]));
+    }
+
+    for (int i = 0; i < count; i++) {
+        if (strcmp(tune, tunes[i]) == 0) return true;
+    }
+    return false;
+}
+
 bool config_validate(const BlurConfig* config) {
     if (strlen(config->input_file) == 0) {
         fprintf(stderr, "Error: Input file not specified\n");
         return false;
     }
 
-    if (access(config->input_file, 0) != 0) {
+    bool pipe_input = strcmp(config->input_file, "-") == 0;
+    bool pipe_output = strcmp(config->output_file, "-") == 0;
+
+    bool sequence_input = strchr(config->input_file, '%') != NULL;
+
+    if (!pipe_input && !sequence_input && access(config->input_file, 0) != 0) {
         fprintf(stderr, "Error: Input file does not exist: %s\n", config->input_file);
         return false;
     }
 
+    if (pipe_input && (strlen(config->proxy_cache) > 0 || strlen(config->cache_dir) > 0 ||
+        strcmp(config->input_io, "default") != 0 || config->packet_index)) {
+        fprintf(stderr, "Error: --proxy-cache, --cache-dir, --input-io and --index need a file input, not stdin\n");
+        return false;
+    }
+
+    if (pipe_output && (strcmp(config->output_io, "default") != 0 || strlen(config->renditions) > 0)) {
+        fprintf(stderr, "Error: --output-io and --renditions need a file output, not stdout\n");
+        return false;
+    }
+
+    if (pipe_output && strcmp(config->container, "avi") == 0) {
+        fprintf(stderr, "Error: AVI cannot be streamed to stdout (use mkv, nut or mp4)\n");
+        return false;
+    }
+
     if (strlen(config->output_file) == 0) {
         fprintf(stderr, "Error: Output file not specified\n");
         return false;
@@ -1119,6 +1504,124 @@ bool config_validate(const BlurConfig* config) {
         return false;
     }
 
+    if (config->proxy_scale != 1 && config->proxy_scale != 2 &&
+        config->proxy_scale != 4 && config->proxy_scale != 8) {
+        fprintf(stderr, "Error: Proxy scale must be 1, 2, 4, or 8\n");
+        return false;
+    }
+
+    if (config->read_ahead_mb < 1 || config->read_ahead_mb > 4096) {
+        fprintf(stderr, "Error: Read-ahead must be between 1 and 4096 MB\n");
+        return false;
+    }
+
+    if (strcmp(config->input_io, "default") != 0 && strcmp(config->input_io, "buffered") != 0 &&
+        strcmp(config->input_io, "mmap") != 0) {
+        fprintf(stderr, "Error: Invalid input I/O mode: %s (must be 'default', 'buffered' or 'mmap')\n",
+            config->input_io);
+        return false;
+    }
+
+    int raw_width = 0;
+    int raw_height = 0;
+    char raw_fps[16] = "";
+    bool raw_frames = strcmp(config->raw_input, "y4m") == 0;
+    if (!raw_frames && strcmp(config->raw_input, "auto") != 0 && strcmp(config->raw_input, "ffmpeg") != 0) {
+        raw_frames = sscanf(config->raw_input, "%dx%d@%15s", &raw_width, &raw_height, raw_fps) == 3;
+        if (!raw_frames || raw_width < 2 || raw_height < 2 || atof(raw_fps) <= 0) {
+            fprintf(stderr, "Error: Invalid raw input: %s (must be 'auto', 'ffmpeg', 'y4m' or WxH@FPS)\n",
+                config->raw_input);
+            return false;
+        }
+    }
+
+    if (config->sequence_fps < 1 || config->sequence_fps > 1000) {
+        fprintf(stderr, "Error: Sequence fps must be between 1 and 1000\n");
+        return false;
+    }
+
+    if (raw_frames && (strcmp(config->input_io, "default") != 0 || strlen(config->proxy_cache) > 0)) {
+        fprintf(stderr, "Error: --input-io and --proxy-cache do not apply to --raw-input, frames are mapped directly\n");
+        return false;
+    }
+
+    if (config->start_time < 0 || config->end_time < 0) {
+        fprintf(stderr, "Error: Start and end times must be seconds or HH:MM:SS\n");
+        return false;
+    }
+
+    if (config->end_time > 0 && config->end_time <= config->start_time) {
+        fprintf(stderr, "Error: End time must be after start time\n");
+        return false;
+    }
+
+    if ((config->start_time > 0 || config->end_time > 0) &&
+        (raw_frames || strchr(config->input_file, '%') || strlen(config->proxy_cache) > 0)) {
+        fprintf(stderr, "Error: --start and --end need a seekable container, not raw, image sequence or proxy input\n");
+        return false;
+    }
+
+    if (strcmp(config->output_io, "default") != 0 && strcmp(config->output_io, "writeback") != 0) {
+        fprintf(stderr, "Error: Invalid output I/O mode: %s (must be 'default' or 'writeback')\n",
+            config->output_io);
+        return false;
+    }
+
+    if (config->fragment_duration != 0 && (config->fragment_duration < 0.1f || config->fragment_duration > 600)) {
+        fprintf(stderr, "Error: Fragment duration must be between 0.1 and 600 seconds\n");
+        return false;
+    }
+
+    if (config->fragment_duration > 0 && !strstr(config->output_file, ".mp4") &&
+        !strstr(config->output_file, ".mov") && !strstr(config->output_file, ".m3u8") &&
+        !(pipe_output && (strcmp(config->container, "mp4") == 0 || strcmp(config->container, "mov") == 0))) {
+        fprintf(stderr, "Error: Fragmented output requires an .mp4, .mov or .m3u8 output file\n");
+        return false;
+    }
+
+    if (strlen(config->renditions) > 0 && (strstr(config->output_file, ".y4m") || strstr(config->output_file, ".yuv") ||
+        strncmp(config->output_file, "shm:", 4) == 0 ||
+        strcmp(config->container, "y4m") == 0 || strcmp(config->container, "rawvideo") == 0)) {
+        fprintf(stderr, "Error: Renditions need an encoded output, not y4m/rawvideo/shm\n");
+        return false;
+    }
+
+    if (strchr(config->output_file, '%') && ((!strstr(config->output_file, ".png") &&
+        !strstr(config->output_file, ".tif")) || strlen(config->renditions) > 0 ||
+        strcmp(config->output_io, "default") != 0)) {
+        fprintf(stderr, "Error: Image sequence output must be a .png or .tif pattern like frame_%%05d.png, "
+            "without --renditions or --output-io\n");
+        return false;
+    }
+
+    if (strncmp(config->output_file, "shm:", 4) == 0 && (strlen(config->output_file) == 4 ||
+        strchr(config->output_file + 4, '/') || strchr(config->output_file + 4, '\\') ||
+        strcmp(config->output_io, "default") != 0)) {
+        fprintf(stderr, "Error: Shared memory output needs a plain name (shm:NAME) and no --output-io\n");
+        return false;
+    }
+
+    if (strlen(config->renditions) > 0) {
+        const char* cursor = config->renditions;
+        int count = 0;
+        while (*cursor) {
+            char* end;
+            long height = strtol(cursor, &end, 10);
+            if (end == cursor || height < 144 || height > 4320 || (*end != ',' && *end != '\0')) {
+                fprintf(stderr, "Error: Invalid renditions list: %s (expected heights such as 1440,1080,720)\n",
+                    config->renditions);
+                return false;
+            }
+            count++;
+            cursor = *end == ',' ? end + 1 : end;
+        }
+
+        if (count > 8) {
+            fprintf(stderr, "Error: At most 8 renditions are supported\n");
+            return false;
+        }
+    }
+
     if (config->interpolation_mask_area < 0 || config->interpolation_mask_area > 1) {
         fprintf(stderr, "Error: Interpolation mask area must be between 0 and 1\n");
         return false;
@@ -1170,23 +1673,41 @@ bool config_validate(const BlurConfig* config) {
         return false;
     }
 
+    if (strcmp(config->blur_mode, "frames") != 0 && strcmp(config->blur_mode, "vector") != 0) {
+        fprintf(stderr, "Error: Invalid blur mode: %s (must be 'frames' or 'vector')\n", config->blur_mode);
+        return false;
+    }
+
     if (strcmp(config->blur_weighting, "custom") == 0 &&
         (!config->custom_weights || config->custom_weights_count <= 0)) {
         fprintf(stderr, "Error: Custom weighting selected but no weights provided\n");
         return false;
     }
 
-    if (strcmp(config->interpolation_method, "rife") != 0 &&
+    if (strcmp(config->interpolation_method, "native") != 0 &&
+        strcmp(config->interpolation_method, "blend") != 0 &&
+        strcmp(config->interpolation_method, "rife") != 0 &&
         strcmp(config->interpolation_method, "svp") != 0) {
-        fprintf(stderr, "Error: Invalid interpolation method: %s (must be 'rife' or 'svp')\n",
+        fprintf(stderr, "Error: Invalid interpolation method: %s (must be 'native', 'blend', 'rife' or 'svp')\n",
             config->interpolation_method);
         return false;
     }
 
+    if (strcmp(config->motion_vectors, "search") != 0 &&
+        strcmp(config->motion_vectors, "decoder") != 0 &&
+        strcmp(config->motion_vectors, "hybrid") != 0) {
+        fprintf(stderr, "Error: Invalid motion vector mode: %s (must be 'search', 'decoder' or 'hybrid')\n",
+            config->motion_vectors);
+        return false;
+    }
+
     if (strcmp(config->container, "mp4") != 0 &&
         strcmp(config->container, "mkv") != 0 &&
         strcmp(config->container, "avi") != 0 &&
-        strcmp(config->container, "mov") != 0) {
+        strcmp(config->container, "mov") != 0 &&
+        strcmp(config->container, "nut") != 0 &&
+        strcmp(config->container, "y4m") != 0 &&
+        strcmp(config->container, "rawvideo") != 0) {
         fprintf(stderr, "Error: Invalid container format: %s\n", config->container);
         return false;
     }
@@ -1200,6 +1721,25 @@ bool config_validate(const BlurConfig* config) {
         return false;
     }
 
+    if (strlen(config->encoder_preset) > 0 &&
+        strcmp(config->encoder_preset, "ultrafast") != 0 &&
+        strcmp(config->encoder_preset, "superfast") != 0 &&
+        strcmp(config->encoder_preset, "veryfast") != 0 &&
+        strcmp(config->encoder_preset, "faster") != 0 &&
+        strcmp(config->encoder_preset, "fast") != 0 &&
+        strcmp(config->encoder_preset, "medium") != 0 &&
+        strcmp(config->encoder_preset, "slow") != 0 &&
+        strcmp(config->encoder_preset, "slower") != 0 &&
+        strcmp(config->encoder_preset, "veryslow") != 0) {
+        fprintf(stderr, "Error: Invalid encoder preset: %s (ultrafast ... veryslow)\n", config->encoder_preset);
+        return false;
+    }
+
+    if (strlen(config->encoder_tune) > 0 && !is_valid_encoder_tune(config->codec, config->encoder_tune)) {
+        fprintf(stderr, "Error: Encoder tune '%s' is not supported for codec %s\n", config->encoder_tune, config->codec);
+        return false;
+    }
+
     if (strcmp(config->gpu_type, "nvidia") != 0 &&
         strcmp(config->gpu_type, "amd") != 0 &&
         strcmp(config->gpu_type, "intel") != 0) {
@@ -1208,6 +1748,37 @@ bool config_validate(const BlurConfig* config) {
         return false;
     }
 
+    for (int i = 0; i < config->job_count; i++) {
+        const BlurConfig* job = &config->jobs[i];
+        if (strlen(job->output_file) == 0) {
+            fprintf(stderr, "Error: Render job %d has no output_file\n", i + 1);
+            return false;
+        }
+
+        if (strcmp(job->output_file, "-") == 0) {
+            fprintf(stderr, "Error: Render job %d cannot write to stdout; only the main output can\n", i + 1);
+            return false;
+        }
+
+        if (strcmp(job->output_file, config->output_file) == 0) {
+            fprintf(stderr, "Error: Render job %d writes to the main output file: %s\n", i + 1, job->output_file);
+            return false;
+        }
+
+        for (int j = 0; j < i; j++) {
+            if (strcmp(job->output_file, config->jobs[j].output_file) == 0) {
+                fprintf(stderr, "Error: Render jobs %d and %d write to the same file: %s\n",
+                    j + 1, i + 1, job->output_file);
+                return false;
+            }
+        }
+
+        if (!config_validate(job)) {
+            fprintf(stderr, "Error: Render job %d is invalid\n", i + 1);
+            return false;
+        }
+    }
+
     return true;
 }
 
@@ -1312,13 +1883,7 @@ static float* generate_linear_weights(int count, bool ascending) {
     return weights;
 }
 
-float* config_get_weights(const BlurConfig* config, int frame_count, int* weight_count) {
-    if (!config || frame_count <= 0 || !weight_count) {
-        return NULL;
-    }
-
-    *weight_count = frame_count;
-
+static float* generate_weights(const BlurConfig* config, int frame_count) {
     if (config->custom_weights && config->custom_weights_count == frame_count) {
         float* weights = (float*)malloc(frame_count * sizeof(float));
         if (!weights) return NULL;
@@ -1364,4 +1929,44 @@ float* config_get_weights(const BlurConfig* config, int frame_count, int* weight
     }
 
     return generate_equal_weights(frame_count);
+}
+
+static float* fold_blend_weights(const float* weights, int frame_count, int interpolation_factor, int* weight_count) {
+    int real_count = (frame_count - 1 + interpolation_factor - 1) / interpolation_factor + 1;
+    float* folded = (float*)calloc(real_count, sizeof(float));
+    if (!folded) return NULL;
+
+    for (int i = 0; i < frame_count; i++) {
+        int distance = frame_count - 1 - i;
+        int newer = real_count - 1 - distance / interpolation_factor;
+        int phase = distance % interpolation_factor;
+
+        if (phase == 0) {
+            folded[newer] += weights[i];
+        }
+        else {
+            float t = (float)(interpolation_factor - phase) / interpolation_factor;
+            folded[newer] += weights[i] * t;
+            folded[newer - 1] += weights[i] * (1.0f - t);
+        }
+    }
+
+    *weight_count = real_count;
+    return folded;
+}
+
+float* config_get_weights(const BlurConfig* config, int frame_count, int interpolation_factor, int* weight_count) {
+    if (!config || frame_count <= 0 || !weight_count) {
+        return NULL;
+    }
+
+    float* weights = generate_weights(config, frame_count);
+    *weight_count = frame_count;
+    if (!weights || interpolation_factor <= 1 || strcmp(config->interpolation_method, "blend") != 0) {
+        return weights;
+    }
+
+    float* folded = fold_blend_weights(weights, frame_count, interpolation_factor, weight_count);
+    free(weights);
+    return folded;
 }
\ No newline at end of file
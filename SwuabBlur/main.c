@@ -37,11 +37,12 @@ typedef HANDLE pthread_t;
 #include <vapoursynth/VSHelper.h>
 #endif
 
-typedef struct {
+typedef struct BlurConfig {
     bool blur;
     float blur_amount;
     char blur_output_fps[32];
     char blur_weighting[32];
+    char blur_mode[16];
     float* custom_weights;
     int custom_weights_count;
     bool interpolate;
@@ -49,6 +50,19 @@ typedef struct {
     char interpolation_method[32];
     int interpolation_block_size;
     float interpolation_mask_area;
+    char motion_vectors[32];
+    bool fused_interpolation;
+    char cache_dir[512];
+    char proxy_cache[512];
+    int proxy_scale;
+    int read_ahead_mb;
+    char input_io[16];
+    char raw_input[32];
+    float sequence_fps;
+    float start_time;
+    float end_time;
+    bool packet_index;
+    char output_io[16];
     bool pre_interpolation;
     char pre_interpolated_fps[32];
     int quality;
@@ -75,12 +89,19 @@ typedef struct {
     char codec[32];
     int bitrate;
     char pixel_format[32];
+    char encoder_preset[16];
+    char encoder_tune[16];
+    bool throughput;
+    char renditions[64];
+    float fragment_duration;
     int threads;
     bool verbose;
     bool debug;
     float timescale;
     bool pitch_correction;
     char ffmpeg_filters[1024];
+    struct BlurConfig* jobs;
+    int job_count;
 } BlurConfig;
 
 extern BlurConfig* config_create(void);
@@ -89,10 +110,11 @@ extern bool config_load_file(BlurConfig* config, const char* filename);
 extern bool config_parse_args(BlurConfig* config, int argc, char* argv[]);
 extern void config_print(const BlurConfig* config);
 extern bool config_validate(const BlurConfig* config);
-extern float* config_get_weights(const BlurConfig* config, int frame_count, int* weight_count);
+extern float* config_get_weights(const BlurConfig* config, int frame_count, int interpolation_factor,
+    int* weight_count);
 
 extern bool video_process(const BlurConfig* config);
-extern bool video_get_info(const char* filename, int* width, int* height, double* fps, int64_t* frame_count);
+extern bool video_get_info(const BlurConfig* config, int* width, int* height, double* fps, int64_t* frame_count);
 extern void video_cleanup(void);
 
 static volatile bool g_interrupted = false;
@@ -169,7 +191,8 @@ static void print_progress(int64_t current, int64_t total) {
 
 static void print_usage(const char* program) {
     printf("Motion Blur Video Processing Application\n");
-    printf("Usage: %s [options] input_file\n\n", program);
+    printf("Usage: %s [options] input_file\n", program);
+    printf("Use - as input_file or output file to read from stdin or stream to stdout.\n\n");
 
     printf("Options:\n");
     printf("  -h, --help                    Show this help message\n");
@@ -178,9 +201,24 @@ static void print_usage(const char* program) {
     printf("  --blur-amount FLOAT           Motion blur intensity (0-1+, default: 1.0)\n");
     printf("  --blur-output-fps FPS         Output framerate (number or multiplier like 5x)\n");
     printf("  --blur-weighting METHOD       Weighting function (gaussian_sym, equal, vegas, etc.)\n");
+    printf("  --blur-mode MODE              Blur source (frames, vector)\n");
     printf("  --interpolate                 Enable frame interpolation\n");
     printf("  --interpolated-fps FPS        Target interpolation framerate\n");
-    printf("  --interpolation-method METHOD Interpolation algorithm (rife, svp)\n");
+    printf("  --interpolation-method METHOD Interpolation algorithm (native, blend, rife, svp)\n");
+    printf("  --interpolation-block-size N  Motion search block size (4, 8, 16, 32)\n");
+    printf("  --motion-vectors MODE         Motion source (search, decoder, hybrid)\n");
+    printf("  --no-fused-interpolation      Store interpolated frames instead of blending them directly\n");
+    printf("  --cache-dir DIR               Reuse motion vector fields across runs of the same input\n");
+    printf("  --proxy-cache DIR             Store decoded frames and reuse them on later runs\n");
+    printf("  --proxy-scale N               Downscale proxy frames by N (1, 2, 4, 8)\n");
+    printf("  --read-ahead MB               Demux read-ahead buffer size (default: 64)\n");
+    printf("  --input-io MODE               Input reads: default, buffered (4 MB async prefetch), mmap\n");
+    printf("  --raw-input FMT               Native raw reader: auto (.y4m files), ffmpeg, y4m, or WxH@FPS for yuv420p\n");
+    printf("  --sequence-fps FPS            Frame rate of an image sequence input like img_%%05d.png (default: 25)\n");
+    printf("  --start TIME                  Start of the range to render, seconds or HH:MM:SS\n");
+    printf("  --end TIME                    End of the range to render, seconds or HH:MM:SS\n");
+    printf("  --index                       Keep a packet index (.swbidx) for exact frame counts and keyframe seeks\n");
+    printf("  --output-io MODE              Output writes: default, writeback (4 MB blocks on a writer thread)\n");
     printf("  --gpu                         Enable GPU acceleration\n");
     printf("  --gpu-type TYPE               GPU vendor (nvidia, amd, intel)\n");
     printf("  --quality CRF                 Video quality (0-51, default: 20)\n");
@@ -189,9 +227,14 @@ static void print_usage(const char* program) {
     printf("  --verbose                     Enable verbose logging\n");
     printf("  --debug                       Enable debug mode\n");
     printf("  --threads N                   Number of processing threads\n");
-    printf("  --container FORMAT            Output container (mp4, mkv, avi)\n");
+    printf("  --container FORMAT            Output container (mp4, mkv, avi, mov, nut, y4m, rawvideo)\n");
     printf("  --codec CODEC                 Video codec (h264, h265, av1)\n");
     printf("  --bitrate KBPS                Target bitrate in kilobits/sec\n");
+    printf("  --encoder-preset NAME         Encoder speed preset (ultrafast ... veryslow)\n");
+    printf("  --tune NAME                   Encoder tune (film, animation, grain, fastdecode, zerolatency, psnr, ssim)\n");
+    printf("  --throughput                  Favour encode speed: frame threads and threaded lookahead\n");
+    printf("  --renditions LIST             Also encode scaled copies at these heights (e.g. 1440,1080,720)\n");
+    printf("  --fragment SEC                Write fragmented MP4 (or HLS fMP4 segments for .m3u8) every SEC seconds\n");
     printf("  --brightness FLOAT            Brightness adjustment (-1 to 1)\n");
     printf("  --saturation FLOAT            Saturation adjustment (-1 to 1)\n");
     printf("  --contrast FLOAT              Contrast adjustment (-1 to 1)\n");
@@ -218,15 +261,47 @@ static void print_usage(const char* program) {
     printf("  smooth         - High blur for maximum smoothness\n");
     printf("\n");
 
+    printf("Render jobs:\n");
+    printf("  A config file may list extra outputs in a \"jobs\" array. Each entry needs an\n");
+    printf("  \"output_file\" and may override blur, interpolation and encoder settings; the\n");
+    printf("  input is decoded once and shared by every job.\n");
+    printf("\n");
+
+    printf("Image sequence output:\n");
+    printf("  -o shots/frame_%%05d.png (or .tif) writes one RGB image per output frame,\n");
+    printf("  numbered from 1 and encoded on --threads workers.\n");
+    printf("\n");
+
+    printf("Shared memory output:\n");
+    printf("  -o shm:NAME publishes blended frames to a ring of 8 slots in /dev/shm/NAME\n");
+    printf("  instead of encoding. The header gives geometry, plane offsets and rates; each\n");
+    printf("  slot has a ready flag (futex on Linux) that the consumer clears to free it.\n");
+    printf("  The writer blocks while the ring is full. The consumer unlinks the segment.\n");
+    printf("\n");
+
     printf("Examples:\n");
     printf("  %s -o output.mp4 --blur-amount 1.0 input.mp4\n", program);
     printf("  %s -o smooth.mp4 --interpolate --interpolated-fps 5x --gpu input.mp4\n", program);
     printf("  %s -c config.json -o result.mp4 gameplay.mp4\n", program);
     printf("  %s --preset gaming -o gameplay_blur.mp4 --gpu recording.mp4\n", program);
+    printf("  ffmpeg -i in.mp4 -f nut - | %s --container mkv -o - - | uploader\n", program);
+}
+
+static void remove_outputs(const BlurConfig* config) {
+    if (strncmp(config->output_file, "pipe:", 5) != 0 && strncmp(config->output_file, "shm:", 4) != 0) {
+        remove(config->output_file);
+    }
+    for (int i = 0; i < config->job_count; i++) {
+        if (strncmp(config->jobs[i].output_file, "shm:", 4) != 0) {
+            remove(config->jobs[i].output_file);
+        }
+    }
 }
 
 static bool validate_output_path(const char* path) {
     if (!path || strlen(path) == 0) return false;
+    if (strcmp(path, "-") == 0) return true;
+    if (strncmp(path, "shm:", 4) == 0) return true;
 
     char* dir_sep = strrchr(path, '/');
     if (!dir_sep) dir_sep = strrchr(path, '\\');
@@ -263,15 +338,38 @@ static bool validate_output_path(const char* path) {
     return true;
 }
 
+static bool open_stdout_output(BlurConfig* config) {
+    fflush(stdout);
+
+#ifdef _WIN32
+    int fd = _dup(_fileno(stdout));
+    if (fd < 0 || _dup2(_fileno(stderr), _fileno(stdout)) != 0) {
+#else
+    signal(SIGPIPE, SIG_IGN);
+    int fd = dup(STDOUT_FILENO);
+    if (fd < 0 || dup2(STDERR_FILENO, STDOUT_FILENO) < 0) {
+#endif
+        fprintf(stderr, "Error: Cannot redirect stdout for streaming output\n");
+        return false;
+    }
+
+    snprintf(config->output_file, sizeof(config->output_file), "pipe:%d", fd);
+    return true;
+}
+
 static void print_summary(const BlurConfig* config) {
     printf("\nProcessing Configuration:\n");
     printf("------------------------\n");
     printf("Input:  %s\n", config->input_file);
     printf("Output: %s\n", config->output_file);
+    for (int i = 0; i < config->job_count; i++) {
+        printf("Job %d:  %s (%.2f blur, %s mode)\n", i + 1, config->jobs[i].output_file,
+            config->jobs[i].blur_amount, config->jobs[i].blur_mode);
+    }
 
     if (config->blur) {
-        printf("Blur:   %.2f amount, %s weighting\n",
-            config->blur_amount, config->blur_weighting);
+        printf("Blur:   %.2f amount, %s weighting, %s mode\n",
+            config->blur_amount, config->blur_weighting, config->blur_mode);
     }
 
     if (config->interpolate) {
@@ -294,7 +392,7 @@ static void print_version(void) {
     printf("Copyright (c) 2024 SwuabBlur Contributors\n");
     printf("\nSupported features:\n");
     printf("  - Motion blur with multiple weighting functions\n");
-    printf("  - Frame interpolation (RIFE, SVP)\n");
+    printf("  - Frame interpolation (native block matching, linear blend, RIFE, SVP)\n");
     printf("  - GPU acceleration (NVIDIA, AMD, Intel)\n");
     printf("  - Duplicate frame detection\n");
     printf("  - Custom FFmpeg filter chains\n");
@@ -373,11 +471,23 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
+    for (int i = 0; i < config->job_count; i++) {
+        if (!validate_output_path(config->jobs[i].output_file)) {
+            config_destroy(config);
+            return 1;
+        }
+    }
+
     if (!config_validate(config)) {
         config_destroy(config);
         return 1;
     }
 
+    if (strcmp(config->output_file, "-") == 0 && !open_stdout_output(config)) {
+        config_destroy(config);
+        return 1;
+    }
+
     if (config->verbose) {
         config_print(config);
     }
@@ -387,7 +497,7 @@ int main(int argc, char* argv[]) {
     double fps;
     int64_t frame_count;
 
-    if (!video_get_info(config->input_file, &width, &height, &fps, &frame_count)) {
+    if (!video_get_info(config, &width, &height, &fps, &frame_count)) {
         fprintf(stderr, "Error: Failed to analyze input video\n");
         config_destroy(config);
         return 1;
@@ -407,7 +517,7 @@ int main(int argc, char* argv[]) {
 
     if (g_interrupted) {
         fprintf(stderr, "\nProcessing interrupted by user\n");
-        remove(config->output_file);
+        remove_outputs(config);
     }
     else if (success) {
         fprintf(stderr, "\nProcessing completed successfully\n");
@@ -426,7 +536,7 @@ int main(int argc, char* argv[]) {
     }
     else {
         fprintf(stderr, "\nProcessing failed\n");
-        remove(config->output_file);
+        remove_outputs(config);
     }
 
     video_cleanup();
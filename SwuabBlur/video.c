@@ -4,6 +4,8 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <math.h>
+#include <stdarg.h>
+#include <errno.h>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -12,9 +14,23 @@ typedef HANDLE pthread_mutex_t;
 typedef HANDLE pthread_cond_t;
 #define THREAD_FUNC DWORD WINAPI
 #define THREAD_RETURN DWORD
+#include <direct.h>
+#include <io.h>
+#include <fcntl.h>
+#include <malloc.h>
+#include <sys/stat.h>
 #else
 #include <pthread.h>
 #include <dlfcn.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
 #define THREAD_FUNC void*
 #define THREAD_RETURN void*
 #endif
@@ -29,10 +45,23 @@ typedef HANDLE pthread_cond_t;
 #include <libavfilter/buffersink.h>
 #include <libavfilter/buffersrc.h>
 #include <libavutil/hwcontext.h>
+#include <libavutil/motion_vector.h>
+#include <libavutil/time.h>
+#include <libavutil/parseutils.h>
 
 #ifdef HAVE_VAPOURSYNTH
 #include <vapoursynth/VapourSynth.h>
 #include <vapoursynth/VSHelper.h>
+#include <vapoursynth/VSScript.h>
+#endif
+
+#ifdef HAVE_LIBURING
+#include <liburing.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define HAVE_SSE2 1
 #endif
 
 #ifndef CLAMP
@@ -43,11 +72,12 @@ typedef HANDLE pthread_cond_t;
 #define M_PI 3.14159265358979323846
 #endif
 
-typedef struct {
+typedef struct BlurConfig {
     bool blur;
     float blur_amount;
     char blur_output_fps[32];
     char blur_weighting[32];
+    char blur_mode[16];
     float* custom_weights;
     int custom_weights_count;
     bool interpolate;
@@ -55,6 +85,19 @@ typedef struct {
     char interpolation_method[32];
     int interpolation_block_size;
     float interpolation_mask_area;
+    char motion_vectors[32];
+    bool fused_interpolation;
+    char cache_dir[512];
+    char proxy_cache[512];
+    int proxy_scale;
+    int read_ahead_mb;
+    char input_io[16];
+    char raw_input[32];
+    float sequence_fps;
+    float start_time;
+    float end_time;
+    bool packet_index;
+    char output_io[16];
     bool pre_interpolation;
     char pre_interpolated_fps[32];
     int quality;
@@ -81,14 +124,30 @@ typedef struct {
     char codec[32];
     int bitrate;
     char pixel_format[32];
+    char encoder_preset[16];
+    char encoder_tune[16];
+    bool throughput;
+    char renditions[64];
+    float fragment_duration;
     int threads;
     bool verbose;
     bool debug;
     float timescale;
     bool pitch_correction;
     char ffmpeg_filters[1024];
+    struct BlurConfig* jobs;
+    int job_count;
 } BlurConfig;
 
+typedef struct InputIO InputIO;
+typedef struct OutputIO OutputIO;
+typedef struct RawSink RawSink;
+typedef struct RawSource RawSource;
+typedef struct ShmSink ShmSink;
+typedef struct ImageSequence ImageSequence;
+typedef struct ImageSink ImageSink;
+typedef struct PacketIndex PacketIndex;
+
 typedef struct {
     AVFormatContext* fmt_ctx;
     AVCodecContext* codec_ctx;
@@ -100,6 +159,15 @@ typedef struct {
     AVPacket* packet;
     struct SwsContext* sws_ctx;
     AVBufferRef* hw_device_ctx;
+    InputIO* input_io;
+    OutputIO* output_io;
+    RawSink* raw_sink;
+    ShmSink* shm_sink;
+    ImageSink* image_sink;
+    RawSource* raw_source;
+    ImageSequence* image_sequence;
+    PacketIndex* packet_index;
+    int64_t next_pts;
 } VideoContext;
 
 #ifdef HAVE_VAPOURSYNTH
@@ -112,14 +180,27 @@ typedef struct {
 } VapourSynthContext;
 #endif
 
+#define MOTION_VECTOR_INVALID INT16_MIN
+
+typedef struct {
+    int16_t x;
+    int16_t y;
+} BlockVector;
+
 typedef struct {
     uint8_t** data;
     int* linesize;
     int width;
     int height;
     int64_t pts;
+    int64_t sequence;
     int format;
     bool allocated;
+    BlockVector* motion;
+    int motion_blocks;
+    bool has_motion;
+    void (*release)(void* opaque);
+    void* opaque;
 } FrameBuffer;
 
 typedef struct {
@@ -129,6 +210,12 @@ typedef struct {
     int read_pos;
     int write_pos;
     bool finished;
+    int64_t popped;
+    int motion_block_size;
+    int32_t* motion_scratch;
+    int motion_scratch_blocks;
+    BlockVector* motion_spare;
+    int motion_spare_blocks;
 #ifdef _WIN32
     HANDLE mutex;
     HANDLE not_empty;
@@ -147,12 +234,101 @@ typedef struct {
     int current_pos;
 } BlurFrameBuffer;
 
+typedef struct {
+    BlurConfig config;
+    VideoContext* output;
+    FrameQueue* queue;
+    char filename[600];
+    int width;
+    int height;
+    int thread_count;
+    pthread_t thread;
+    bool started;
+} Rendition;
+
+typedef struct {
+    const BlurConfig* config;
+    VideoContext* output;
+    FrameQueue* queue;
+    Rendition* renditions;
+    FrameQueue** rendition_queues;
+    int rendition_count;
+    pthread_t thread;
+    bool started;
+    int index;
+} RenderBranch;
+
+typedef struct SharedFrame {
+    FrameBuffer frame;
+    int refs;
+    struct SharedFrame* next;
+} SharedFrame;
+
+typedef struct {
+    SharedFrame* free_list;
+    int free_count;
+    bool initialized;
+#ifdef _WIN32
+    HANDLE mutex;
+#else
+    pthread_mutex_t mutex;
+#endif
+} SharedFramePool;
+
+#define SHARED_FRAME_POOL_LIMIT 64
+#define MUX_QUEUE_PACKETS 1024
+
+typedef struct {
+    volatile long sequence;
+    void* data;
+} PacketCell;
+
+typedef struct {
+    PacketCell* cells;
+    long mask;
+    volatile long enqueue_pos;
+    volatile long dequeue_pos;
+} PacketRing;
+
+typedef struct {
+    AVPacket* packet;
+    VideoContext* output;
+} MuxItem;
+
+typedef struct {
+    PacketRing queue;
+    PacketRing pool;
+    MuxItem* items;
+    int item_count;
+    volatile long stopping;
+    bool debug;
+    bool started;
+    pthread_t thread;
+} Muxer;
+
+typedef struct {
+    bool active;
+    int64_t start;
+    int64_t end;
+    int64_t preroll;
+} TrimRange;
+#define RENDITION_QUEUE_FRAMES 8
+#define MAX_RENDITIONS 8
+
 static VideoContext* g_input_ctx = NULL;
-static VideoContext* g_output_ctx = NULL;
-static FrameQueue* g_frame_queue = NULL;
+static RenderBranch* g_branches = NULL;
+static FrameQueue** g_branch_queues = NULL;
+static int g_branch_count = 0;
+static bool g_render_complete = false;
+static Muxer g_muxer = { 0 };
+static SharedFramePool g_shared_frames = { 0 };
 static AVFilterGraph* g_filter_graph = NULL;
 static AVFilterContext* g_buffersrc_ctx = NULL;
 static AVFilterContext* g_buffersink_ctx = NULL;
+static int g_frame_width = 0;
+static int g_frame_height = 0;
+static TrimRange g_trim = { 0 };
+static AVFrame* g_ingest_frame = NULL;
 
 #ifdef HAVE_VAPOURSYNTH
 static VapourSynthContext* g_vs_ctx = NULL;
@@ -160,7 +336,12 @@ static VapourSynthContext* g_vs_ctx = NULL;
 
 extern void update_progress(int64_t frames);
 extern bool is_interrupted(void);
-extern float* config_get_weights(const BlurConfig* config, int frame_count, int* weight_count);
+extern float* config_get_weights(const BlurConfig* config, int frame_count, int interpolation_factor,
+    int* weight_count);
+
+static void frame_buffer_free(FrameBuffer* buffer);
+static bool vapoursynth_active(void);
+static int get_cpu_count(void);
 
 #ifdef _WIN32
 static void frame_queue_init(FrameQueue* queue, int capacity) {
@@ -179,18 +360,12 @@ static void frame_queue_destroy(FrameQueue* queue) {
     if (!queue) return;
 
     for (int i = 0; i < queue->capacity; i++) {
-        if (queue->frames[i].allocated && queue->frames[i].data) {
-            for (int j = 0; j < 4; j++) {
-                if (queue->frames[i].data[j]) {
-                    av_free(queue->frames[i].data[j]);
-                }
-            }
-            av_free(queue->frames[i].data);
-            av_free(queue->frames[i].linesize);
-        }
+        frame_buffer_free(&queue->frames[i]);
     }
 
     free(queue->frames);
+    free(queue->motion_scratch);
+    free(queue->motion_spare);
     CloseHandle(queue->mutex);
     CloseHandle(queue->not_empty);
     CloseHandle(queue->not_full);
@@ -219,18 +394,12 @@ static void frame_queue_destroy(FrameQueue* queue) {
     if (!queue) return;
 
     for (int i = 0; i < queue->capacity; i++) {
-        if (queue->frames[i].allocated && queue->frames[i].data) {
-            for (int j = 0; j < 4; j++) {
-                if (queue->frames[i].data[j]) {
-                    av_free(queue->frames[i].data[j]);
-                }
-            }
-            av_free(queue->frames[i].data);
-            av_free(queue->frames[i].linesize);
-        }
+        frame_buffer_free(&queue->frames[i]);
     }
 
     free(queue->frames);
+    free(queue->motion_scratch);
+    free(queue->motion_spare);
     pthread_mutex_destroy(&queue->mutex);
     pthread_cond_destroy(&queue->not_empty);
     pthread_cond_destroy(&queue->not_full);
@@ -266,7 +435,34 @@ static bool frame_buffer_alloc(FrameBuffer* buffer, int width, int height, int f
     return true;
 }
 
+static void frame_buffer_free(FrameBuffer* buffer) {
+    free(buffer->motion);
+    buffer->motion = NULL;
+    buffer->motion_blocks = 0;
+    buffer->has_motion = false;
+
+    if (!buffer->allocated || !buffer->data) return;
+
+    if (buffer->release) {
+        buffer->release(buffer->opaque);
+        buffer->release = NULL;
+        buffer->opaque = NULL;
+    }
+    else {
+        av_freep(&buffer->data[0]);
+    }
+    av_free(buffer->data);
+    av_free(buffer->linesize);
+    buffer->data = NULL;
+    buffer->linesize = NULL;
+    buffer->allocated = false;
+}
+
 static void frame_buffer_copy(FrameBuffer* dst, AVFrame* src) {
+    if (dst->release) {
+        frame_buffer_free(dst);
+    }
+
     if (!dst->allocated) {
         frame_buffer_alloc(dst, src->width, src->height, src->format);
     }
@@ -288,7 +484,75 @@ static void frame_buffer_to_avframe(FrameBuffer* buffer, AVFrame* frame) {
     frame->pts = buffer->pts;
 }
 
-static bool frame_queue_push(FrameQueue* queue, AVFrame* frame) {
+static void frame_buffer_import_motion(FrameBuffer* dst, const AVFrame* src, FrameQueue* queue) {
+    int block_size = queue->motion_block_size;
+    dst->has_motion = false;
+
+    AVFrameSideData* side_data = av_frame_get_side_data(src, AV_FRAME_DATA_MOTION_VECTORS);
+    if (!side_data || side_data->size < sizeof(AVMotionVector)) return;
+
+    int blocks_x = (src->width + block_size - 1) / block_size;
+    int blocks_y = (src->height + block_size - 1) / block_size;
+    int block_count = blocks_x * blocks_y;
+
+    if (dst->motion_blocks != block_count) {
+        free(dst->motion);
+        dst->motion = (BlockVector*)malloc(block_count * sizeof(BlockVector));
+        dst->motion_blocks = dst->motion ? block_count : 0;
+    }
+    if (queue->motion_scratch_blocks < block_count) {
+        free(queue->motion_scratch);
+        queue->motion_scratch = (int32_t*)malloc(block_count * 3 * sizeof(int32_t));
+        queue->motion_scratch_blocks = queue->motion_scratch ? block_count : 0;
+    }
+    if (!dst->motion || !queue->motion_scratch) return;
+
+    int32_t* sums = queue->motion_scratch;
+    memset(sums, 0, block_count * 3 * sizeof(int32_t));
+
+    const AVMotionVector* mvs = (const AVMotionVector*)side_data->data;
+    size_t mv_count = side_data->size / sizeof(AVMotionVector);
+
+    for (size_t i = 0; i < mv_count; i++) {
+        const AVMotionVector* mv = &mvs[i];
+        if (mv->motion_scale == 0) continue;
+
+        int sign = mv->source < 0 ? 1 : -1;
+        int vx = sign * mv->motion_x * 16 / mv->motion_scale;
+        int vy = sign * mv->motion_y * 16 / mv->motion_scale;
+
+        int bx0 = CLAMP((mv->dst_x - mv->w / 2) / block_size, 0, blocks_x - 1);
+        int by0 = CLAMP((mv->dst_y - mv->h / 2) / block_size, 0, blocks_y - 1);
+        int bx1 = CLAMP((mv->dst_x + mv->w / 2 - 1) / block_size, 0, blocks_x - 1);
+        int by1 = CLAMP((mv->dst_y + mv->h / 2 - 1) / block_size, 0, blocks_y - 1);
+
+        for (int by = by0; by <= by1; by++) {
+            for (int bx = bx0; bx <= bx1; bx++) {
+                int32_t* cell = &sums[(by * blocks_x + bx) * 3];
+                cell[0] += vx;
+                cell[1] += vy;
+                cell[2]++;
+            }
+        }
+    }
+
+    int covered = 0;
+    for (int i = 0; i < block_count; i++) {
+        int32_t* cell = &sums[i * 3];
+        if (cell[2] == 0) {
+            dst->motion[i].x = MOTION_VECTOR_INVALID;
+            dst->motion[i].y = MOTION_VECTOR_INVALID;
+            continue;
+        }
+        dst->motion[i].x = (int16_t)lrintf(cell[0] / (16.0f * cell[2]));
+        dst->motion[i].y = (int16_t)lrintf(cell[1] / (16.0f * cell[2]));
+        covered++;
+    }
+
+    dst->has_motion = covered * 2 >= block_count;
+}
+
+static bool frame_queue_wait_writable(FrameQueue* queue) {
 #ifdef _WIN32
     WaitForSingleObject(queue->mutex, INFINITE);
 
@@ -318,9 +582,10 @@ static bool frame_queue_push(FrameQueue* queue, AVFrame* frame) {
     }
 #endif
 
-    FrameBuffer* buffer = &queue->frames[queue->write_pos];
-    frame_buffer_copy(buffer, frame);
+    return true;
+}
 
+static void frame_queue_commit_write(FrameQueue* queue) {
     queue->write_pos = (queue->write_pos + 1) % queue->capacity;
     queue->count++;
 
@@ -331,11 +596,45 @@ static bool frame_queue_push(FrameQueue* queue, AVFrame* frame) {
     pthread_cond_signal(&queue->not_empty);
     pthread_mutex_unlock(&queue->mutex);
 #endif
+}
+
+static bool frame_queue_push(FrameQueue* queue, AVFrame* frame) {
+    if (!frame_queue_wait_writable(queue)) {
+        return false;
+    }
+
+    FrameBuffer* buffer = &queue->frames[queue->write_pos];
+    frame_buffer_copy(buffer, frame);
+    if (queue->motion_block_size > 0) {
+        frame_buffer_import_motion(buffer, frame, queue);
+    }
+
+    frame_queue_commit_write(queue);
+    return true;
+}
+
+static bool frame_queue_push_buffer(FrameQueue* queue, FrameBuffer* frame) {
+    if (!frame_queue_wait_writable(queue)) {
+        return false;
+    }
+
+    FrameBuffer recycled = queue->frames[queue->write_pos];
+    queue->frames[queue->write_pos] = *frame;
+    *frame = recycled;
 
+    frame_queue_commit_write(queue);
     return true;
 }
 
-static bool frame_queue_pop(FrameQueue* queue, AVFrame* frame) {
+static void frame_queue_release_external(FrameQueue* queue) {
+    for (int i = 0; i < queue->capacity; i++) {
+        if (queue->frames[i].release) {
+            frame_buffer_free(&queue->frames[i]);
+        }
+    }
+}
+
+static bool frame_queue_pop(FrameQueue* queue, FrameBuffer* frame) {
 #ifdef _WIN32
     WaitForSingleObject(queue->mutex, INFINITE);
 
@@ -366,7 +665,10 @@ static bool frame_queue_pop(FrameQueue* queue, AVFrame* frame) {
 #endif
 
     FrameBuffer* buffer = &queue->frames[queue->read_pos];
-    frame_buffer_to_avframe(buffer, frame);
+    FrameBuffer recycled = *frame;
+    *frame = *buffer;
+    *buffer = recycled;
+    frame->sequence = ++queue->popped;
 
     queue->read_pos = (queue->read_pos + 1) % queue->capacity;
     queue->count--;
@@ -382,6 +684,183 @@ static bool frame_queue_pop(FrameQueue* queue, AVFrame* frame) {
     return true;
 }
 
+static void shared_frame_pool_init(void) {
+#ifdef _WIN32
+    g_shared_frames.mutex = CreateMutex(NULL, FALSE, NULL);
+#else
+    pthread_mutex_init(&g_shared_frames.mutex, NULL);
+#endif
+    g_shared_frames.initialized = true;
+}
+
+static void shared_frame_pool_destroy(void) {
+    if (!g_shared_frames.initialized) return;
+
+    while (g_shared_frames.free_list) {
+        SharedFrame* shared = g_shared_frames.free_list;
+        g_shared_frames.free_list = shared->next;
+        frame_buffer_free(&shared->frame);
+        free(shared);
+    }
+    g_shared_frames.free_count = 0;
+
+#ifdef _WIN32
+    CloseHandle(g_shared_frames.mutex);
+#else
+    pthread_mutex_destroy(&g_shared_frames.mutex);
+#endif
+    g_shared_frames.initialized = false;
+}
+
+static SharedFrame* shared_frame_acquire(void) {
+    SharedFrame* shared = NULL;
+
+#ifdef _WIN32
+    WaitForSingleObject(g_shared_frames.mutex, INFINITE);
+#else
+    pthread_mutex_lock(&g_shared_frames.mutex);
+#endif
+
+    if (g_shared_frames.free_list) {
+        shared = g_shared_frames.free_list;
+        g_shared_frames.free_list = shared->next;
+        g_shared_frames.free_count--;
+    }
+
+#ifdef _WIN32
+    ReleaseMutex(g_shared_frames.mutex);
+#else
+    pthread_mutex_unlock(&g_shared_frames.mutex);
+#endif
+
+    if (!shared) {
+        shared = (SharedFrame*)calloc(1, sizeof(SharedFrame));
+    }
+    return shared;
+}
+
+static void shared_frame_release(void* opaque) {
+    SharedFrame* shared = (SharedFrame*)opaque;
+    bool destroy = false;
+
+#ifdef _WIN32
+    WaitForSingleObject(g_shared_frames.mutex, INFINITE);
+#else
+    pthread_mutex_lock(&g_shared_frames.mutex);
+#endif
+
+    if (--shared->refs == 0) {
+        if (!shared->frame.release && g_shared_frames.free_count < SHARED_FRAME_POOL_LIMIT) {
+            shared->next = g_shared_frames.free_list;
+            g_shared_frames.free_list = shared;
+            g_shared_frames.free_count++;
+        }
+        else {
+            destroy = true;
+        }
+    }
+
+#ifdef _WIN32
+    ReleaseMutex(g_shared_frames.mutex);
+#else
+    pthread_mutex_unlock(&g_shared_frames.mutex);
+#endif
+
+    if (destroy) {
+        frame_buffer_free(&shared->frame);
+        free(shared);
+    }
+}
+
+static bool shared_frame_view(SharedFrame* shared, FrameBuffer* view) {
+    view->data = (uint8_t**)av_malloc(4 * sizeof(uint8_t*));
+    view->linesize = (int*)av_malloc(4 * sizeof(int));
+    if (!view->data || !view->linesize) {
+        av_freep(&view->data);
+        av_freep(&view->linesize);
+        return false;
+    }
+
+    for (int i = 0; i < 4; i++) {
+        view->data[i] = shared->frame.data[i];
+        view->linesize[i] = shared->frame.linesize[i];
+    }
+    view->width = shared->frame.width;
+    view->height = shared->frame.height;
+    view->format = shared->frame.format;
+    view->pts = shared->frame.pts;
+    view->allocated = true;
+    view->release = shared_frame_release;
+    view->opaque = shared;
+    return true;
+}
+
+static bool shared_frame_fan_out(SharedFrame* shared, FrameQueue** queues, int count, const AVFrame* source) {
+    bool pushed = true;
+    shared->refs = count;
+
+    for (int i = 0; i < count; i++) {
+        FrameQueue* queue = queues[i];
+        FrameBuffer view = { 0 };
+
+        if (!pushed || !shared_frame_view(shared, &view)) {
+            shared_frame_release(shared);
+            pushed = false;
+            continue;
+        }
+
+        if (source && queue->motion_block_size > 0) {
+            view.motion = queue->motion_spare;
+            view.motion_blocks = queue->motion_spare_blocks;
+            queue->motion_spare = NULL;
+            queue->motion_spare_blocks = 0;
+            frame_buffer_import_motion(&view, source, queue);
+        }
+
+        if (!frame_queue_push_buffer(queue, &view)) {
+            pushed = false;
+        }
+        if (!queue->motion_spare && view.motion) {
+            queue->motion_spare = view.motion;
+            queue->motion_spare_blocks = view.motion_blocks;
+            view.motion = NULL;
+            view.motion_blocks = 0;
+        }
+        frame_buffer_free(&view);
+    }
+
+    return pushed;
+}
+
+static bool render_branches_push(AVFrame* frame) {
+    if (g_branch_count == 1) {
+        return frame_queue_push(g_branches[0].queue, frame);
+    }
+
+    SharedFrame* shared = shared_frame_acquire();
+    if (!shared) {
+        return false;
+    }
+
+    frame_buffer_copy(&shared->frame, frame);
+    return shared_frame_fan_out(shared, g_branch_queues, g_branch_count, frame);
+}
+
+static bool render_branches_push_buffer(FrameBuffer* buffer) {
+    if (g_branch_count == 1) {
+        return frame_queue_push_buffer(g_branches[0].queue, buffer);
+    }
+
+    SharedFrame* shared = (SharedFrame*)calloc(1, sizeof(SharedFrame));
+    if (!shared) {
+        return false;
+    }
+
+    shared->frame = *buffer;
+    memset(buffer, 0, sizeof(FrameBuffer));
+    return shared_frame_fan_out(shared, g_branch_queues, g_branch_count, NULL);
+}
+
 static const char* get_hw_codec_name(const char* codec, const char* gpu_type, bool encoding) {
     if (strcmp(codec, "h264") == 0) {
         if (strcmp(gpu_type, "nvidia") == 0) {
@@ -446,704 +925,7324 @@ static enum AVPixelFormat get_pixel_format(const char* format_name) {
     return AV_PIX_FMT_YUV420P;
 }
 
-static bool open_input_video(VideoContext* ctx, const char* filename, const BlurConfig* config) {
-    int ret;
+static const char* get_sw_encoder_name(const char* codec) {
+    if (strcmp(codec, "h264") == 0) return "libx264";
+    if (strcmp(codec, "h265") == 0 || strcmp(codec, "hevc") == 0) return "libx265";
+    if (strcmp(codec, "av1") == 0) return "libsvtav1";
+    if (strcmp(codec, "vp9") == 0) return "libvpx-vp9";
+    return codec;
+}
 
-    ctx->fmt_ctx = NULL;
-    ret = avformat_open_input(&ctx->fmt_ctx, filename, NULL, NULL);
-    if (ret < 0) {
-        char errbuf[AV_ERROR_MAX_STRING_SIZE];
-        av_strerror(ret, errbuf, AV_ERROR_MAX_STRING_SIZE);
-        fprintf(stderr, "Error opening input file '%s': %s\n", filename, errbuf);
-        return false;
-    }
+static enum AVCodecID get_codec_id(const char* codec) {
+    if (strcmp(codec, "h265") == 0 || strcmp(codec, "hevc") == 0) return AV_CODEC_ID_HEVC;
+    if (strcmp(codec, "av1") == 0) return AV_CODEC_ID_AV1;
+    if (strcmp(codec, "vp9") == 0) return AV_CODEC_ID_VP9;
+    return AV_CODEC_ID_H264;
+}
 
-    ret = avformat_find_stream_info(ctx->fmt_ctx, NULL);
-    if (ret < 0) {
-        fprintf(stderr, "Error finding stream information\n");
-        return false;
+static int get_preset_level(const char* preset) {
+    static const char* presets[] = {
+        "ultrafast", "superfast", "veryfast", "faster", "fast", "medium", "slow", "slower", "veryslow"
+    };
+    for (int i = 0; i < (int)(sizeof(presets) / sizeof(presets[0])); i++) {
+        if (strcmp(preset, presets[i]) == 0) return i;
     }
+    return -1;
+}
 
-    ctx->video_stream_idx = -1;
-    ctx->audio_stream_idx = -1;
+static void append_encoder_param(char* params, size_t size, const char* format, int value) {
+    size_t used = strlen(params);
+    if (used > 0 && used < size - 1) {
+        params[used++] = ':';
+        params[used] = '\0';
+    }
+    snprintf(params + used, size - used, format, value);
+}
 
-    for (unsigned int i = 0; i < ctx->fmt_ctx->nb_streams; i++) {
-        if (ctx->fmt_ctx->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_VIDEO &&
-            ctx->video_stream_idx == -1) {
-            ctx->video_stream_idx = i;
-            ctx->video_stream = ctx->fmt_ctx->streams[i];
+static void configure_sw_encoder(AVCodecContext* codec_ctx, const AVCodec* codec, const BlurConfig* config) {
+    static const int svt_presets[] = { 12, 11, 10, 9, 8, 6, 4, 3, 2 };
+    bool x264 = strcmp(codec->name, "libx264") == 0;
+    bool x265 = strcmp(codec->name, "libx265") == 0;
+    bool svt = strcmp(codec->name, "libsvtav1") == 0;
+    bool vpx = strcmp(codec->name, "libvpx-vp9") == 0;
+    char params[256] = "";
+
+    int preset = get_preset_level(config->encoder_preset);
+    if (preset >= 0) {
+        if (svt) {
+            av_opt_set_int(codec_ctx->priv_data, "preset", svt_presets[preset], 0);
         }
-        else if (ctx->fmt_ctx->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_AUDIO &&
-            ctx->audio_stream_idx == -1) {
-            ctx->audio_stream_idx = i;
-            ctx->audio_stream = ctx->fmt_ctx->streams[i];
+        else if (vpx) {
+            av_opt_set_int(codec_ctx->priv_data, "cpu-used", 8 - preset, 0);
+        }
+        else {
+            av_opt_set(codec_ctx->priv_data, "preset", config->encoder_preset, 0);
         }
     }
 
-    if (ctx->video_stream_idx == -1) {
-        fprintf(stderr, "No video stream found in input file\n");
-        return false;
-    }
-
-    const char* codec_name = NULL;
-    if (config->gpu_decoding) {
-        enum AVHWDeviceType hw_type = get_hw_device_type(config->gpu_type);
-        if (hw_type != AV_HWDEVICE_TYPE_NONE) {
-            ret = av_hwdevice_ctx_create(&ctx->hw_device_ctx, hw_type, NULL, NULL, 0);
-            if (ret < 0) {
-                if (config->verbose) {
-                    fprintf(stderr, "Warning: Failed to create hardware device context, using software decoding\n");
-                }
-                ctx->hw_device_ctx = NULL;
-            }
-            else {
-                codec_name = get_hw_codec_name(
-                    avcodec_get_name(ctx->video_stream->codecpar->codec_id),
-                    config->gpu_type, false);
-                if (config->verbose) {
-                    printf("Using hardware decoder: %s\n", codec_name);
-                }
-            }
+    if (strlen(config->encoder_tune) > 0) {
+        bool metric = strcmp(config->encoder_tune, "psnr") == 0 || strcmp(config->encoder_tune, "ssim") == 0;
+        if (x264 || x265) {
+            av_opt_set(codec_ctx->priv_data, "tune", config->encoder_tune, 0);
+        }
+        else if (svt) {
+            int tune = strcmp(config->encoder_tune, "psnr") == 0 ? 1 : strcmp(config->encoder_tune, "ssim") == 0 ? 2 : 0;
+            append_encoder_param(params, sizeof(params), "tune=%d", tune);
+        }
+        else if (vpx && metric) {
+            av_opt_set(codec_ctx->priv_data, "tune", config->encoder_tune, 0);
         }
     }
 
-    const AVCodec* codec = codec_name ?
-        avcodec_find_decoder_by_name(codec_name) :
-        avcodec_find_decoder(ctx->video_stream->codecpar->codec_id);
+    if (config->throughput) {
+        int threads = codec_ctx->thread_count > 0 ? codec_ctx->thread_count : get_cpu_count();
+        int lookahead_threads = FFMAX(1, threads / 4);
 
-    if (!codec) {
-        fprintf(stderr, "Codec not found for stream\n");
-        return false;
-    }
+        codec_ctx->thread_count = threads;
+        codec_ctx->thread_type = FF_THREAD_FRAME;
 
-    ctx->codec_ctx = avcodec_alloc_context3(codec);
-    if (!ctx->codec_ctx) {
-        fprintf(stderr, "Failed to allocate codec context\n");
-        return false;
+        if (x264 || x265) {
+            append_encoder_param(params, sizeof(params), "lookahead-threads=%d", lookahead_threads);
+            append_encoder_param(params, sizeof(params), "rc-lookahead=%d", 20);
+            append_encoder_param(params, sizeof(params), "b-adapt=%d", 1);
+        }
+        else if (vpx) {
+            av_opt_set_int(codec_ctx->priv_data, "row-mt", 1, 0);
+        }
     }
 
-    ret = avcodec_parameters_to_context(ctx->codec_ctx, ctx->video_stream->codecpar);
-    if (ret < 0) {
-        fprintf(stderr, "Failed to copy codec parameters to decoder context\n");
-        return false;
+    if (strlen(params) > 0) {
+        av_opt_set(codec_ctx->priv_data, x264 ? "x264-params" : x265 ? "x265-params" : "svtav1-params", params, 0);
     }
+}
 
-    if (ctx->hw_device_ctx) {
-        ctx->codec_ctx->hw_device_ctx = av_buffer_ref(ctx->hw_device_ctx);
-    }
-
-    if (config->threads > 0) {
-        ctx->codec_ctx->thread_count = config->threads;
-        ctx->codec_ctx->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
-    }
-
-    ret = avcodec_open2(ctx->codec_ctx, codec, NULL);
-    if (ret < 0) {
-        fprintf(stderr, "Failed to open codec\n");
-        return false;
-    }
+#define INPUT_IO_BLOCK_SIZE (4 << 20)
+#define INPUT_IO_AVIO_BUFFER (256 << 10)
 
-    ctx->frame = av_frame_alloc();
-    ctx->packet = av_packet_alloc();
+typedef struct {
+    uint8_t* data;
+    int64_t offset;
+    int length;
+} InputBlock;
 
-    if (!ctx->frame || !ctx->packet) {
-        fprintf(stderr, "Failed to allocate frame or packet\n");
-        return false;
-    }
+struct InputIO {
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+    HANDLE mutex;
+    HANDLE request;
+    HANDLE done;
+#else
+    int fd;
+    pthread_mutex_t mutex;
+    pthread_cond_t request;
+    pthread_cond_t done;
+#endif
+#ifdef HAVE_LIBURING
+    struct io_uring ring;
+    bool uring;
+#endif
+    AVIOContext* avio;
+    uint8_t* map;
+    int64_t size;
+    int64_t pos;
+    InputBlock blocks[2];
+    int pending;
+    int pending_result;
+    bool pending_done;
+    bool stopping;
+    bool thread_started;
+    pthread_t thread;
+    bool verbose;
+    int64_t bytes_read;
+    int64_t wait_us;
+    int64_t prefetch_hits;
+    int64_t demand_reads;
+};
 
-    return true;
+static uint8_t* input_io_block_alloc(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (uint8_t*)_aligned_malloc(INPUT_IO_BLOCK_SIZE, info.dwPageSize);
+#else
+    void* data = NULL;
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    if (posix_memalign(&data, page_size, INPUT_IO_BLOCK_SIZE) != 0) return NULL;
+    return (uint8_t*)data;
+#endif
 }
 
-static bool create_output_video(VideoContext* ctx, const char* filename, const BlurConfig* config,
-    int width, int height, double fps) {
-    int ret;
-
-    const char* format_name = NULL;
-    if (strstr(filename, ".mp4")) format_name = "mp4";
-    else if (strstr(filename, ".mkv")) format_name = "matroska";
-    else if (strstr(filename, ".avi")) format_name = "avi";
-    else if (strstr(filename, ".mov")) format_name = "mov";
+static void input_io_block_free(uint8_t* data) {
+#ifdef _WIN32
+    _aligned_free(data);
+#else
+    free(data);
+#endif
+}
 
-    ret = avformat_alloc_output_context2(&ctx->fmt_ctx, NULL, format_name, filename);
-    if (!ctx->fmt_ctx) {
-        fprintf(stderr, "Failed to create output format context\n");
-        return false;
+static int input_io_pread(InputIO* io, uint8_t* buffer, int size, int64_t offset) {
+#ifdef _WIN32
+    OVERLAPPED overlapped = { 0 };
+    overlapped.Offset = (DWORD)(offset & 0xFFFFFFFF);
+    overlapped.OffsetHigh = (DWORD)((uint64_t)offset >> 32);
+    DWORD bytes = 0;
+    if (!ReadFile(io->file, buffer, (DWORD)size, &bytes, &overlapped)) {
+        return -1;
     }
-
-    const char* codec_name = config->codec;
-    if (config->gpu_encoding) {
-        codec_name = get_hw_codec_name(config->codec, config->gpu_type, true);
-        if (config->verbose) {
-            printf("Using hardware encoder: %s\n", codec_name);
+    return (int)bytes;
+#else
+    int total = 0;
+    while (total < size) {
+        ssize_t bytes = pread(io->fd, buffer + total, size - total, (off_t)(offset + total));
+        if (bytes < 0) {
+            if (errno == EINTR) continue;
+            return total > 0 ? total : -1;
         }
+        if (bytes == 0) break;
+        total += (int)bytes;
     }
+    return total;
+#endif
+}
 
-    const AVCodec* codec = avcodec_find_encoder_by_name(codec_name);
-    if (!codec) {
-        codec = avcodec_find_encoder_by_name(config->codec);
-        if (!codec) {
-            codec = avcodec_find_encoder(AV_CODEC_ID_H264);
+static THREAD_FUNC input_io_thread(void* arg) {
+    InputIO* io = (InputIO*)arg;
+
+#ifdef _WIN32
+    WaitForSingleObject(io->mutex, INFINITE);
+    while (true) {
+        while ((io->pending < 0 || io->pending_done) && !io->stopping) {
+            ReleaseMutex(io->mutex);
+            WaitForSingleObject(io->request, INFINITE);
+            WaitForSingleObject(io->mutex, INFINITE);
         }
-    }
+        if (io->stopping) break;
 
-    if (!codec) {
-        fprintf(stderr, "Encoder not found\n");
-        return false;
-    }
+        InputBlock* block = &io->blocks[io->pending];
+        int length = (int)FFMIN(INPUT_IO_BLOCK_SIZE, io->size - block->offset);
+        ReleaseMutex(io->mutex);
 
-    ctx->video_stream = avformat_new_stream(ctx->fmt_ctx, codec);
-    if (!ctx->video_stream) {
-        fprintf(stderr, "Failed to create output video stream\n");
-        return false;
-    }
+        int result = input_io_pread(io, block->data, length, block->offset);
 
-    ctx->codec_ctx = avcodec_alloc_context3(codec);
-    if (!ctx->codec_ctx) {
-        fprintf(stderr, "Failed to allocate encoder context\n");
-        return false;
+        WaitForSingleObject(io->mutex, INFINITE);
+        io->pending_result = result;
+        io->pending_done = true;
+        SetEvent(io->done);
     }
+    ReleaseMutex(io->mutex);
+    return 0;
+#else
+    pthread_mutex_lock(&io->mutex);
+    while (true) {
+        while ((io->pending < 0 || io->pending_done) && !io->stopping) {
+            pthread_cond_wait(&io->request, &io->mutex);
+        }
+        if (io->stopping) break;
 
-    ctx->codec_ctx->width = width;
-    ctx->codec_ctx->height = height;
-    ctx->codec_ctx->time_base = av_d2q(1.0 / fps, 1000000);
-    ctx->codec_ctx->framerate = av_d2q(fps, 1000000);
-    ctx->codec_ctx->gop_size = (int)(fps * 2);
-    ctx->codec_ctx->max_b_frames = 2;
-    ctx->codec_ctx->pix_fmt = get_pixel_format(config->pixel_format);
+        InputBlock* block = &io->blocks[io->pending];
+        int length = (int)FFMIN(INPUT_IO_BLOCK_SIZE, io->size - block->offset);
+        pthread_mutex_unlock(&io->mutex);
 
-    if (config->gpu_encoding && g_input_ctx && g_input_ctx->hw_device_ctx) {
-        ctx->codec_ctx->hw_device_ctx = av_buffer_ref(g_input_ctx->hw_device_ctx);
-    }
+        int result = input_io_pread(io, block->data, length, block->offset);
 
-    if (config->bitrate > 0) {
-        ctx->codec_ctx->bit_rate = config->bitrate * 1000;
-        ctx->codec_ctx->rc_max_rate = config->bitrate * 1200;
-        ctx->codec_ctx->rc_buffer_size = config->bitrate * 2000;
+        pthread_mutex_lock(&io->mutex);
+        io->pending_result = result;
+        io->pending_done = true;
+        pthread_cond_signal(&io->done);
     }
-    else {
-        if (codec->id == AV_CODEC_ID_H264 || codec->id == AV_CODEC_ID_HEVC) {
-            av_opt_set_int(ctx->codec_ctx->priv_data, "crf", config->quality, 0);
-        }
-        else {
-            ctx->codec_ctx->qmin = config->quality;
-            ctx->codec_ctx->qmax = config->quality + 10;
+    pthread_mutex_unlock(&io->mutex);
+    return NULL;
+#endif
+}
+
+static void input_io_prefetch(InputIO* io, int index, int64_t offset) {
+    InputBlock* block = &io->blocks[index];
+    block->offset = offset;
+    block->length = 0;
+
+#ifdef HAVE_LIBURING
+    if (io->uring) {
+        struct io_uring_sqe* sqe = io_uring_get_sqe(&io->ring);
+        if (sqe) {
+            io_uring_prep_read(sqe, io->fd, block->data, (unsigned)FFMIN(INPUT_IO_BLOCK_SIZE, io->size - offset),
+                (uint64_t)offset);
+            if (io_uring_submit(&io->ring) == 1) {
+                io->pending = index;
+            }
         }
+        return;
     }
+#endif
 
-    if (config->threads > 0) {
-        ctx->codec_ctx->thread_count = config->threads;
-    }
+    if (!io->thread_started) return;
 
-    if (ctx->fmt_ctx->oformat->flags & AVFMT_GLOBALHEADER) {
-        ctx->codec_ctx->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+#ifdef _WIN32
+    WaitForSingleObject(io->mutex, INFINITE);
+    io->pending = index;
+    io->pending_done = false;
+    SetEvent(io->request);
+    ReleaseMutex(io->mutex);
+#else
+    pthread_mutex_lock(&io->mutex);
+    io->pending = index;
+    io->pending_done = false;
+    pthread_cond_signal(&io->request);
+    pthread_mutex_unlock(&io->mutex);
+#endif
+}
+
+static void input_io_wait(InputIO* io) {
+    if (io->pending < 0) return;
+
+    int index = io->pending;
+    int result = -1;
+
+#ifdef HAVE_LIBURING
+    if (io->uring) {
+        struct io_uring_cqe* cqe;
+        if (io_uring_wait_cqe(&io->ring, &cqe) == 0) {
+            result = cqe->res;
+            io_uring_cqe_seen(&io->ring, cqe);
+        }
+        io->pending = -1;
+        io->blocks[index].length = result > 0 ? result : 0;
+        return;
     }
+#endif
 
-    if (config->gpu_encoding) {
-        av_opt_set(ctx->codec_ctx->priv_data, "preset", "fast", 0);
-        av_opt_set(ctx->codec_ctx->priv_data, "tune", "zerolatency", 0);
+#ifdef _WIN32
+    WaitForSingleObject(io->mutex, INFINITE);
+    while (!io->pending_done) {
+        ReleaseMutex(io->mutex);
+        WaitForSingleObject(io->done, INFINITE);
+        WaitForSingleObject(io->mutex, INFINITE);
+    }
+    result = io->pending_result;
+    io->pending = -1;
+    ReleaseMutex(io->mutex);
+#else
+    pthread_mutex_lock(&io->mutex);
+    while (!io->pending_done) {
+        pthread_cond_wait(&io->done, &io->mutex);
     }
+    result = io->pending_result;
+    io->pending = -1;
+    pthread_mutex_unlock(&io->mutex);
+#endif
 
-    ret = avcodec_open2(ctx->codec_ctx, codec, NULL);
-    if (ret < 0) {
-        char errbuf[AV_ERROR_MAX_STRING_SIZE];
-        av_strerror(ret, errbuf, AV_ERROR_MAX_STRING_SIZE);
-        fprintf(stderr, "Failed to open encoder: %s\n", errbuf);
-        return false;
+    io->blocks[index].length = result > 0 ? result : 0;
+}
+
+static InputBlock* input_io_find(InputIO* io, int64_t pos) {
+    for (int i = 0; i < 2; i++) {
+        InputBlock* block = &io->blocks[i];
+        if (i != io->pending && block->length > 0 && pos >= block->offset && pos < block->offset + block->length) {
+            return block;
+        }
     }
+    return NULL;
+}
 
-    ret = avcodec_parameters_from_context(ctx->video_stream->codecpar, ctx->codec_ctx);
-    if (ret < 0) {
-        fprintf(stderr, "Failed to copy encoder parameters to stream\n");
-        return false;
+static int input_io_read(void* opaque, uint8_t* buffer, int size) {
+    InputIO* io = (InputIO*)opaque;
+    if (io->pos >= io->size) {
+        return AVERROR_EOF;
     }
 
-    ctx->video_stream->time_base = ctx->codec_ctx->time_base;
+    int bytes;
+    if (io->map) {
+        bytes = (int)FFMIN(size, io->size - io->pos);
+        memcpy(buffer, io->map + io->pos, bytes);
+        io->pos += bytes;
+        io->bytes_read += bytes;
+        return bytes;
+    }
 
-    if (g_input_ctx && g_input_ctx->audio_stream_idx >= 0) {
-        AVStream* in_stream = g_input_ctx->fmt_ctx->streams[g_input_ctx->audio_stream_idx];
-        AVStream* out_stream = avformat_new_stream(ctx->fmt_ctx, NULL);
+    InputBlock* block = input_io_find(io, io->pos);
+    if (!block) {
+        int64_t wait_start = av_gettime_relative();
 
-        if (out_stream) {
-            ret = avcodec_parameters_copy(out_stream->codecpar, in_stream->codecpar);
-            if (ret >= 0) {
-                out_stream->time_base = in_stream->time_base;
-                if (config->timescale != 1.0) {
-                    out_stream->time_base.den = (int)(out_stream->time_base.den * config->timescale);
-                }
-                ctx->audio_stream = out_stream;
-                ctx->audio_stream_idx = out_stream->index;
-                if (config->verbose) {
-                    printf("Copying audio stream\n");
-                }
+        input_io_wait(io);
+        block = input_io_find(io, io->pos);
+        if (block) {
+            io->prefetch_hits++;
+        }
+        else {
+            block = &io->blocks[0];
+            block->offset = io->pos - io->pos % INPUT_IO_BLOCK_SIZE;
+            int result = input_io_pread(io, block->data, (int)FFMIN(INPUT_IO_BLOCK_SIZE, io->size - block->offset),
+                block->offset);
+            block->length = result > 0 ? result : 0;
+            io->demand_reads++;
+
+            if (io->pos >= block->offset + block->length) {
+                io->wait_us += av_gettime_relative() - wait_start;
+                return result < 0 ? AVERROR(EIO) : AVERROR_EOF;
             }
         }
+
+        io->wait_us += av_gettime_relative() - wait_start;
+    }
+    else {
+        io->prefetch_hits++;
     }
 
-    ret = avio_open(&ctx->fmt_ctx->pb, filename, AVIO_FLAG_WRITE);
-    if (ret < 0) {
-        char errbuf[AV_ERROR_MAX_STRING_SIZE];
-        av_strerror(ret, errbuf, AV_ERROR_MAX_STRING_SIZE);
-        fprintf(stderr, "Failed to open output file '%s': %s\n", filename, errbuf);
-        return false;
+    bytes = (int)FFMIN(size, block->offset + block->length - io->pos);
+    memcpy(buffer, block->data + (io->pos - block->offset), bytes);
+    io->pos += bytes;
+    io->bytes_read += bytes;
+
+    int64_t next = block->offset + block->length;
+    if (io->pending < 0 && next < io->size && !input_io_find(io, next)) {
+        input_io_prefetch(io, block == &io->blocks[0] ? 1 : 0, next);
     }
 
-    ret = avformat_write_header(ctx->fmt_ctx, NULL);
-    if (ret < 0) {
-        char errbuf[AV_ERROR_MAX_STRING_SIZE];
-        av_strerror(ret, errbuf, AV_ERROR_MAX_STRING_SIZE);
-        fprintf(stderr, "Failed to write output header: %s\n", errbuf);
-        return false;
+    return bytes;
+}
+
+static int64_t input_io_seek(void* opaque, int64_t offset, int whence) {
+    InputIO* io = (InputIO*)opaque;
+    int64_t target;
+
+    switch (whence & ~AVSEEK_FORCE) {
+    case AVSEEK_SIZE:
+        return io->size;
+    case SEEK_SET:
+        target = offset;
+        break;
+    case SEEK_CUR:
+        target = io->pos + offset;
+        break;
+    case SEEK_END:
+        target = io->size + offset;
+        break;
+    default:
+        return AVERROR(EINVAL);
     }
 
-    ctx->frame = av_frame_alloc();
-    ctx->packet = av_packet_alloc();
+    if (target < 0) {
+        return AVERROR(EINVAL);
+    }
 
-    return true;
+    io->pos = target;
+    return target;
 }
 
-#ifdef HAVE_VAPOURSYNTH
-static bool init_vapoursynth(VapourSynthContext* vs_ctx) {
+static bool input_io_map(InputIO* io) {
+    if (io->size <= 0 || (uint64_t)io->size > SIZE_MAX) return false;
+
 #ifdef _WIN32
-    vs_ctx->library = LoadLibrary(L"vapoursynth.dll");
+    io->mapping = CreateFileMappingA(io->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!io->mapping) return false;
+
+    io->map = (uint8_t*)MapViewOfFile(io->mapping, FILE_MAP_READ, 0, 0, 0);
 #else
-    vs_ctx->library = dlopen("libvapoursynth.so", RTLD_LAZY);
+    void* map = mmap(NULL, (size_t)io->size, PROT_READ, MAP_SHARED, io->fd, 0);
+    if (map == MAP_FAILED) return false;
+
+    madvise(map, (size_t)io->size, MADV_SEQUENTIAL);
+    madvise(map, (size_t)io->size, MADV_WILLNEED);
+    io->map = (uint8_t*)map;
 #endif
+    return io->map != NULL;
+}
 
-    if (!vs_ctx->library) {
-        return false;
-    }
+static void input_io_close(InputIO* io) {
+    if (!io) return;
 
-    typedef const VSAPI* (*VSGetAPIFunc)(int version);
-    VSGetAPIFunc getVapourSynthAPI;
+    input_io_wait(io);
 
+    if (io->thread_started) {
 #ifdef _WIN32
-    getVapourSynthAPI = (VSGetAPIFunc)GetProcAddress(vs_ctx->library, "getVapourSynthAPI");
+        WaitForSingleObject(io->mutex, INFINITE);
+        io->stopping = true;
+        SetEvent(io->request);
+        ReleaseMutex(io->mutex);
+        WaitForSingleObject(io->thread, INFINITE);
+        CloseHandle(io->thread);
 #else
-    getVapourSynthAPI = (VSGetAPIFunc)dlsym(vs_ctx->library, "getVapourSynthAPI");
+        pthread_mutex_lock(&io->mutex);
+        io->stopping = true;
+        pthread_cond_signal(&io->request);
+        pthread_mutex_unlock(&io->mutex);
+        pthread_join(io->thread, NULL);
 #endif
-
-    if (!getVapourSynthAPI) {
-        return false;
     }
 
-    vs_ctx->vsapi = getVapourSynthAPI(VAPOURSYNTH_API_VERSION);
-    if (!vs_ctx->vsapi) {
-        return false;
+#ifdef _WIN32
+    if (io->mutex) CloseHandle(io->mutex);
+    if (io->request) CloseHandle(io->request);
+    if (io->done) CloseHandle(io->done);
+    if (io->map) UnmapViewOfFile(io->map);
+    if (io->mapping) CloseHandle(io->mapping);
+    if (io->file != INVALID_HANDLE_VALUE) CloseHandle(io->file);
+#else
+    if (io->thread_started) {
+        pthread_mutex_destroy(&io->mutex);
+        pthread_cond_destroy(&io->request);
+        pthread_cond_destroy(&io->done);
     }
+    if (io->map) munmap(io->map, (size_t)io->size);
+    if (io->fd >= 0) close(io->fd);
+#endif
+#ifdef HAVE_LIBURING
+    if (io->uring) io_uring_queue_exit(&io->ring);
+#endif
 
-    vs_ctx->core = vs_ctx->vsapi->createCore(0);
-    if (!vs_ctx->core) {
-        return false;
+    if (io->verbose && io->bytes_read > 0) {
+        double wait_seconds = io->wait_us / 1000000.0;
+        printf("Input I/O (%s): %.1f MB read, %.2f s waiting on storage, %lld prefetch hits, %lld demand reads\n",
+            io->map ? "mmap" : "buffered", io->bytes_read / 1048576.0, wait_seconds,
+            (long long)io->prefetch_hits, (long long)io->demand_reads);
     }
 
-    return true;
+    input_io_block_free(io->blocks[0].data);
+    input_io_block_free(io->blocks[1].data);
+    if (io->avio) {
+        av_freep(&io->avio->buffer);
+        avio_context_free(&io->avio);
+    }
+    free(io);
 }
-#endif
 
-static bool create_filter_graph(const BlurConfig* config, int width, int height, double fps) {
-    int ret;
-    char args[512];
+static InputIO* input_io_open(const char* filename, const char* mode, bool verbose) {
+    InputIO* io = (InputIO*)calloc(1, sizeof(InputIO));
+    if (!io) return NULL;
 
-    g_filter_graph = avfilter_graph_alloc();
-    if (!g_filter_graph) {
-        return false;
-    }
+    io->pending = -1;
+    io->verbose = verbose;
 
-    if (config->threads > 0) {
-        g_filter_graph->nb_threads = config->threads;
+#ifdef _WIN32
+    io->file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+        FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    LARGE_INTEGER file_size;
+    if (io->file == INVALID_HANDLE_VALUE || !GetFileSizeEx(io->file, &file_size)) {
+        input_io_close(io);
+        return NULL;
     }
-
-    snprintf(args, sizeof(args),
-        "video_size=%dx%d:pix_fmt=%d:time_base=%d/%d:pixel_aspect=1/1",
-        width, height, AV_PIX_FMT_YUV420P, 1, (int)fps);
-
-    const AVFilter* buffersrc = avfilter_get_by_name("buffer");
-    ret = avfilter_graph_create_filter(&g_buffersrc_ctx, buffersrc, "in",
-        args, NULL, g_filter_graph);
-    if (ret < 0) {
-        fprintf(stderr, "Failed to create buffer source filter\n");
-        return false;
+    io->size = file_size.QuadPart;
+#else
+    io->fd = open(filename, O_RDONLY);
+    struct stat st;
+    if (io->fd < 0 || fstat(io->fd, &st) != 0) {
+        input_io_close(io);
+        return NULL;
     }
+    io->size = st.st_size;
+#endif
 
-    const AVFilter* buffersink = avfilter_get_by_name("buffersink");
-    ret = avfilter_graph_create_filter(&g_buffersink_ctx, buffersink, "out",
-        NULL, NULL, g_filter_graph);
-    if (ret < 0) {
-        fprintf(stderr, "Failed to create buffer sink filter\n");
-        return false;
+    if (strcmp(mode, "mmap") == 0 && !input_io_map(io)) {
+        fprintf(stderr, "Warning: Failed to map input file, using buffered reads\n");
     }
 
-    enum AVPixelFormat pix_fmts[] = { AV_PIX_FMT_YUV420P, AV_PIX_FMT_NONE };
-    ret = av_opt_set_int_list(g_buffersink_ctx, "pix_fmts", pix_fmts,
-        AV_PIX_FMT_NONE, AV_OPT_SEARCH_CHILDREN);
-    if (ret < 0) {
-        fprintf(stderr, "Failed to set pixel formats on buffer sink\n");
-        return false;
-    }
+    if (!io->map) {
+        io->blocks[0].data = input_io_block_alloc();
+        io->blocks[1].data = input_io_block_alloc();
+        if (!io->blocks[0].data || !io->blocks[1].data) {
+            input_io_close(io);
+            return NULL;
+        }
 
-    AVFilterInOut* outputs = avfilter_inout_alloc();
-    AVFilterInOut* inputs = avfilter_inout_alloc();
+#if !defined(_WIN32) && defined(POSIX_FADV_SEQUENTIAL)
+        posix_fadvise(io->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
 
-    outputs->name = av_strdup("in");
-    outputs->filter_ctx = g_buffersrc_ctx;
-    outputs->pad_idx = 0;
-    outputs->next = NULL;
+#ifdef HAVE_LIBURING
+        io->uring = io_uring_queue_init(4, &io->ring, 0) == 0;
+#endif
 
-    inputs->name = av_strdup("out");
-    inputs->filter_ctx = g_buffersink_ctx;
-    inputs->pad_idx = 0;
-    inputs->next = NULL;
-
-    char filter_descr[2048] = "null";
-
-    if (strlen(config->ffmpeg_filters) > 0) {
-        strncpy(filter_descr, config->ffmpeg_filters, sizeof(filter_descr) - 1);
+#ifdef HAVE_LIBURING
+        if (!io->uring) {
+#else
+        {
+#endif
+#ifdef _WIN32
+            io->mutex = CreateMutex(NULL, FALSE, NULL);
+            io->request = CreateEvent(NULL, FALSE, FALSE, NULL);
+            io->done = CreateEvent(NULL, FALSE, FALSE, NULL);
+            io->thread = CreateThread(NULL, 0, input_io_thread, io, 0, NULL);
+            io->thread_started = io->thread != NULL;
+#else
+            pthread_mutex_init(&io->mutex, NULL);
+            pthread_cond_init(&io->request, NULL);
+            pthread_cond_init(&io->done, NULL);
+            io->thread_started = pthread_create(&io->thread, NULL, input_io_thread, io) == 0;
+            if (!io->thread_started) {
+                pthread_mutex_destroy(&io->mutex);
+                pthread_cond_destroy(&io->request);
+                pthread_cond_destroy(&io->done);
+            }
+#endif
+        }
     }
-    else if (config->brightness != 0 || config->saturation != 0 ||
-        config->contrast != 0 || config->gamma != 1.0) {
-
-        float bright = config->brightness;
-        float sat = 1.0f + config->saturation;
-        float cont = 1.0f + config->contrast;
-        float gamma = config->gamma;
 
-        snprintf(filter_descr, sizeof(filter_descr),
-            "eq=brightness=%.2f:saturation=%.2f:contrast=%.2f:gamma=%.2f",
-            bright, sat, cont, gamma);
+    uint8_t* avio_buffer = (uint8_t*)av_malloc(INPUT_IO_AVIO_BUFFER);
+    if (avio_buffer) {
+        io->avio = avio_alloc_context(avio_buffer, INPUT_IO_AVIO_BUFFER, 0, io, input_io_read, NULL, input_io_seek);
     }
-
-    if (config->debug) {
-        printf("Filter description: %s\n", filter_descr);
+    if (!io->avio) {
+        av_free(avio_buffer);
+        input_io_close(io);
+        return NULL;
     }
 
-    ret = avfilter_graph_parse_ptr(g_filter_graph, filter_descr, &inputs, &outputs, NULL);
-    if (ret < 0) {
-        fprintf(stderr, "Failed to parse filter graph\n");
-        avfilter_inout_free(&inputs);
-        avfilter_inout_free(&outputs);
-        return false;
+    if (verbose) {
+        const char* backend = io->map ? "mmap" : io->thread_started ? "prefetch thread" : "synchronous";
+#ifdef HAVE_LIBURING
+        if (io->uring) backend = "io_uring";
+#endif
+        if (io->map) {
+            printf("Input I/O: %s, %.1f MB mapped\n", backend, io->size / 1048576.0);
+        }
+        else {
+            printf("Input I/O: %s, %d MB blocks\n", backend, INPUT_IO_BLOCK_SIZE >> 20);
+        }
     }
 
-    ret = avfilter_graph_config(g_filter_graph, NULL);
-    if (ret < 0) {
-        fprintf(stderr, "Failed to configure filter graph\n");
-        return false;
-    }
+    return io;
+}
 
-    avfilter_inout_free(&inputs);
-    avfilter_inout_free(&outputs);
+#define OUTPUT_IO_BLOCK_SIZE (4 << 20)
+#define OUTPUT_IO_BLOCKS 8
+
+typedef struct {
+    uint8_t* data;
+    int64_t offset;
+    int length;
+} OutputBlock;
+
+struct OutputIO {
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mutex;
+    HANDLE work;
+    HANDLE space;
+#else
+    int fd;
+    pthread_mutex_t mutex;
+    pthread_cond_t work;
+    pthread_cond_t space;
+#endif
+    AVIOContext* avio;
+    OutputBlock blocks[OUTPUT_IO_BLOCKS];
+    int head;
+    int count;
+    int fill;
+    int64_t pos;
+    int64_t size;
+    bool error;
+    bool stopping;
+    bool thread_started;
+    pthread_t thread;
+    bool verbose;
+    int64_t bytes_written;
+    int64_t blocks_written;
+    int64_t write_us;
+    int64_t stall_us;
+};
 
+static bool output_io_pwrite(OutputIO* io, const uint8_t* data, int size, int64_t offset) {
+#ifdef _WIN32
+    while (size > 0) {
+        OVERLAPPED overlapped = { 0 };
+        overlapped.Offset = (DWORD)(offset & 0xFFFFFFFF);
+        overlapped.OffsetHigh = (DWORD)((uint64_t)offset >> 32);
+        DWORD bytes = 0;
+        if (!WriteFile(io->file, data, (DWORD)size, &bytes, &overlapped) || bytes == 0) {
+            return false;
+        }
+        data += bytes;
+        offset += bytes;
+        size -= (int)bytes;
+    }
+#else
+    while (size > 0) {
+        ssize_t bytes = pwrite(io->fd, data, size, (off_t)offset);
+        if (bytes < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += bytes;
+        offset += bytes;
+        size -= (int)bytes;
+    }
+#endif
     return true;
 }
 
-static bool apply_motion_blur(FrameBuffer* frames, int frame_count, float* weights, FrameBuffer* output) {
-    if (frame_count == 0 || !frames || !weights || !output) return false;
-
-    int width = frames[0].width;
-    int height = frames[0].height;
+static THREAD_FUNC output_io_thread(void* arg) {
+    OutputIO* io = (OutputIO*)arg;
 
-    if (!output->allocated) {
-        if (!frame_buffer_alloc(output, width, height, AV_PIX_FMT_YUV420P)) {
-            return false;
+#ifdef _WIN32
+    WaitForSingleObject(io->mutex, INFINITE);
+    while (true) {
+        while (io->count == 0 && !io->stopping) {
+            ReleaseMutex(io->mutex);
+            WaitForSingleObject(io->work, INFINITE);
+            WaitForSingleObject(io->mutex, INFINITE);
+        }
+        if (io->count == 0) break;
+
+        OutputBlock* block = &io->blocks[io->head];
+        bool failed = io->error;
+        ReleaseMutex(io->mutex);
+
+        int64_t write_start = av_gettime_relative();
+        bool ok = !failed && output_io_pwrite(io, block->data, block->length, block->offset);
+        io->write_us += av_gettime_relative() - write_start;
+
+        WaitForSingleObject(io->mutex, INFINITE);
+        if (!ok) io->error = true;
+        io->bytes_written += block->length;
+        io->blocks_written++;
+        io->head = (io->head + 1) % OUTPUT_IO_BLOCKS;
+        io->count--;
+        SetEvent(io->space);
+    }
+    ReleaseMutex(io->mutex);
+    return 0;
+#else
+    pthread_mutex_lock(&io->mutex);
+    while (true) {
+        while (io->count == 0 && !io->stopping) {
+            pthread_cond_wait(&io->work, &io->mutex);
         }
+        if (io->count == 0) break;
+
+        OutputBlock* block = &io->blocks[io->head];
+        bool failed = io->error;
+        pthread_mutex_unlock(&io->mutex);
+
+        int64_t write_start = av_gettime_relative();
+        bool ok = !failed && output_io_pwrite(io, block->data, block->length, block->offset);
+        io->write_us += av_gettime_relative() - write_start;
+
+        pthread_mutex_lock(&io->mutex);
+        if (!ok) io->error = true;
+        io->bytes_written += block->length;
+        io->blocks_written++;
+        io->head = (io->head + 1) % OUTPUT_IO_BLOCKS;
+        io->count--;
+        pthread_cond_signal(&io->space);
     }
+    pthread_mutex_unlock(&io->mutex);
+    return NULL;
+#endif
+}
 
-    memset(output->data[0], 0, output->linesize[0] * height);
-    memset(output->data[1], 0, output->linesize[1] * (height / 2));
-    memset(output->data[2], 0, output->linesize[2] * (height / 2));
+static void output_io_submit(OutputIO* io) {
+    if (io->blocks[io->fill].length == 0) return;
 
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            float y_accum = 0, u_accum = 0, v_accum = 0;
+    int64_t stall_start = av_gettime_relative();
 
-            for (int i = 0; i < frame_count; i++) {
-                if (!frames[i].data[0]) continue;
+#ifdef _WIN32
+    WaitForSingleObject(io->mutex, INFINITE);
+    io->count++;
+    io->fill = (io->fill + 1) % OUTPUT_IO_BLOCKS;
+    SetEvent(io->work);
+    while (io->count == OUTPUT_IO_BLOCKS) {
+        ReleaseMutex(io->mutex);
+        WaitForSingleObject(io->space, INFINITE);
+        WaitForSingleObject(io->mutex, INFINITE);
+    }
+    ReleaseMutex(io->mutex);
+#else
+    pthread_mutex_lock(&io->mutex);
+    io->count++;
+    io->fill = (io->fill + 1) % OUTPUT_IO_BLOCKS;
+    pthread_cond_signal(&io->work);
+    while (io->count == OUTPUT_IO_BLOCKS) {
+        pthread_cond_wait(&io->space, &io->mutex);
+    }
+    pthread_mutex_unlock(&io->mutex);
+#endif
 
-                uint8_t y_val = frames[i].data[0][y * frames[i].linesize[0] + x];
-                y_accum += y_val * weights[i];
+    io->stall_us += av_gettime_relative() - stall_start;
+    io->blocks[io->fill].offset = io->pos;
+    io->blocks[io->fill].length = 0;
+}
 
-                if (y % 2 == 0 && x % 2 == 0) {
-                    uint8_t u_val = frames[i].data[1][(y / 2) * frames[i].linesize[1] + (x / 2)];
-                    uint8_t v_val = frames[i].data[2][(y / 2) * frames[i].linesize[2] + (x / 2)];
-                    u_accum += u_val * weights[i];
-                    v_accum += v_val * weights[i];
-                }
-            }
+static bool output_io_failed(OutputIO* io) {
+#ifdef _WIN32
+    WaitForSingleObject(io->mutex, INFINITE);
+    bool failed = io->error;
+    ReleaseMutex(io->mutex);
+#else
+    pthread_mutex_lock(&io->mutex);
+    bool failed = io->error;
+    pthread_mutex_unlock(&io->mutex);
+#endif
+    return failed;
+}
 
-            output->data[0][y * output->linesize[0] + x] = (uint8_t)CLAMP(y_accum, 0, 255);
+static int output_io_write(void* opaque, const uint8_t* buffer, int size) {
+    OutputIO* io = (OutputIO*)opaque;
+    if (output_io_failed(io)) {
+        return AVERROR(EIO);
+    }
 
-            if (y % 2 == 0 && x % 2 == 0) {
-                output->data[1][(y / 2) * output->linesize[1] + (x / 2)] = (uint8_t)CLAMP(u_accum, 0, 255);
-                output->data[2][(y / 2) * output->linesize[2] + (x / 2)] = (uint8_t)CLAMP(v_accum, 0, 255);
-            }
+    OutputBlock* block = &io->blocks[io->fill];
+    if (block->length > 0 && block->offset + block->length != io->pos) {
+        output_io_submit(io);
+        block = &io->blocks[io->fill];
+    }
+    if (block->length == 0) {
+        block->offset = io->pos;
+    }
+
+    int remaining = size;
+    while (remaining > 0) {
+        int bytes = FFMIN(remaining, OUTPUT_IO_BLOCK_SIZE - block->length);
+        memcpy(block->data + block->length, buffer, bytes);
+        block->length += bytes;
+        buffer += bytes;
+        remaining -= bytes;
+        io->pos += bytes;
+
+        if (block->length == OUTPUT_IO_BLOCK_SIZE) {
+            output_io_submit(io);
+            block = &io->blocks[io->fill];
         }
     }
 
-    output->pts = frames[frame_count / 2].pts;
-    return true;
+    io->size = FFMAX(io->size, io->pos);
+    return size;
 }
 
-static bool detect_duplicate_frames(FrameBuffer* frame1, FrameBuffer* frame2, float threshold) {
-    if (!frame1 || !frame2 || !frame1->data[0] || !frame2->data[0]) return false;
+static int64_t output_io_seek(void* opaque, int64_t offset, int whence) {
+    OutputIO* io = (OutputIO*)opaque;
+    int64_t target;
+
+    switch (whence & ~AVSEEK_FORCE) {
+    case AVSEEK_SIZE:
+        return io->size;
+    case SEEK_SET:
+        target = offset;
+        break;
+    case SEEK_CUR:
+        target = io->pos + offset;
+        break;
+    case SEEK_END:
+        target = io->size + offset;
+        break;
+    default:
+        return AVERROR(EINVAL);
+    }
 
-    int width = frame1->width;
-    int height = frame1->height;
+    if (target < 0) {
+        return AVERROR(EINVAL);
+    }
 
-    if (width != frame2->width || height != frame2->height) return false;
+    io->pos = target;
+    return target;
+}
 
-    int64_t diff_sum = 0;
-    int total_pixels = width * height;
+static bool output_io_finish(OutputIO* io) {
+    if (!io) return true;
 
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            int val1 = frame1->data[0][y * frame1->linesize[0] + x];
-            int val2 = frame2->data[0][y * frame2->linesize[0] + x];
-            diff_sum += abs(val1 - val2);
-        }
+    if (io->avio) {
+        avio_flush(io->avio);
     }
+    output_io_submit(io);
 
-    float avg_diff = (float)diff_sum / total_pixels;
-    return avg_diff < (threshold * 255.0f);
-}
-
-static double parse_fps_string(const char* fps_str, double base_fps) {
-    if (strstr(fps_str, "x")) {
-        double multiplier = atof(fps_str);
-        return base_fps * multiplier;
+#ifdef _WIN32
+    WaitForSingleObject(io->mutex, INFINITE);
+    while (io->count > 0) {
+        ReleaseMutex(io->mutex);
+        WaitForSingleObject(io->space, INFINITE);
+        WaitForSingleObject(io->mutex, INFINITE);
     }
-    return atof(fps_str);
-}
+    bool failed = io->error;
+    ReleaseMutex(io->mutex);
+#else
+    pthread_mutex_lock(&io->mutex);
+    while (io->count > 0) {
+        pthread_cond_wait(&io->space, &io->mutex);
+    }
+    bool failed = io->error;
+    pthread_mutex_unlock(&io->mutex);
+#endif
 
-static THREAD_FUNC processing_thread(void* arg) {
-    BlurConfig* config = (BlurConfig*)arg;
-    BlurFrameBuffer blur_buffer = { 0 };
-    int weight_count = 0;
-    float* weights = NULL;
+    return !failed;
+}
 
-    double input_fps = av_q2d(g_input_ctx->video_stream->avg_frame_rate);
-    double output_fps = parse_fps_string(config->blur_output_fps, input_fps);
+static void output_io_close(OutputIO* io) {
+    if (!io) return;
 
-    int blur_frame_count = (int)(output_fps / input_fps * config->blur_amount * 5.0 + 0.5);
-    if (blur_frame_count < 1) blur_frame_count = 1;
-    if (blur_frame_count > 64) blur_frame_count = 64;
+    if (io->thread_started) {
+        output_io_finish(io);
+#ifdef _WIN32
+        WaitForSingleObject(io->mutex, INFINITE);
+        io->stopping = true;
+        SetEvent(io->work);
+        ReleaseMutex(io->mutex);
+        WaitForSingleObject(io->thread, INFINITE);
+        CloseHandle(io->thread);
+#else
+        pthread_mutex_lock(&io->mutex);
+        io->stopping = true;
+        pthread_cond_signal(&io->work);
+        pthread_mutex_unlock(&io->mutex);
+        pthread_join(io->thread, NULL);
+
+        pthread_mutex_destroy(&io->mutex);
+        pthread_cond_destroy(&io->work);
+        pthread_cond_destroy(&io->space);
+#endif
+    }
 
-    weights = config_get_weights(config, blur_frame_count, &weight_count);
-    if (!weights) {
-        fprintf(stderr, "Failed to generate blur weights\n");
 #ifdef _WIN32
-        return 1;
+    if (io->mutex) CloseHandle(io->mutex);
+    if (io->work) CloseHandle(io->work);
+    if (io->space) CloseHandle(io->space);
+    if (io->file != INVALID_HANDLE_VALUE) CloseHandle(io->file);
 #else
-        return NULL;
+    if (io->fd >= 0) close(io->fd);
 #endif
+
+    if (io->verbose && io->blocks_written > 0) {
+        printf("Output I/O: %.1f MB in %lld blocks, %.2f s writing, %.2f s muxer stalled\n",
+            io->bytes_written / 1048576.0, (long long)io->blocks_written,
+            io->write_us / 1000000.0, io->stall_us / 1000000.0);
     }
 
-    blur_buffer.capacity = blur_frame_count;
-    blur_buffer.buffer = (FrameBuffer*)calloc(blur_frame_count, sizeof(FrameBuffer));
-    blur_buffer.count = 0;
-    blur_buffer.current_pos = 0;
+    for (int i = 0; i < OUTPUT_IO_BLOCKS; i++) {
+        av_free(io->blocks[i].data);
+    }
+    if (io->avio) {
+        av_freep(&io->avio->buffer);
+        avio_context_free(&io->avio);
+    }
+    free(io);
+}
+
+static OutputIO* output_io_open(const char* filename, bool verbose) {
+    OutputIO* io = (OutputIO*)calloc(1, sizeof(OutputIO));
+    if (!io) return NULL;
+
+    io->verbose = verbose;
 
-    if (!blur_buffer.buffer) {
-        free(weights);
 #ifdef _WIN32
-        return 1;
+    io->file = CreateFileA(filename, GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS,
+        FILE_ATTRIBUTE_NORMAL, NULL);
+    if (io->file == INVALID_HANDLE_VALUE) {
+        output_io_close(io);
+        return NULL;
+    }
 #else
+    io->fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (io->fd < 0) {
+        output_io_close(io);
         return NULL;
-#endif
     }
+#endif
 
-    FrameBuffer output_buffer = { 0 };
-    AVFrame* output_frame = av_frame_alloc();
-    AVFrame* input_frame = av_frame_alloc();
+    for (int i = 0; i < OUTPUT_IO_BLOCKS; i++) {
+        io->blocks[i].data = (uint8_t*)av_malloc(OUTPUT_IO_BLOCK_SIZE);
+        if (!io->blocks[i].data) {
+            output_io_close(io);
+            return NULL;
+        }
+    }
 
-    int frames_processed = 0;
-    FrameBuffer dedup_frames[16] = { 0 };
-    int dedup_count = 0;
+#ifdef _WIN32
+    io->mutex = CreateMutex(NULL, FALSE, NULL);
+    io->work = CreateEvent(NULL, FALSE, FALSE, NULL);
+    io->space = CreateEvent(NULL, FALSE, FALSE, NULL);
+    io->thread = CreateThread(NULL, 0, output_io_thread, io, 0, NULL);
+    io->thread_started = io->thread != NULL;
+#else
+    pthread_mutex_init(&io->mutex, NULL);
+    pthread_cond_init(&io->work, NULL);
+    pthread_cond_init(&io->space, NULL);
+    io->thread_started = pthread_create(&io->thread, NULL, output_io_thread, io) == 0;
+    if (!io->thread_started) {
+        pthread_mutex_destroy(&io->mutex);
+        pthread_cond_destroy(&io->work);
+        pthread_cond_destroy(&io->space);
+    }
+#endif
+    if (!io->thread_started) {
+        output_io_close(io);
+        return NULL;
+    }
 
-    if (config->verbose) {
-        printf("Processing with %d blur frames, weights: ", blur_frame_count);
-        for (int i = 0; i < weight_count; i++) {
-            printf("%.3f ", weights[i]);
-        }
-        printf("\n");
+    uint8_t* avio_buffer = (uint8_t*)av_malloc(INPUT_IO_AVIO_BUFFER);
+    if (avio_buffer) {
+        io->avio = avio_alloc_context(avio_buffer, INPUT_IO_AVIO_BUFFER, 1, io, NULL, output_io_write, output_io_seek);
+    }
+    if (!io->avio) {
+        av_free(avio_buffer);
+        output_io_close(io);
+        return NULL;
     }
 
-    while (!is_interrupted()) {
-        if (!frame_queue_pop(g_frame_queue, input_frame)) {
-            break;
-        }
+    if (verbose) {
+        printf("Output I/O: write-behind, %d x %d MB blocks\n", OUTPUT_IO_BLOCKS, OUTPUT_IO_BLOCK_SIZE >> 20);
+    }
 
-        bool is_duplicate = false;
+    return io;
+}
 
-        if (config->deduplicate && dedup_count > 0) {
-            FrameBuffer temp_buffer = { 0 };
-            frame_buffer_copy(&temp_buffer, input_frame);
+#define RAW_SINK_IOVECS 256
 
-            for (int i = 0; i < dedup_count && i < config->deduplicate_range; i++) {
-                if (detect_duplicate_frames(&temp_buffer, &dedup_frames[i], config->deduplicate_threshold)) {
-                    is_duplicate = true;
-                    break;
-                }
-            }
+#ifdef _WIN32
+typedef struct {
+    void* iov_base;
+    size_t iov_len;
+} RawIOVec;
+#else
+typedef struct iovec RawIOVec;
+#endif
 
-            if (!is_duplicate && dedup_count < 16) {
-                if (dedup_frames[dedup_count].allocated) {
-                    for (int j = 0; j < 4; j++) {
-                        if (dedup_frames[dedup_count].data[j]) {
-                            av_free(dedup_frames[dedup_count].data[j]);
-                        }
-                    }
-                    av_free(dedup_frames[dedup_count].data);
-                    av_free(dedup_frames[dedup_count].linesize);
-                }
-                dedup_frames[dedup_count] = temp_buffer;
-                dedup_count++;
-            }
-        }
+struct RawSink {
+    int fd;
+    bool y4m;
+    bool header_written;
+    bool error;
+    AVRational frame_rate;
+    AVRational time_base;
+    int64_t frames;
+    int64_t bytes;
+    bool verbose;
+};
+
+static const char* get_y4m_colorspace(enum AVPixelFormat format) {
+    switch (format) {
+    case AV_PIX_FMT_YUV420P: return "420jpeg";
+    case AV_PIX_FMT_YUV422P: return "422";
+    case AV_PIX_FMT_YUV444P: return "444";
+    case AV_PIX_FMT_YUV420P10LE: return "420p10";
+    case AV_PIX_FMT_YUV422P10LE: return "422p10";
+    case AV_PIX_FMT_YUV444P10LE: return "444p10";
+    case AV_PIX_FMT_GRAY8: return "mono";
+    default: return NULL;
+    }
+}
 
-        if (is_duplicate) {
-            av_frame_unref(input_frame);
+static bool is_image_sequence(const char* path) {
+    int conversions = 0;
+    for (const char* cursor = path; *cursor; cursor++) {
+        if (*cursor != '%') continue;
+        if (cursor[1] == '%') {
+            cursor++;
             continue;
         }
+        cursor++;
+        while (*cursor >= '0' && *cursor <= '9') cursor++;
+        if (*cursor != 'd') return false;
+        conversions++;
+    }
+    return conversions == 1;
+}
 
-        FrameBuffer* current_buffer = &blur_buffer.buffer[blur_buffer.current_pos];
-        frame_buffer_copy(current_buffer, input_frame);
+static bool is_raw_output(const char* filename, const BlurConfig* config) {
+    return strstr(filename, ".y4m") || strstr(filename, ".yuv") ||
+        strcmp(config->container, "y4m") == 0 || strcmp(config->container, "rawvideo") == 0;
+}
 
-        blur_buffer.current_pos = (blur_buffer.current_pos + 1) % blur_buffer.capacity;
-        if (blur_buffer.count < blur_buffer.capacity) {
-            blur_buffer.count++;
+static bool raw_sink_writev(RawSink* sink, RawIOVec* iov, int count) {
+    while (count > 0) {
+#ifdef _WIN32
+        int written = _write(sink->fd, iov->iov_base, (unsigned int)iov->iov_len);
+#else
+        ssize_t written = writev(sink->fd, iov, count);
+        if (written < 0 && errno == EINTR) continue;
+#endif
+        if (written < 0) {
+            if (!sink->error) {
+                fprintf(stderr, "Error writing raw output: %s\n", strerror(errno));
+            }
+            sink->error = true;
+            return false;
         }
 
-        if (blur_buffer.count >= blur_frame_count) {
-            FrameBuffer* ordered_frames = (FrameBuffer*)malloc(blur_frame_count * sizeof(FrameBuffer));
+        sink->bytes += written;
+        while (count > 0 && (size_t)written >= iov->iov_len) {
+            written -= iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count > 0) {
+            iov->iov_base = (uint8_t*)iov->iov_base + written;
+            iov->iov_len -= written;
+        }
+    }
+    return true;
+}
 
-            for (int i = 0; i < blur_frame_count; i++) {
-                int idx = (blur_buffer.current_pos - blur_frame_count + i + blur_buffer.capacity) % blur_buffer.capacity;
-                ordered_frames[i] = blur_buffer.buffer[idx];
-            }
+static bool raw_sink_push(RawSink* sink, RawIOVec* iov, int* count, void* data, size_t size) {
+    iov[*count].iov_base = data;
+    iov[*count].iov_len = size;
+    if (++*count < RAW_SINK_IOVECS) return true;
 
-            if (apply_motion_blur(ordered_frames, blur_frame_count, weights, &output_buffer)) {
-                frame_buffer_to_avframe(&output_buffer, output_frame);
+    *count = 0;
+    return raw_sink_writev(sink, iov, RAW_SINK_IOVECS);
+}
 
-                int ret = avcodec_send_frame(g_output_ctx->codec_ctx, output_frame);
-                if (ret < 0) {
-                    if (config->debug) {
-                        fprintf(stderr, "Error sending frame to encoder: %d\n", ret);
-                    }
-                }
+static bool raw_sink_write_frame(RawSink* sink, const AVFrame* frame) {
+    if (sink->error) return false;
 
-                while (ret >= 0) {
-                    ret = avcodec_receive_packet(g_output_ctx->codec_ctx, g_output_ctx->packet);
-                    if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
-                        break;
-                    }
-                    else if (ret < 0) {
-                        if (config->debug) {
-                            fprintf(stderr, "Error receiving packet from encoder: %d\n", ret);
-                        }
-                        break;
-                    }
+    const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get(frame->format);
+    if (!desc || (desc->flags & AV_PIX_FMT_FLAG_HWACCEL)) {
+        fprintf(stderr, "Raw output needs frames in system memory\n");
+        sink->error = true;
+        return false;
+    }
+
+    RawIOVec iov[RAW_SINK_IOVECS];
+    char header[128];
+    int count = 0;
+
+    if (sink->y4m) {
+        if (!sink->header_written) {
+            const char* colorspace = get_y4m_colorspace(frame->format);
+            if (!colorspace) {
+                fprintf(stderr, "Y4M output does not support pixel format %s\n", desc->name);
+                sink->error = true;
+                return false;
+            }
+            int length = snprintf(header, sizeof(header), "YUV4MPEG2 W%d H%d F%d:%d Ip A1:1 C%s\n",
+                frame->width, frame->height, sink->frame_rate.num, sink->frame_rate.den, colorspace);
+            raw_sink_push(sink, iov, &count, header, length);
+            sink->header_written = true;
+        }
+        raw_sink_push(sink, iov, &count, (void*)"FRAME\n", 6);
+    }
+
+    int planes = av_pix_fmt_count_planes(frame->format);
+    for (int plane = 0; plane < planes; plane++) {
+        int row_bytes = av_image_get_linesize(frame->format, frame->width, plane);
+        int rows = plane == 1 || plane == 2 ? AV_CEIL_RSHIFT(frame->height, desc->log2_chroma_h) : frame->height;
+        uint8_t* data = frame->data[plane];
+
+        if (frame->linesize[plane] == row_bytes) {
+            if (!raw_sink_push(sink, iov, &count, data, (size_t)row_bytes * rows)) return false;
+            continue;
+        }
+
+        for (int y = 0; y < rows; y++) {
+            if (!raw_sink_push(sink, iov, &count, data + (size_t)y * frame->linesize[plane], row_bytes)) {
+                return false;
+            }
+        }
+    }
+
+    if (count > 0 && !raw_sink_writev(sink, iov, count)) {
+        return false;
+    }
+
+    sink->frames++;
+    return true;
+}
+
+static void raw_sink_close(RawSink* sink) {
+    if (!sink) return;
+
+    if (sink->fd >= 0) {
+#ifdef _WIN32
+        _close(sink->fd);
+#else
+        close(sink->fd);
+#endif
+    }
+
+    if (sink->verbose) {
+        printf("Raw output: %lld frames, %.1f MB written\n", (long long)sink->frames, sink->bytes / 1048576.0);
+    }
+    free(sink);
+}
+
+static RawSink* raw_sink_open(const char* filename, const BlurConfig* config, double fps) {
+    RawSink* sink = (RawSink*)calloc(1, sizeof(RawSink));
+    if (!sink) return NULL;
+
+    sink->y4m = strstr(filename, ".y4m") || (!strstr(filename, ".yuv") && strcmp(config->container, "y4m") == 0);
+    sink->frame_rate = av_d2q(fps, 1001000);
+    sink->time_base = av_inv_q(sink->frame_rate);
+    sink->verbose = config->verbose;
+
+    if (strncmp(filename, "pipe:", 5) == 0) {
+        sink->fd = atoi(filename + 5);
+#ifdef _WIN32
+        _setmode(sink->fd, _O_BINARY);
+#endif
+    }
+    else {
+#ifdef _WIN32
+        sink->fd = _open(filename, _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+        sink->fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+    }
+
+    if (sink->fd < 0) {
+        fprintf(stderr, "Failed to open output file '%s': %s\n", filename, strerror(errno));
+        free(sink);
+        return NULL;
+    }
+
+    if (config->verbose) {
+        printf("Writing %s frames directly, skipping the encoder\n", sink->y4m ? "Y4M" : "raw");
+    }
+    return sink;
+}
+
+#define SHM_RING_MAGIC "SWBSHM01"
+#define SHM_RING_SLOTS 8
+#define SHM_RING_ALIGN 64
+#define SHM_WAIT_MS 100
+
+typedef struct {
+    char magic[8];
+    uint32_t header_size;
+    uint32_t slot_count;
+    int32_t width;
+    int32_t height;
+    int32_t format;
+    int32_t planes;
+    int32_t linesize[4];
+    int32_t plane_height[4];
+    uint64_t plane_offset[4];
+    uint64_t slot_offset;
+    uint64_t slot_size;
+    int32_t frame_rate_num;
+    int32_t frame_rate_den;
+    int32_t time_base_num;
+    int32_t time_base_den;
+    volatile int32_t closed;
+    int32_t reserved;
+    volatile int64_t write_sequence;
+    volatile int64_t read_sequence;
+} ShmRingHeader;
+
+typedef struct {
+    volatile int32_t ready;
+    int32_t reserved;
+    int64_t sequence;
+    int64_t pts;
+} ShmSlotHeader;
+
+struct ShmSink {
+    char name[256];
+#ifdef _WIN32
+    HANDLE mapping;
+#else
+    int fd;
+#endif
+    uint8_t* base;
+    size_t size;
+    ShmRingHeader* header;
+    AVRational frame_rate;
+    AVRational time_base;
+    int64_t sequence;
+    int64_t stalled_us;
+    bool error;
+    bool verbose;
+};
+
+static bool is_shm_output(const char* filename) {
+    return strncmp(filename, "shm:", 4) == 0;
+}
+
+#ifdef _WIN32
+static int32_t shm_flag_load(volatile int32_t* flag) {
+    return InterlockedCompareExchange((volatile LONG*)flag, 0, 0);
+}
+
+static void shm_flag_store(volatile int32_t* flag, int32_t value) {
+    InterlockedExchange((volatile LONG*)flag, value);
+}
+#else
+static int32_t shm_flag_load(volatile int32_t* flag) {
+    return __atomic_load_n(flag, __ATOMIC_ACQUIRE);
+}
+
+static void shm_flag_store(volatile int32_t* flag, int32_t value) {
+    __atomic_store_n(flag, value, __ATOMIC_RELEASE);
+}
+#endif
+
+static void shm_flag_wait(volatile int32_t* flag, int32_t value) {
+#if defined(__linux__)
+    struct timespec timeout = { 0, SHM_WAIT_MS * 1000000L };
+    syscall(SYS_futex, flag, FUTEX_WAIT, value, &timeout, NULL, 0);
+#elif defined(_WIN32)
+    if (shm_flag_load(flag) == value) Sleep(1);
+#else
+    if (shm_flag_load(flag) == value) usleep(1000);
+#endif
+}
+
+static void shm_flag_wake(volatile int32_t* flag) {
+#ifdef __linux__
+    syscall(SYS_futex, flag, FUTEX_WAKE, INT32_MAX, NULL, NULL, 0);
+#else
+    (void)flag;
+#endif
+}
+
+static bool shm_sink_create(ShmSink* sink, const AVFrame* frame) {
+    const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get(frame->format);
+    if (!desc || (desc->flags & AV_PIX_FMT_FLAG_HWACCEL)) {
+        fprintf(stderr, "Shared memory output needs frames in system memory\n");
+        return false;
+    }
+
+    ShmRingHeader layout = { 0 };
+    layout.header_size = sizeof(ShmRingHeader);
+    layout.slot_count = SHM_RING_SLOTS;
+    layout.width = frame->width;
+    layout.height = frame->height;
+    layout.format = frame->format;
+    layout.planes = av_pix_fmt_count_planes(frame->format);
+    layout.frame_rate_num = sink->frame_rate.num;
+    layout.frame_rate_den = sink->frame_rate.den;
+    layout.time_base_num = sink->time_base.num;
+    layout.time_base_den = sink->time_base.den;
+
+    uint64_t offset = FFALIGN(sizeof(ShmSlotHeader), SHM_RING_ALIGN);
+    for (int plane = 0; plane < layout.planes && plane < 4; plane++) {
+        layout.linesize[plane] = FFALIGN(av_image_get_linesize(frame->format, frame->width, plane), SHM_RING_ALIGN);
+        layout.plane_height[plane] = plane == 1 || plane == 2 ?
+            AV_CEIL_RSHIFT(frame->height, desc->log2_chroma_h) : frame->height;
+        layout.plane_offset[plane] = offset;
+        offset += FFALIGN((uint64_t)layout.linesize[plane] * layout.plane_height[plane], SHM_RING_ALIGN);
+    }
+    layout.slot_offset = FFALIGN(sizeof(ShmRingHeader), SHM_RING_ALIGN);
+    layout.slot_size = offset;
+    sink->size = (size_t)(layout.slot_offset + layout.slot_size * SHM_RING_SLOTS);
+
+#ifdef _WIN32
+    char name[300];
+    snprintf(name, sizeof(name), "Local\\%s", sink->name);
+    sink->mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+        (DWORD)((uint64_t)sink->size >> 32), (DWORD)sink->size, name);
+    bool exists = sink->mapping && GetLastError() == ERROR_ALREADY_EXISTS;
+    if (sink->mapping && !exists) {
+        sink->base = (uint8_t*)MapViewOfFile(sink->mapping, FILE_MAP_ALL_ACCESS, 0, 0, sink->size);
+    }
+    if (!sink->base && sink->mapping) {
+        CloseHandle(sink->mapping);
+        sink->mapping = NULL;
+    }
+#else
+    char name[300];
+    snprintf(name, sizeof(name), "/%s", sink->name);
+    sink->fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    bool exists = sink->fd < 0 && errno == EEXIST;
+    if (sink->fd >= 0 && ftruncate(sink->fd, (off_t)sink->size) == 0) {
+        void* map = mmap(NULL, sink->size, PROT_READ | PROT_WRITE, MAP_SHARED, sink->fd, 0);
+        sink->base = map == MAP_FAILED ? NULL : (uint8_t*)map;
+    }
+    if (!sink->base && sink->fd >= 0) {
+        close(sink->fd);
+        shm_unlink(name);
+        sink->fd = -1;
+    }
+#endif
+    if (exists) {
+        fprintf(stderr, "Shared memory ring '%s' already exists; the previous consumer must unlink it first\n", sink->name);
+        return false;
+    }
+    if (!sink->base) {
+        fprintf(stderr, "Failed to create shared memory ring '%s' (%.1f MB)\n", sink->name, sink->size / 1048576.0);
+        return false;
+    }
+
+    memset(sink->base, 0, (size_t)layout.slot_offset);
+    sink->header = (ShmRingHeader*)sink->base;
+    *sink->header = layout;
+
+    uint64_t magic;
+    memcpy(&magic, SHM_RING_MAGIC, sizeof(magic));
+#ifdef _WIN32
+    InterlockedExchange64((volatile LONG64*)sink->header->magic, (LONG64)magic);
+#else
+    __atomic_store_n((volatile uint64_t*)sink->header->magic, magic, __ATOMIC_RELEASE);
+#endif
+
+    if (sink->verbose) {
+        printf("Publishing %dx%d %s frames to shared memory ring '%s': %d slots of %.1f MB\n",
+            frame->width, frame->height, desc->name, sink->name, SHM_RING_SLOTS, layout.slot_size / 1048576.0);
+    }
+    return true;
+}
+
+static bool shm_sink_write_frame(ShmSink* sink, const AVFrame* frame, int64_t pts) {
+    if (sink->error) return false;
+
+    if (!sink->header && !shm_sink_create(sink, frame)) {
+        sink->error = true;
+        return false;
+    }
+
+    ShmRingHeader* header = sink->header;
+    if (frame->width != header->width || frame->height != header->height || frame->format != header->format) {
+        fprintf(stderr, "Shared memory output cannot change frame geometry mid-stream\n");
+        sink->error = true;
+        return false;
+    }
+
+    uint8_t* slot = sink->base + header->slot_offset + (sink->sequence % SHM_RING_SLOTS) * header->slot_size;
+    ShmSlotHeader* slot_header = (ShmSlotHeader*)slot;
+
+    if (shm_flag_load(&slot_header->ready)) {
+        int64_t start = av_gettime_relative();
+        while (shm_flag_load(&slot_header->ready)) {
+            if (is_interrupted()) return false;
+            shm_flag_wait(&slot_header->ready, 1);
+        }
+        sink->stalled_us += av_gettime_relative() - start;
+    }
+
+    for (int plane = 0; plane < header->planes && plane < 4; plane++) {
+        av_image_copy_plane(slot + header->plane_offset[plane], header->linesize[plane],
+            frame->data[plane], frame->linesize[plane],
+            av_image_get_linesize(frame->format, frame->width, plane), header->plane_height[plane]);
+    }
+
+    slot_header->sequence = sink->sequence;
+    slot_header->pts = pts;
+    shm_flag_store(&slot_header->ready, 1);
+    shm_flag_wake(&slot_header->ready);
+
+    sink->sequence++;
+#ifdef _WIN32
+    InterlockedExchange64((volatile LONG64*)&header->write_sequence, sink->sequence);
+#else
+    __atomic_store_n(&header->write_sequence, sink->sequence, __ATOMIC_RELEASE);
+#endif
+    return true;
+}
+
+static void shm_sink_close(ShmSink* sink) {
+    if (!sink) return;
+
+    if (sink->header) {
+        shm_flag_store(&sink->header->closed, 1);
+        shm_flag_wake(&sink->header->closed);
+        for (int i = 0; i < SHM_RING_SLOTS; i++) {
+            shm_flag_wake(&((ShmSlotHeader*)(sink->base + sink->header->slot_offset + i * sink->header->slot_size))->ready);
+        }
+    }
+
+#ifdef _WIN32
+    if (sink->base) UnmapViewOfFile(sink->base);
+    if (sink->mapping) CloseHandle(sink->mapping);
+#else
+    if (sink->base) munmap(sink->base, sink->size);
+    if (sink->fd >= 0) close(sink->fd);
+#endif
+
+    if (sink->verbose) {
+        printf("Shared memory output: %lld frames published, blocked on consumer %.2f s\n",
+            (long long)sink->sequence, sink->stalled_us / 1000000.0);
+    }
+    free(sink);
+}
+
+static ShmSink* shm_sink_open(const char* filename, const BlurConfig* config, double fps) {
+    ShmSink* sink = (ShmSink*)calloc(1, sizeof(ShmSink));
+    if (!sink) return NULL;
+
+    snprintf(sink->name, sizeof(sink->name), "%s", filename + 4);
+#ifndef _WIN32
+    sink->fd = -1;
+#endif
+    sink->frame_rate = av_d2q(fps, 1001000);
+    sink->time_base = av_inv_q(sink->frame_rate);
+    sink->verbose = config->verbose;
+    return sink;
+}
+
+#define IMAGE_SINK_MAX_ENCODERS 32
+#define IMAGE_SINK_START_NUMBER 1
+
+typedef struct {
+    AVFrame* frame;
+    int64_t index;
+} ImageJob;
+
+typedef struct {
+    ImageSink* sink;
+    pthread_t thread;
+    bool started;
+    AVCodecContext* codec_ctx;
+    struct SwsContext* sws_ctx;
+    AVFrame* input;
+    AVFrame* converted;
+    AVPacket* packet;
+} ImageEncoder;
+
+struct ImageSink {
+    char pattern[512];
+    enum AVCodecID codec_id;
+    enum AVPixelFormat pix_fmt;
+    AVRational time_base;
+    ImageEncoder* encoders;
+    int encoder_count;
+    ImageJob* jobs;
+    int capacity;
+    int read_pos;
+    int write_pos;
+    int count;
+    int64_t next_index;
+    int64_t bytes;
+    int64_t encode_us;
+    int64_t blocked_us;
+    bool stopping;
+    bool error;
+    bool verbose;
+#ifdef _WIN32
+    HANDLE mutex;
+    HANDLE not_empty;
+    HANDLE not_full;
+#else
+    pthread_mutex_t mutex;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+#endif
+};
+
+static bool is_image_output(const char* filename) {
+    return is_image_sequence(filename) &&
+        (strstr(filename, ".png") || strstr(filename, ".tif") || strstr(filename, ".tiff"));
+}
+
+static void image_sink_lock(ImageSink* sink) {
+#ifdef _WIN32
+    WaitForSingleObject(sink->mutex, INFINITE);
+#else
+    pthread_mutex_lock(&sink->mutex);
+#endif
+}
+
+static void image_sink_unlock(ImageSink* sink) {
+#ifdef _WIN32
+    ReleaseMutex(sink->mutex);
+#else
+    pthread_mutex_unlock(&sink->mutex);
+#endif
+}
+
+#ifdef _WIN32
+static void image_sink_wait(ImageSink* sink, HANDLE event) {
+    ReleaseMutex(sink->mutex);
+    WaitForSingleObject(event, 10);
+    WaitForSingleObject(sink->mutex, INFINITE);
+}
+
+static void image_sink_signal(HANDLE event) {
+    SetEvent(event);
+}
+#else
+static void image_sink_wait(ImageSink* sink, pthread_cond_t* cond) {
+    pthread_cond_wait(cond, &sink->mutex);
+}
+
+static void image_sink_signal(pthread_cond_t* cond) {
+    pthread_cond_broadcast(cond);
+}
+#endif
+
+static bool image_sink_write_file(ImageSink* sink, int64_t index, const AVPacket* packet) {
+    char path[1024];
+    snprintf(path, sizeof(path), sink->pattern, (int)index);
+
+    FILE* file = fopen(path, "wb");
+    bool written = file && fwrite(packet->data, 1, packet->size, file) == (size_t)packet->size;
+    if (file && fclose(file) != 0) written = false;
+    if (!written) {
+        fprintf(stderr, "Error writing image '%s'\n", path);
+    }
+    return written;
+}
+
+static bool image_sink_encode(ImageEncoder* encoder, int64_t index) {
+    ImageSink* sink = encoder->sink;
+    AVFrame* input = encoder->input;
+    AVFrame* converted = encoder->converted;
+
+    if (!encoder->codec_ctx) {
+        const AVCodec* codec = avcodec_find_encoder(sink->codec_id);
+        encoder->codec_ctx = codec ? avcodec_alloc_context3(codec) : NULL;
+        if (!encoder->codec_ctx) {
+            fprintf(stderr, "Image encoder not available\n");
+            return false;
+        }
+        encoder->codec_ctx->width = input->width;
+        encoder->codec_ctx->height = input->height;
+        encoder->codec_ctx->pix_fmt = sink->pix_fmt;
+        encoder->codec_ctx->time_base = sink->time_base;
+        encoder->codec_ctx->thread_count = 1;
+        if (avcodec_open2(encoder->codec_ctx, codec, NULL) < 0) {
+            fprintf(stderr, "Failed to open image encoder\n");
+            return false;
+        }
+    }
+
+    if (converted->width != input->width || converted->height != input->height) {
+        av_frame_unref(converted);
+        converted->width = input->width;
+        converted->height = input->height;
+        converted->format = sink->pix_fmt;
+        if (av_frame_get_buffer(converted, 32) < 0) {
+            return false;
+        }
+    }
+
+    encoder->sws_ctx = sws_getCachedContext(encoder->sws_ctx, input->width, input->height, input->format,
+        input->width, input->height, sink->pix_fmt, SWS_BILINEAR, NULL, NULL, NULL);
+    if (!encoder->sws_ctx) {
+        return false;
+    }
+    sws_scale(encoder->sws_ctx, (const uint8_t* const*)input->data, input->linesize, 0, input->height,
+        converted->data, converted->linesize);
+    converted->pts = index;
+
+    bool written = avcodec_send_frame(encoder->codec_ctx, converted) >= 0;
+    while (written && avcodec_receive_packet(encoder->codec_ctx, encoder->packet) >= 0) {
+        written = image_sink_write_file(sink, index, encoder->packet);
+        image_sink_lock(sink);
+        sink->bytes += encoder->packet->size;
+        image_sink_unlock(sink);
+        av_packet_unref(encoder->packet);
+    }
+    return written;
+}
+
+static THREAD_FUNC image_sink_worker(void* arg) {
+    ImageEncoder* encoder = (ImageEncoder*)arg;
+    ImageSink* sink = encoder->sink;
+
+    while (true) {
+        image_sink_lock(sink);
+        while (sink->count == 0 && !sink->stopping) {
+#ifdef _WIN32
+            image_sink_wait(sink, sink->not_empty);
+#else
+            image_sink_wait(sink, &sink->not_empty);
+#endif
+        }
+        if (sink->count == 0) {
+            image_sink_unlock(sink);
+            break;
+        }
+
+        ImageJob* job = &sink->jobs[sink->read_pos];
+        AVFrame* frame = job->frame;
+        job->frame = encoder->input;
+        encoder->input = frame;
+        int64_t index = job->index;
+        sink->read_pos = (sink->read_pos + 1) % sink->capacity;
+        sink->count--;
+#ifdef _WIN32
+        image_sink_signal(sink->not_full);
+#else
+        image_sink_signal(&sink->not_full);
+#endif
+        image_sink_unlock(sink);
+
+        int64_t start = av_gettime_relative();
+        bool written = image_sink_encode(encoder, index);
+        int64_t elapsed = av_gettime_relative() - start;
+
+        image_sink_lock(sink);
+        sink->encode_us += elapsed;
+        if (!written) sink->error = true;
+        image_sink_unlock(sink);
+    }
+
+#ifdef _WIN32
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+static bool image_sink_write_frame(ImageSink* sink, const AVFrame* frame) {
+    image_sink_lock(sink);
+    if (sink->count == sink->capacity) {
+        int64_t start = av_gettime_relative();
+        while (sink->count == sink->capacity && !sink->error) {
+#ifdef _WIN32
+            image_sink_wait(sink, sink->not_full);
+#else
+            image_sink_wait(sink, &sink->not_full);
+#endif
+        }
+        sink->blocked_us += av_gettime_relative() - start;
+    }
+    bool failed = sink->error;
+    image_sink_unlock(sink);
+    if (failed) return false;
+
+    ImageJob* job = &sink->jobs[sink->write_pos];
+    AVFrame* copy = job->frame;
+    if (copy->width != frame->width || copy->height != frame->height || copy->format != frame->format) {
+        av_frame_unref(copy);
+        copy->width = frame->width;
+        copy->height = frame->height;
+        copy->format = frame->format;
+        if (av_frame_get_buffer(copy, 32) < 0) {
+            sink->error = true;
+            return false;
+        }
+    }
+    av_frame_copy(copy, frame);
+    job->index = sink->next_index++;
+
+    image_sink_lock(sink);
+    sink->write_pos = (sink->write_pos + 1) % sink->capacity;
+    sink->count++;
+#ifdef _WIN32
+    image_sink_signal(sink->not_empty);
+#else
+    image_sink_signal(&sink->not_empty);
+#endif
+    image_sink_unlock(sink);
+    return true;
+}
+
+static bool image_sink_finish(ImageSink* sink) {
+    image_sink_lock(sink);
+    sink->stopping = true;
+#ifdef _WIN32
+    image_sink_signal(sink->not_empty);
+#else
+    image_sink_signal(&sink->not_empty);
+#endif
+    image_sink_unlock(sink);
+
+    for (int i = 0; i < sink->encoder_count; i++) {
+        if (!sink->encoders[i].started) continue;
+#ifdef _WIN32
+        WaitForSingleObject(sink->encoders[i].thread, INFINITE);
+        CloseHandle(sink->encoders[i].thread);
+#else
+        pthread_join(sink->encoders[i].thread, NULL);
+#endif
+        sink->encoders[i].started = false;
+    }
+    return !sink->error;
+}
+
+static void image_sink_close(ImageSink* sink) {
+    if (!sink) return;
+
+    if (sink->encoders) {
+        image_sink_finish(sink);
+        for (int i = 0; i < sink->encoder_count; i++) {
+            ImageEncoder* encoder = &sink->encoders[i];
+            avcodec_free_context(&encoder->codec_ctx);
+            if (encoder->sws_ctx) sws_freeContext(encoder->sws_ctx);
+            av_frame_free(&encoder->input);
+            av_frame_free(&encoder->converted);
+            av_packet_free(&encoder->packet);
+        }
+        free(sink->encoders);
+    }
+
+    if (sink->jobs) {
+        for (int i = 0; i < sink->capacity; i++) {
+            av_frame_free(&sink->jobs[i].frame);
+        }
+        free(sink->jobs);
+    }
+
+    if (sink->verbose) {
+        printf("Image output: %lld frames, %.1f MB on %d encoders, %.2f s encoding, blend blocked %.2f s\n",
+            (long long)(sink->next_index - IMAGE_SINK_START_NUMBER), sink->bytes / 1048576.0,
+            sink->encoder_count, sink->encode_us / 1000000.0, sink->blocked_us / 1000000.0);
+    }
+
+#ifdef _WIN32
+    if (sink->mutex) CloseHandle(sink->mutex);
+    if (sink->not_empty) CloseHandle(sink->not_empty);
+    if (sink->not_full) CloseHandle(sink->not_full);
+#else
+    pthread_mutex_destroy(&sink->mutex);
+    pthread_cond_destroy(&sink->not_empty);
+    pthread_cond_destroy(&sink->not_full);
+#endif
+    free(sink);
+}
+
+static ImageSink* image_sink_open(const char* filename, const BlurConfig* config, double fps) {
+    ImageSink* sink = (ImageSink*)calloc(1, sizeof(ImageSink));
+    if (!sink) return NULL;
+
+#ifdef _WIN32
+    sink->mutex = CreateMutex(NULL, FALSE, NULL);
+    sink->not_empty = CreateEvent(NULL, FALSE, FALSE, NULL);
+    sink->not_full = CreateEvent(NULL, FALSE, FALSE, NULL);
+#else
+    pthread_mutex_init(&sink->mutex, NULL);
+    pthread_cond_init(&sink->not_empty, NULL);
+    pthread_cond_init(&sink->not_full, NULL);
+#endif
+
+    snprintf(sink->pattern, sizeof(sink->pattern), "%s", filename);
+    sink->codec_id = strstr(filename, ".png") ? AV_CODEC_ID_PNG : AV_CODEC_ID_TIFF;
+    sink->pix_fmt = AV_PIX_FMT_RGB24;
+    sink->time_base = av_inv_q(av_d2q(fps, 1001000));
+    sink->next_index = IMAGE_SINK_START_NUMBER;
+    sink->verbose = config->verbose;
+
+    sink->encoder_count = config->threads > 0 ? config->threads : get_cpu_count();
+    if (sink->encoder_count > IMAGE_SINK_MAX_ENCODERS) sink->encoder_count = IMAGE_SINK_MAX_ENCODERS;
+    sink->capacity = sink->encoder_count * 2;
+    sink->encoders = (ImageEncoder*)calloc(sink->encoder_count, sizeof(ImageEncoder));
+    sink->jobs = (ImageJob*)calloc(sink->capacity, sizeof(ImageJob));
+    if (!sink->encoders || !sink->jobs) {
+        image_sink_close(sink);
+        return NULL;
+    }
+
+    for (int i = 0; i < sink->capacity; i++) {
+        sink->jobs[i].frame = av_frame_alloc();
+        if (!sink->jobs[i].frame) {
+            image_sink_close(sink);
+            return NULL;
+        }
+    }
+
+    int started = 0;
+    for (int i = 0; i < sink->encoder_count; i++) {
+        ImageEncoder* encoder = &sink->encoders[i];
+        encoder->sink = sink;
+        encoder->input = av_frame_alloc();
+        encoder->converted = av_frame_alloc();
+        encoder->packet = av_packet_alloc();
+        if (!encoder->input || !encoder->converted || !encoder->packet) {
+            break;
+        }
+#ifdef _WIN32
+        encoder->thread = CreateThread(NULL, 0, image_sink_worker, encoder, 0, NULL);
+        encoder->started = encoder->thread != NULL;
+#else
+        encoder->started = pthread_create(&encoder->thread, NULL, image_sink_worker, encoder) == 0;
+#endif
+        started += encoder->started;
+    }
+
+    if (started == 0) {
+        fprintf(stderr, "Failed to create image encoder threads\n");
+        image_sink_close(sink);
+        return NULL;
+    }
+
+    if (config->verbose) {
+        printf("Writing %s image sequence '%s' on %d encoder threads\n",
+            sink->codec_id == AV_CODEC_ID_PNG ? "PNG" : "TIFF", sink->pattern, started);
+    }
+    return sink;
+}
+
+static bool is_pipe_path(const char* path) {
+    return strcmp(path, "-") == 0 || strncmp(path, "pipe:", 5) == 0;
+}
+
+#define Y4M_MAGIC "YUV4MPEG2 "
+#define Y4M_MAX_HEADER 256
+
+struct RawSource {
+    int fd;
+    bool y4m;
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#endif
+    uint8_t* map;
+    int64_t size;
+    int64_t position;
+    int width;
+    int height;
+    AVRational frame_rate;
+    size_t frame_size;
+    int64_t frame_count;
+    int64_t frames_read;
+    bool reached_end;
+    bool verbose;
+};
+
+static bool uses_raw_input(const BlurConfig* config) {
+    if (strcmp(config->raw_input, "ffmpeg") == 0) return false;
+    if (strcmp(config->raw_input, "auto") == 0) {
+        return !is_pipe_path(config->input_file) && strstr(config->input_file, ".y4m") != NULL;
+    }
+    return true;
+}
+
+static bool raw_source_parse_y4m(RawSource* source, char* header) {
+    if (strncmp(header, Y4M_MAGIC, strlen(Y4M_MAGIC)) != 0) {
+        fprintf(stderr, "Input is not a YUV4MPEG2 stream\n");
+        return false;
+    }
+
+    char* token = header + strlen(Y4M_MAGIC);
+    while (*token) {
+        while (*token == ' ') token++;
+        size_t length = strcspn(token, " ");
+        if (length == 0) break;
+
+        switch (token[0]) {
+        case 'W': source->width = atoi(token + 1); break;
+        case 'H': source->height = atoi(token + 1); break;
+        case 'F':
+            if (sscanf(token + 1, "%d:%d", &source->frame_rate.num, &source->frame_rate.den) != 2) {
+                source->frame_rate = av_make_q(0, 0);
+            }
+            break;
+        case 'C': {
+            char colorspace[16];
+            snprintf(colorspace, sizeof(colorspace), "%.*s", (int)length - 1, token + 1);
+            if (strcmp(colorspace, "420jpeg") != 0 && strcmp(colorspace, "420paldv") != 0 &&
+                strcmp(colorspace, "420mpeg2") != 0 && strcmp(colorspace, "420") != 0) {
+                fprintf(stderr, "Unsupported Y4M colorspace '%s', only 8-bit 4:2:0 can be read directly\n",
+                    colorspace);
+                return false;
+            }
+            break;
+        }
+        case 'I':
+            if (token[1] != 'p' && token[1] != '?' && source->verbose) {
+                printf("Y4M input is interlaced, treating frames as progressive\n");
+            }
+            break;
+        default:
+            break;
+        }
+        token += length;
+    }
+    return true;
+}
+
+static bool raw_source_read(RawSource* source, uint8_t* data, size_t size) {
+    while (size > 0) {
+#ifdef _WIN32
+        int count = _read(source->fd, data, (unsigned int)(size > (1u << 30) ? (1u << 30) : size));
+#else
+        ssize_t count = read(source->fd, data, size);
+        if (count < 0 && errno == EINTR) continue;
+#endif
+        if (count <= 0) {
+            if (count < 0) {
+                fprintf(stderr, "Error reading raw input: %s\n", strerror(errno));
+            }
+            return false;
+        }
+        data += count;
+        size -= count;
+    }
+    return true;
+}
+
+static bool raw_source_read_line(RawSource* source, char* line, size_t capacity, size_t length) {
+    while (length == 0 || line[length - 1] != '\n') {
+        if (length + 1 >= capacity || !raw_source_read(source, (uint8_t*)line + length, 1)) {
+            return false;
+        }
+        length++;
+    }
+    line[length - 1] = '\0';
+    return true;
+}
+
+static bool raw_source_map(RawSource* source, const char* filename) {
+#ifdef _WIN32
+    source->file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+        FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    LARGE_INTEGER size;
+    if (source->file == INVALID_HANDLE_VALUE || !GetFileSizeEx(source->file, &size)) {
+        return false;
+    }
+    source->size = size.QuadPart;
+    source->mapping = source->size > 0 ? CreateFileMapping(source->file, NULL, PAGE_READONLY, 0, 0, NULL) : NULL;
+    source->map = source->mapping ? (uint8_t*)MapViewOfFile(source->mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+    return source->map != NULL;
+#else
+    source->fd = open(filename, O_RDONLY);
+    struct stat st;
+    if (source->fd < 0 || fstat(source->fd, &st) != 0 || st.st_size == 0) {
+        return false;
+    }
+    source->size = st.st_size;
+    void* map = mmap(NULL, (size_t)source->size, PROT_READ, MAP_SHARED, source->fd, 0);
+    if (map == MAP_FAILED) {
+        return false;
+    }
+    madvise(map, (size_t)source->size, MADV_SEQUENTIAL);
+    source->map = (uint8_t*)map;
+    return true;
+#endif
+}
+
+static void raw_source_close(RawSource* source) {
+    if (!source) return;
+
+#ifdef _WIN32
+    if (source->map) UnmapViewOfFile(source->map);
+    if (source->mapping) CloseHandle(source->mapping);
+    if (source->file && source->file != INVALID_HANDLE_VALUE) CloseHandle(source->file);
+#else
+    if (source->map) munmap(source->map, (size_t)source->size);
+    if (source->fd > 0) close(source->fd);
+#endif
+    free(source);
+}
+
+static RawSource* raw_source_open(const char* filename, const BlurConfig* config) {
+    RawSource* source = (RawSource*)calloc(1, sizeof(RawSource));
+    if (!source) return NULL;
+
+    bool pipe = is_pipe_path(filename);
+    source->fd = -1;
+    source->y4m = strcmp(config->raw_input, "y4m") == 0 ||
+        (strcmp(config->raw_input, "auto") == 0 && strstr(filename, ".y4m"));
+    source->verbose = config->verbose;
+
+    if (pipe) {
+        source->fd = 0;
+#ifdef _WIN32
+        _setmode(source->fd, _O_BINARY);
+#endif
+    }
+    else if (!raw_source_map(source, filename)) {
+        fprintf(stderr, "Error mapping raw input file '%s'\n", filename);
+        raw_source_close(source);
+        return NULL;
+    }
+
+    if (source->y4m) {
+        char header[Y4M_MAX_HEADER];
+        bool read;
+        if (pipe) {
+            read = raw_source_read_line(source, header, sizeof(header), 0);
+        }
+        else {
+            const uint8_t* end = (const uint8_t*)memchr(source->map, '\n',
+                (size_t)FFMIN(source->size, (int64_t)sizeof(header)));
+            read = end != NULL;
+            if (read) {
+                source->position = end - source->map + 1;
+                memcpy(header, source->map, (size_t)source->position - 1);
+                header[source->position - 1] = '\0';
+            }
+        }
+
+        source->frame_rate = av_make_q(0, 0);
+        if (!read || !raw_source_parse_y4m(source, header)) {
+            fprintf(stderr, "Invalid Y4M header in '%s'\n", filename);
+            raw_source_close(source);
+            return NULL;
+        }
+    }
+    else {
+        char rate[16] = "";
+        sscanf(config->raw_input, "%dx%d@%15s", &source->width, &source->height, rate);
+        if (av_parse_video_rate(&source->frame_rate, rate) < 0) {
+            source->frame_rate = av_make_q(0, 0);
+        }
+    }
+
+    if (source->width <= 0 || source->height <= 0 || source->frame_rate.num <= 0 || source->frame_rate.den <= 0) {
+        fprintf(stderr, "Raw input needs a frame size and frame rate\n");
+        raw_source_close(source);
+        return NULL;
+    }
+    if (source->width % 2 != 0 || source->height % 2 != 0) {
+        fprintf(stderr, "Raw input dimensions must be even, got %dx%d\n", source->width, source->height);
+        raw_source_close(source);
+        return NULL;
+    }
+
+    source->frame_size = (size_t)source->width * source->height * 3 / 2;
+    if (!pipe) {
+        int64_t stride = (int64_t)source->frame_size + (source->y4m ? 6 : 0);
+        source->frame_count = (source->size - source->position) / stride;
+    }
+
+    if (config->verbose) {
+        printf("Reading %s input natively: %dx%d @ %d/%d, %s\n", source->y4m ? "Y4M" : "raw yuv420p",
+            source->width, source->height, source->frame_rate.num, source->frame_rate.den,
+            pipe ? "pipe" : "memory mapped");
+    }
+    return source;
+}
+
+static void raw_source_release_view(void* opaque) {
+    (void)opaque;
+}
+
+static void raw_source_release_block(void* opaque) {
+    av_free(opaque);
+}
+
+static void raw_source_layout(RawSource* source, uint8_t* frame, FrameBuffer* buffer) {
+    int width = source->width;
+    int height = source->height;
+
+    buffer->data[0] = frame;
+    buffer->data[1] = frame + (size_t)width * height;
+    buffer->data[2] = buffer->data[1] + (size_t)(width / 2) * (height / 2);
+    buffer->linesize[0] = width;
+    buffer->linesize[1] = width / 2;
+    buffer->linesize[2] = width / 2;
+    buffer->width = width;
+    buffer->height = height;
+    buffer->format = AV_PIX_FMT_YUV420P;
+    buffer->allocated = true;
+}
+
+static bool raw_source_wrap(FrameBuffer* buffer) {
+    buffer->data = (uint8_t**)av_mallocz(4 * sizeof(uint8_t*));
+    buffer->linesize = (int*)av_mallocz(4 * sizeof(int));
+    if (!buffer->data || !buffer->linesize) {
+        av_freep(&buffer->data);
+        av_freep(&buffer->linesize);
+        return false;
+    }
+    return true;
+}
+
+static bool raw_source_next_mapped(RawSource* source, FrameBuffer* buffer) {
+    int64_t position = source->position;
+    if (source->y4m) {
+        int64_t available = source->size - position;
+        const uint8_t* end = available > 5 && memcmp(source->map + position, "FRAME", 5) == 0 ?
+            (const uint8_t*)memchr(source->map + position, '\n', (size_t)FFMIN(available, Y4M_MAX_HEADER)) : NULL;
+        if (!end) {
+            return false;
+        }
+        position = end - source->map + 1;
+    }
+    if (source->size - position < (int64_t)source->frame_size) {
+        return false;
+    }
+
+    frame_buffer_free(buffer);
+    if (!raw_source_wrap(buffer)) {
+        return false;
+    }
+    raw_source_layout(source, source->map + position, buffer);
+    buffer->release = raw_source_release_view;
+    buffer->opaque = NULL;
+    source->position = position + (int64_t)source->frame_size;
+    return true;
+}
+
+static bool raw_source_next_piped(RawSource* source, FrameBuffer* buffer) {
+    if (buffer->release != raw_source_release_block) {
+        frame_buffer_free(buffer);
+        uint8_t* block = (uint8_t*)av_malloc(source->frame_size);
+        if (!block || !raw_source_wrap(buffer)) {
+            av_free(block);
+            return false;
+        }
+        raw_source_layout(source, block, buffer);
+        buffer->release = raw_source_release_block;
+        buffer->opaque = block;
+    }
+
+    if (source->y4m) {
+        char header[Y4M_MAX_HEADER];
+        if (!raw_source_read(source, (uint8_t*)header, 6) ||
+            !raw_source_read_line(source, header, sizeof(header), 6) ||
+            strncmp(header, "FRAME", 5) != 0) {
+            return false;
+        }
+    }
+    return raw_source_read(source, (uint8_t*)buffer->opaque, source->frame_size);
+}
+
+static bool raw_source_next(RawSource* source, FrameBuffer* buffer) {
+    bool read = source->map ? raw_source_next_mapped(source, buffer) : raw_source_next_piped(source, buffer);
+    if (!read) {
+        source->reached_end = true;
+        return false;
+    }
+    buffer->pts = source->frames_read++;
+    return true;
+}
+
+static bool uses_decoder_motion(const BlurConfig* config) {
+    bool needs_motion = strcmp(config->blur_mode, "vector") == 0 ||
+        (config->interpolate && strcmp(config->interpolation_method, "blend") != 0);
+    return needs_motion && strcmp(config->motion_vectors, "search") != 0;
+}
+
+static bool open_input_video(VideoContext* ctx, const char* filename, const BlurConfig* config) {
+    int ret;
+
+    ctx->fmt_ctx = NULL;
+    if (strcmp(config->input_io, "default") != 0) {
+        ctx->input_io = input_io_open(filename, config->input_io, config->verbose);
+        ctx->fmt_ctx = ctx->input_io ? avformat_alloc_context() : NULL;
+        if (ctx->fmt_ctx) {
+            ctx->fmt_ctx->pb = ctx->input_io->avio;
+            ctx->fmt_ctx->flags |= AVFMT_FLAG_CUSTOM_IO;
+        }
+        else {
+            fprintf(stderr, "Warning: Custom input I/O unavailable, using default file reads\n");
+            input_io_close(ctx->input_io);
+            ctx->input_io = NULL;
+        }
+    }
+
+    ret = avformat_open_input(&ctx->fmt_ctx, is_pipe_path(filename) ? "pipe:0" : filename, NULL, NULL);
+    if (ret < 0) {
+        char errbuf[AV_ERROR_MAX_STRING_SIZE];
+        av_strerror(ret, errbuf, AV_ERROR_MAX_STRING_SIZE);
+        fprintf(stderr, "Error opening input file '%s': %s\n", filename, errbuf);
+        input_io_close(ctx->input_io);
+        ctx->input_io = NULL;
+        return false;
+    }
+
+    ret = avformat_find_stream_info(ctx->fmt_ctx, NULL);
+    if (ret < 0) {
+        fprintf(stderr, "Error finding stream information\n");
+        return false;
+    }
+
+    ctx->video_stream_idx = -1;
+    ctx->audio_stream_idx = -1;
+
+    for (unsigned int i = 0; i < ctx->fmt_ctx->nb_streams; i++) {
+        if (ctx->fmt_ctx->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_VIDEO &&
+            ctx->video_stream_idx == -1) {
+            ctx->video_stream_idx = i;
+            ctx->video_stream = ctx->fmt_ctx->streams[i];
+        }
+        else if (ctx->fmt_ctx->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_AUDIO &&
+            ctx->audio_stream_idx == -1) {
+            ctx->audio_stream_idx = i;
+            ctx->audio_stream = ctx->fmt_ctx->streams[i];
+        }
+    }
+
+    if (ctx->video_stream_idx == -1) {
+        fprintf(stderr, "No video stream found in input file\n");
+        return false;
+    }
+
+    const char* codec_name = NULL;
+    if (config->gpu_decoding) {
+        enum AVHWDeviceType hw_type = get_hw_device_type(config->gpu_type);
+        if (hw_type != AV_HWDEVICE_TYPE_NONE) {
+            ret = av_hwdevice_ctx_create(&ctx->hw_device_ctx, hw_type, NULL, NULL, 0);
+            if (ret < 0) {
+                if (config->verbose) {
+                    fprintf(stderr, "Warning: Failed to create hardware device context, using software decoding\n");
+                }
+                ctx->hw_device_ctx = NULL;
+            }
+            else {
+                codec_name = get_hw_codec_name(
+                    avcodec_get_name(ctx->video_stream->codecpar->codec_id),
+                    config->gpu_type, false);
+                if (config->verbose) {
+                    printf("Using hardware decoder: %s\n", codec_name);
+                }
+            }
+        }
+    }
+
+    const AVCodec* codec = codec_name ?
+        avcodec_find_decoder_by_name(codec_name) :
+        avcodec_find_decoder(ctx->video_stream->codecpar->codec_id);
+
+    if (!codec) {
+        fprintf(stderr, "Codec not found for stream\n");
+        return false;
+    }
+
+    ctx->codec_ctx = avcodec_alloc_context3(codec);
+    if (!ctx->codec_ctx) {
+        fprintf(stderr, "Failed to allocate codec context\n");
+        return false;
+    }
+
+    ret = avcodec_parameters_to_context(ctx->codec_ctx, ctx->video_stream->codecpar);
+    if (ret < 0) {
+        fprintf(stderr, "Failed to copy codec parameters to decoder context\n");
+        return false;
+    }
+
+    if (ctx->hw_device_ctx) {
+        ctx->codec_ctx->hw_device_ctx = av_buffer_ref(ctx->hw_device_ctx);
+    }
+
+    if (config->threads > 0) {
+        ctx->codec_ctx->thread_count = config->threads;
+        ctx->codec_ctx->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+    }
+
+    bool needs_motion = uses_decoder_motion(config);
+    for (int i = 0; i < config->job_count; i++) {
+        needs_motion = needs_motion || uses_decoder_motion(&config->jobs[i]);
+    }
+    if (needs_motion && !ctx->hw_device_ctx) {
+        av_opt_set(ctx->codec_ctx, "flags2", "+export_mvs", 0);
+        if (config->verbose) {
+            printf("Exporting decoder motion vectors\n");
+        }
+    }
+
+    ret = avcodec_open2(ctx->codec_ctx, codec, NULL);
+    if (ret < 0) {
+        fprintf(stderr, "Failed to open codec\n");
+        return false;
+    }
+
+    ctx->frame = av_frame_alloc();
+    ctx->packet = av_packet_alloc();
+
+    if (!ctx->frame || !ctx->packet) {
+        fprintf(stderr, "Failed to allocate frame or packet\n");
+        return false;
+    }
+
+    return true;
+}
+
+static bool create_output_video(VideoContext* ctx, const char* filename, const BlurConfig* config,
+    int width, int height, double fps) {
+    int ret;
+
+    if (is_image_output(filename)) {
+        ctx->audio_stream_idx = -1;
+        ctx->next_pts = AV_NOPTS_VALUE;
+        ctx->image_sink = image_sink_open(filename, config, fps);
+        return ctx->image_sink != NULL;
+    }
+
+    if (is_shm_output(filename)) {
+        ctx->audio_stream_idx = -1;
+        ctx->next_pts = AV_NOPTS_VALUE;
+        ctx->shm_sink = shm_sink_open(filename, config, fps);
+        return ctx->shm_sink != NULL;
+    }
+
+    if (is_raw_output(filename, config)) {
+        ctx->audio_stream_idx = -1;
+        ctx->next_pts = AV_NOPTS_VALUE;
+        ctx->raw_sink = raw_sink_open(filename, config, fps);
+        return ctx->raw_sink != NULL;
+    }
+
+    const char* format_name = NULL;
+    if (strstr(filename, ".m3u8")) format_name = "hls";
+    else if (strstr(filename, ".mp4")) format_name = "mp4";
+    else if (strstr(filename, ".mkv")) format_name = "matroska";
+    else if (strstr(filename, ".avi")) format_name = "avi";
+    else if (strstr(filename, ".mov")) format_name = "mov";
+    else if (strcmp(config->container, "mkv") == 0) format_name = "matroska";
+    else format_name = config->container;
+    bool hls = format_name && strcmp(format_name, "hls") == 0;
+    bool pipe = is_pipe_path(filename);
+    bool mp4 = strcmp(format_name, "mp4") == 0 || strcmp(format_name, "mov") == 0;
+
+    double fragment_duration = config->fragment_duration;
+    if (pipe && mp4 && fragment_duration <= 0) {
+        fragment_duration = 1.0;
+    }
+
+    ret = avformat_alloc_output_context2(&ctx->fmt_ctx, NULL, format_name, filename);
+    if (!ctx->fmt_ctx) {
+        fprintf(stderr, "Failed to create output format context\n");
+        return false;
+    }
+
+    const char* codec_name = get_sw_encoder_name(config->codec);
+    if (config->gpu_encoding) {
+        codec_name = get_hw_codec_name(config->codec, config->gpu_type, true);
+        if (config->verbose) {
+            printf("Using hardware encoder: %s\n", codec_name);
+        }
+    }
+
+    const AVCodec* codec = avcodec_find_encoder_by_name(codec_name);
+    if (!codec) {
+        codec = avcodec_find_encoder(get_codec_id(config->codec));
+        if (!codec) {
+            codec = avcodec_find_encoder(AV_CODEC_ID_H264);
+        }
+    }
+
+    if (!codec) {
+        fprintf(stderr, "Encoder not found\n");
+        return false;
+    }
+
+    if (config->verbose && !config->gpu_encoding) {
+        printf("Using encoder: %s\n", codec->name);
+    }
+
+    ctx->video_stream = avformat_new_stream(ctx->fmt_ctx, codec);
+    if (!ctx->video_stream) {
+        fprintf(stderr, "Failed to create output video stream\n");
+        return false;
+    }
+
+    ctx->codec_ctx = avcodec_alloc_context3(codec);
+    if (!ctx->codec_ctx) {
+        fprintf(stderr, "Failed to allocate encoder context\n");
+        return false;
+    }
+
+    ctx->codec_ctx->width = width;
+    ctx->codec_ctx->height = height;
+    AVRational frame_rate = av_d2q(fps, 1001000);
+    ctx->codec_ctx->time_base = av_inv_q(frame_rate);
+    ctx->codec_ctx->framerate = frame_rate;
+    ctx->next_pts = AV_NOPTS_VALUE;
+    ctx->codec_ctx->gop_size = (int)(fps * 2);
+    if (fragment_duration > 0) {
+        double gop_seconds = hls ? FFMIN(fragment_duration, 2.0) : fragment_duration;
+        ctx->codec_ctx->gop_size = FFMAX(1, (int)(fps * gop_seconds + 0.5));
+    }
+    ctx->codec_ctx->max_b_frames = 2;
+    ctx->codec_ctx->pix_fmt = get_pixel_format(config->pixel_format);
+
+    if (config->gpu_encoding && g_input_ctx && g_input_ctx->hw_device_ctx) {
+        ctx->codec_ctx->hw_device_ctx = av_buffer_ref(g_input_ctx->hw_device_ctx);
+    }
+
+    if (config->bitrate > 0) {
+        ctx->codec_ctx->bit_rate = config->bitrate * 1000;
+        ctx->codec_ctx->rc_max_rate = config->bitrate * 1200;
+        ctx->codec_ctx->rc_buffer_size = config->bitrate * 2000;
+    }
+    else {
+        if (av_opt_set_int(ctx->codec_ctx->priv_data, "crf", config->quality, 0) < 0) {
+            ctx->codec_ctx->qmin = config->quality;
+            ctx->codec_ctx->qmax = config->quality + 10;
+        }
+    }
+
+    if (config->threads > 0) {
+        ctx->codec_ctx->thread_count = config->threads;
+    }
+
+    if (!config->gpu_encoding) {
+        configure_sw_encoder(ctx->codec_ctx, codec, config);
+    }
+
+    if (ctx->fmt_ctx->oformat->flags & AVFMT_GLOBALHEADER) {
+        ctx->codec_ctx->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+    }
+
+    if (config->gpu_encoding) {
+        av_opt_set(ctx->codec_ctx->priv_data, "preset", "fast", 0);
+        av_opt_set(ctx->codec_ctx->priv_data, "tune", "zerolatency", 0);
+    }
+
+    ret = avcodec_open2(ctx->codec_ctx, codec, NULL);
+    if (ret < 0) {
+        char errbuf[AV_ERROR_MAX_STRING_SIZE];
+        av_strerror(ret, errbuf, AV_ERROR_MAX_STRING_SIZE);
+        fprintf(stderr, "Failed to open encoder: %s\n", errbuf);
+        return false;
+    }
+
+    ret = avcodec_parameters_from_context(ctx->video_stream->codecpar, ctx->codec_ctx);
+    if (ret < 0) {
+        fprintf(stderr, "Failed to copy encoder parameters to stream\n");
+        return false;
+    }
+
+    ctx->video_stream->time_base = ctx->codec_ctx->time_base;
+    ctx->video_stream->avg_frame_rate = frame_rate;
+
+    if (g_input_ctx && g_input_ctx->audio_stream_idx >= 0) {
+        AVStream* in_stream = g_input_ctx->fmt_ctx->streams[g_input_ctx->audio_stream_idx];
+        AVStream* out_stream = avformat_new_stream(ctx->fmt_ctx, NULL);
+
+        if (out_stream) {
+            ret = avcodec_parameters_copy(out_stream->codecpar, in_stream->codecpar);
+            if (ret >= 0) {
+                out_stream->time_base = in_stream->time_base;
+                if (config->timescale != 1.0) {
+                    out_stream->time_base.den = (int)(out_stream->time_base.den * config->timescale);
+                }
+                ctx->audio_stream = out_stream;
+                ctx->audio_stream_idx = out_stream->index;
+                if (config->verbose) {
+                    printf("Copying audio stream\n");
+                }
+            }
+        }
+    }
+
+    if (fragment_duration > 0 && !hls) {
+        char frag_duration[32];
+        snprintf(frag_duration, sizeof(frag_duration), "%lld", (long long)(fragment_duration * 1000000.0));
+        av_opt_set(ctx->fmt_ctx->priv_data, "movflags", "+frag_keyframe+empty_moov+default_base_moof", 0);
+        av_opt_set(ctx->fmt_ctx->priv_data, "frag_duration", frag_duration, 0);
+        if (config->verbose) {
+            printf("Writing fragmented output, %.2f s per fragment\n", fragment_duration);
+        }
+    }
+
+    if (pipe) {
+        if (strcmp(format_name, "matroska") == 0) {
+            av_opt_set_int(ctx->fmt_ctx->priv_data, "live", 1, 0);
+        }
+        ctx->fmt_ctx->flush_packets = 1;
+        if (config->verbose) {
+            printf("Streaming %s to stdout\n", format_name);
+        }
+    }
+
+    if (hls) {
+        char segment_pattern[600];
+        char init_name[600];
+        size_t base_len = strlen(filename) - strlen(strstr(filename, ".m3u8"));
+        const char* base_name = strrchr(filename, '/');
+        const char* alt_name = strrchr(filename, '\\');
+        if (!base_name || (alt_name && alt_name > base_name)) base_name = alt_name;
+        base_name = base_name ? base_name + 1 : filename;
+
+        snprintf(segment_pattern, sizeof(segment_pattern), "%.*s_%%05d.m4s", (int)base_len, filename);
+        snprintf(init_name, sizeof(init_name), "%.*s_init.mp4", (int)(filename + base_len - base_name), base_name);
+
+        char segment_time[32];
+        snprintf(segment_time, sizeof(segment_time), "%g", config->fragment_duration > 0 ? config->fragment_duration : 4.0);
+
+        av_opt_set(ctx->fmt_ctx->priv_data, "hls_segment_type", "fmp4", 0);
+        av_opt_set(ctx->fmt_ctx->priv_data, "hls_time", segment_time, 0);
+        av_opt_set_int(ctx->fmt_ctx->priv_data, "hls_list_size", 0, 0);
+        av_opt_set(ctx->fmt_ctx->priv_data, "hls_playlist_type", "event", 0);
+        av_opt_set(ctx->fmt_ctx->priv_data, "hls_flags", "+independent_segments+temp_file", 0);
+        av_opt_set(ctx->fmt_ctx->priv_data, "hls_segment_filename", segment_pattern, 0);
+        av_opt_set(ctx->fmt_ctx->priv_data, "hls_fmp4_init_filename", init_name, 0);
+        if (config->verbose) {
+            printf("Writing HLS fMP4 segments: %s\n", segment_pattern);
+        }
+    }
+
+    bool needs_file = (ctx->fmt_ctx->oformat->flags & AVFMT_NOFILE) == 0;
+    if (needs_file && !pipe && strcmp(config->output_io, "writeback") == 0) {
+        ctx->output_io = output_io_open(filename, config->verbose);
+        if (ctx->output_io) {
+            ctx->fmt_ctx->pb = ctx->output_io->avio;
+            ctx->fmt_ctx->flags |= AVFMT_FLAG_CUSTOM_IO;
+        }
+        else {
+            fprintf(stderr, "Warning: Write-behind output unavailable, using default file writes\n");
+        }
+    }
+
+    ret = needs_file && !ctx->output_io ? avio_open(&ctx->fmt_ctx->pb, filename, AVIO_FLAG_WRITE) : 0;
+    if (ret < 0) {
+        char errbuf[AV_ERROR_MAX_STRING_SIZE];
+        av_strerror(ret, errbuf, AV_ERROR_MAX_STRING_SIZE);
+        fprintf(stderr, "Failed to open output file '%s': %s\n", filename, errbuf);
+        return false;
+    }
+
+    ret = avformat_write_header(ctx->fmt_ctx, NULL);
+    if (ret < 0) {
+        char errbuf[AV_ERROR_MAX_STRING_SIZE];
+        av_strerror(ret, errbuf, AV_ERROR_MAX_STRING_SIZE);
+        fprintf(stderr, "Failed to write output header: %s\n", errbuf);
+        return false;
+    }
+
+    ctx->frame = av_frame_alloc();
+    ctx->packet = av_packet_alloc();
+
+    return true;
+}
+
+#ifdef HAVE_VAPOURSYNTH
+static bool init_vapoursynth(VapourSynthContext* vs_ctx) {
+#ifdef _WIN32
+    vs_ctx->library = LoadLibrary(L"vapoursynth.dll");
+#else
+    vs_ctx->library = dlopen("libvapoursynth.so", RTLD_LAZY);
+#endif
+
+    if (!vs_ctx->library) {
+        return false;
+    }
+
+    typedef const VSAPI* (*VSGetAPIFunc)(int version);
+    VSGetAPIFunc getVapourSynthAPI;
+
+#ifdef _WIN32
+    getVapourSynthAPI = (VSGetAPIFunc)GetProcAddress(vs_ctx->library, "getVapourSynthAPI");
+#else
+    getVapourSynthAPI = (VSGetAPIFunc)dlsym(vs_ctx->library, "getVapourSynthAPI");
+#endif
+
+    if (!getVapourSynthAPI) {
+        return false;
+    }
+
+    vs_ctx->vsapi = getVapourSynthAPI(VAPOURSYNTH_API_VERSION);
+    if (!vs_ctx->vsapi) {
+        return false;
+    }
+
+    return vsscript_init() != 0;
+}
+#endif
+
+static bool create_filter_graph(const BlurConfig* config, int width, int height, double fps) {
+    int ret;
+    char args[512];
+
+    g_filter_graph = avfilter_graph_alloc();
+    if (!g_filter_graph) {
+        return false;
+    }
+
+    if (config->threads > 0) {
+        g_filter_graph->nb_threads = config->threads;
+    }
+
+    snprintf(args, sizeof(args),
+        "video_size=%dx%d:pix_fmt=%d:time_base=%d/%d:pixel_aspect=1/1",
+        width, height, AV_PIX_FMT_YUV420P, 1, (int)fps);
+
+    const AVFilter* buffersrc = avfilter_get_by_name("buffer");
+    ret = avfilter_graph_create_filter(&g_buffersrc_ctx, buffersrc, "in",
+        args, NULL, g_filter_graph);
+    if (ret < 0) {
+        fprintf(stderr, "Failed to create buffer source filter\n");
+        return false;
+    }
+
+    const AVFilter* buffersink = avfilter_get_by_name("buffersink");
+    ret = avfilter_graph_create_filter(&g_buffersink_ctx, buffersink, "out",
+        NULL, NULL, g_filter_graph);
+    if (ret < 0) {
+        fprintf(stderr, "Failed to create buffer sink filter\n");
+        return false;
+    }
+
+    enum AVPixelFormat pix_fmts[] = { AV_PIX_FMT_YUV420P, AV_PIX_FMT_NONE };
+    ret = av_opt_set_int_list(g_buffersink_ctx, "pix_fmts", pix_fmts,
+        AV_PIX_FMT_NONE, AV_OPT_SEARCH_CHILDREN);
+    if (ret < 0) {
+        fprintf(stderr, "Failed to set pixel formats on buffer sink\n");
+        return false;
+    }
+
+    AVFilterInOut* outputs = avfilter_inout_alloc();
+    AVFilterInOut* inputs = avfilter_inout_alloc();
+
+    outputs->name = av_strdup("in");
+    outputs->filter_ctx = g_buffersrc_ctx;
+    outputs->pad_idx = 0;
+    outputs->next = NULL;
+
+    inputs->name = av_strdup("out");
+    inputs->filter_ctx = g_buffersink_ctx;
+    inputs->pad_idx = 0;
+    inputs->next = NULL;
+
+    char filter_descr[2048] = "null";
+
+    if (strlen(config->ffmpeg_filters) > 0) {
+        strncpy(filter_descr, config->ffmpeg_filters, sizeof(filter_descr) - 1);
+    }
+    else if (config->brightness != 0 || config->saturation != 0 ||
+        config->contrast != 0 || config->gamma != 1.0) {
+
+        float bright = config->brightness;
+        float sat = 1.0f + config->saturation;
+        float cont = 1.0f + config->contrast;
+        float gamma = config->gamma;
+
+        snprintf(filter_descr, sizeof(filter_descr),
+            "eq=brightness=%.2f:saturation=%.2f:contrast=%.2f:gamma=%.2f",
+            bright, sat, cont, gamma);
+    }
+
+    if (config->debug) {
+        printf("Filter description: %s\n", filter_descr);
+    }
+
+    ret = avfilter_graph_parse_ptr(g_filter_graph, filter_descr, &inputs, &outputs, NULL);
+    if (ret < 0) {
+        fprintf(stderr, "Failed to parse filter graph\n");
+        avfilter_inout_free(&inputs);
+        avfilter_inout_free(&outputs);
+        return false;
+    }
+
+    ret = avfilter_graph_config(g_filter_graph, NULL);
+    if (ret < 0) {
+        fprintf(stderr, "Failed to configure filter graph\n");
+        return false;
+    }
+
+    avfilter_inout_free(&inputs);
+    avfilter_inout_free(&outputs);
+
+    return true;
+}
+
+static bool apply_motion_blur(FrameBuffer* frames, int frame_count, float* weights, FrameBuffer* output) {
+    if (frame_count == 0 || !frames || !weights || !output) return false;
+
+    int width = frames[0].width;
+    int height = frames[0].height;
+
+    if (!output->allocated) {
+        if (!frame_buffer_alloc(output, width, height, AV_PIX_FMT_YUV420P)) {
+            return false;
+        }
+    }
+
+    memset(output->data[0], 0, output->linesize[0] * height);
+    memset(output->data[1], 0, output->linesize[1] * (height / 2));
+    memset(output->data[2], 0, output->linesize[2] * (height / 2));
+
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            float y_accum = 0, u_accum = 0, v_accum = 0;
+
+            for (int i = 0; i < frame_count; i++) {
+                if (!frames[i].data[0]) continue;
+
+                uint8_t y_val = frames[i].data[0][y * frames[i].linesize[0] + x];
+                y_accum += y_val * weights[i];
+
+                if (y % 2 == 0 && x % 2 == 0) {
+                    uint8_t u_val = frames[i].data[1][(y / 2) * frames[i].linesize[1] + (x / 2)];
+                    uint8_t v_val = frames[i].data[2][(y / 2) * frames[i].linesize[2] + (x / 2)];
+                    u_accum += u_val * weights[i];
+                    v_accum += v_val * weights[i];
+                }
+            }
+
+            output->data[0][y * output->linesize[0] + x] = (uint8_t)CLAMP(y_accum, 0, 255);
+
+            if (y % 2 == 0 && x % 2 == 0) {
+                output->data[1][(y / 2) * output->linesize[1] + (x / 2)] = (uint8_t)CLAMP(u_accum, 0, 255);
+                output->data[2][(y / 2) * output->linesize[2] + (x / 2)] = (uint8_t)CLAMP(v_accum, 0, 255);
+            }
+        }
+    }
+
+    output->pts = frames[frame_count / 2].pts;
+    return true;
+}
+
+static bool detect_duplicate_frames(FrameBuffer* frame1, FrameBuffer* frame2, float threshold) {
+    if (!frame1 || !frame2 || !frame1->data[0] || !frame2->data[0]) return false;
+
+    int width = frame1->width;
+    int height = frame1->height;
+
+    if (width != frame2->width || height != frame2->height) return false;
+
+    int64_t diff_sum = 0;
+    int total_pixels = width * height;
+
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            int val1 = frame1->data[0][y * frame1->linesize[0] + x];
+            int val2 = frame2->data[0][y * frame2->linesize[0] + x];
+            diff_sum += abs(val1 - val2);
+        }
+    }
+
+    float avg_diff = (float)diff_sum / total_pixels;
+    return avg_diff < (threshold * 255.0f);
+}
+
+static double parse_fps_string(const char* fps_str, double base_fps) {
+    if (strstr(fps_str, "x")) {
+        double multiplier = atof(fps_str);
+        return base_fps * multiplier;
+    }
+    return atof(fps_str);
+}
+
+#define MAX_PARALLEL_THREADS 64
+#define INTERP_MAX_LEVELS 3
+#define INTERP_SEARCH_RANGE 8
+#define INTERP_REFINE_RANGE 2
+#define INTERP_CONSISTENCY_THRESHOLD 2
+#define INTERP_SCENE_CHANGE_SAD 48
+
+typedef void (*ParallelFunc)(void* arg, int start, int end);
+
+typedef struct {
+    ParallelFunc func;
+    void* arg;
+    int start;
+    int end;
+} ParallelTask;
+
+typedef struct WorkerPool WorkerPool;
+
+typedef struct {
+    WorkerPool* pool;
+    int index;
+} PoolWorker;
+
+struct WorkerPool {
+    ParallelTask tasks[MAX_PARALLEL_THREADS];
+    PoolWorker workers[MAX_PARALLEL_THREADS];
+    pthread_t threads[MAX_PARALLEL_THREADS];
+    int worker_count;
+    int pending;
+    int64_t generation;
+    bool stopping;
+#ifdef _WIN32
+    HANDLE mutex;
+    HANDLE wake[MAX_PARALLEL_THREADS];
+    HANDLE done;
+#else
+    pthread_mutex_t mutex;
+    pthread_cond_t wake;
+    pthread_cond_t done;
+#endif
+};
+
+typedef struct {
+    BlockVector* vectors;
+    uint32_t* sad;
+    int blocks_x;
+    int blocks_y;
+} MotionField;
+
+typedef struct {
+    MotionField forward;
+    MotionField backward;
+    bool scene_change;
+} MotionPair;
+
+typedef struct {
+    uint8_t* data;
+    int width;
+    int height;
+    int stride;
+} LumaPlane;
+
+typedef struct {
+    float* planes[3];
+    int width[3];
+    int height[3];
+} BlendAccumulator;
+
+typedef struct {
+    int width;
+    int height;
+    int block_size;
+    int blocks_x;
+    int blocks_y;
+    int level_count;
+    int thread_count;
+    WorkerPool* pool;
+    float mask_area;
+    bool decoder_motion;
+    int seed_range;
+    int64_t last_next_sequence;
+    LumaPlane prev_levels[INTERP_MAX_LEVELS];
+    LumaPlane next_levels[INTERP_MAX_LEVELS];
+    MotionPair pair;
+    MotionField scratch;
+} InterpolationContext;
+
+typedef struct {
+    InterpolationContext* ctx;
+    const LumaPlane* src;
+    const LumaPlane* ref;
+    const MotionField* parent;
+    MotionField* out;
+    const BlockVector* seed;
+    int seed_sign;
+    int level;
+    int range;
+} MotionSearchJob;
+
+typedef struct {
+    InterpolationContext* ctx;
+    const MotionPair* pair;
+    const FrameBuffer* prev;
+    const FrameBuffer* next;
+    FrameBuffer* output;
+    BlendAccumulator* accum;
+    float weight;
+    float t;
+} InterpolationJob;
+
+typedef struct {
+    BlendAccumulator* accum;
+    const FrameBuffer* frame;
+    float weight;
+} AccumulateJob;
+
+static int get_cpu_count(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int)count : 1;
+#endif
+}
+
+static void worker_pool_lock(WorkerPool* pool) {
+#ifdef _WIN32
+    WaitForSingleObject(pool->mutex, INFINITE);
+#else
+    pthread_mutex_lock(&pool->mutex);
+#endif
+}
+
+static void worker_pool_unlock(WorkerPool* pool) {
+#ifdef _WIN32
+    ReleaseMutex(pool->mutex);
+#else
+    pthread_mutex_unlock(&pool->mutex);
+#endif
+}
+
+static void worker_pool_wake(WorkerPool* pool) {
+#ifdef _WIN32
+    for (int i = 1; i <= pool->worker_count; i++) {
+        SetEvent(pool->wake[i]);
+    }
+#else
+    pthread_cond_broadcast(&pool->wake);
+#endif
+}
+
+static THREAD_FUNC pool_worker_thread(void* arg) {
+    PoolWorker* worker = (PoolWorker*)arg;
+    WorkerPool* pool = worker->pool;
+    int64_t seen = 0;
+
+    worker_pool_lock(pool);
+    while (true) {
+        while (!pool->stopping && pool->generation == seen) {
+#ifdef _WIN32
+            ReleaseMutex(pool->mutex);
+            WaitForSingleObject(pool->wake[worker->index], 10);
+            WaitForSingleObject(pool->mutex, INFINITE);
+#else
+            pthread_cond_wait(&pool->wake, &pool->mutex);
+#endif
+        }
+        if (pool->stopping) {
+            break;
+        }
+
+        seen = pool->generation;
+        ParallelTask task = pool->tasks[worker->index];
+        worker_pool_unlock(pool);
+
+        if (task.func) {
+            task.func(task.arg, task.start, task.end);
+        }
+
+        worker_pool_lock(pool);
+        if (--pool->pending == 0) {
+#ifdef _WIN32
+            SetEvent(pool->done);
+#else
+            pthread_cond_signal(&pool->done);
+#endif
+        }
+    }
+    worker_pool_unlock(pool);
+
+#ifdef _WIN32
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+static void worker_pool_destroy(WorkerPool* pool) {
+    if (!pool) return;
+
+    worker_pool_lock(pool);
+    pool->stopping = true;
+    worker_pool_wake(pool);
+    worker_pool_unlock(pool);
+
+    for (int i = 1; i <= pool->worker_count; i++) {
+#ifdef _WIN32
+        WaitForSingleObject(pool->threads[i], INFINITE);
+        CloseHandle(pool->threads[i]);
+#else
+        pthread_join(pool->threads[i], NULL);
+#endif
+    }
+
+#ifdef _WIN32
+    for (int i = 1; i < MAX_PARALLEL_THREADS; i++) {
+        if (pool->wake[i]) CloseHandle(pool->wake[i]);
+    }
+    CloseHandle(pool->done);
+    CloseHandle(pool->mutex);
+#else
+    pthread_mutex_destroy(&pool->mutex);
+    pthread_cond_destroy(&pool->wake);
+    pthread_cond_destroy(&pool->done);
+#endif
+    free(pool);
+}
+
+static WorkerPool* worker_pool_create(int thread_count) {
+    if (thread_count > MAX_PARALLEL_THREADS) thread_count = MAX_PARALLEL_THREADS;
+    if (thread_count <= 1) return NULL;
+
+    WorkerPool* pool = (WorkerPool*)calloc(1, sizeof(WorkerPool));
+    if (!pool) return NULL;
+
+#ifdef _WIN32
+    pool->mutex = CreateMutex(NULL, FALSE, NULL);
+    pool->done = CreateEvent(NULL, FALSE, FALSE, NULL);
+#else
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+    pthread_cond_init(&pool->done, NULL);
+#endif
+
+    for (int i = 1; i < thread_count; i++) {
+        pool->workers[i].pool = pool;
+        pool->workers[i].index = i;
+#ifdef _WIN32
+        pool->wake[i] = CreateEvent(NULL, FALSE, FALSE, NULL);
+        pool->threads[i] = CreateThread(NULL, 0, pool_worker_thread, &pool->workers[i], 0, NULL);
+        bool started = pool->threads[i] != NULL;
+#else
+        bool started = pthread_create(&pool->threads[i], NULL, pool_worker_thread, &pool->workers[i]) == 0;
+#endif
+        if (!started) {
+            fprintf(stderr, "Warning: Started %d of %d worker threads\n", i, thread_count);
+            break;
+        }
+        pool->worker_count = i;
+    }
+
+    return pool;
+}
+
+static void run_parallel(WorkerPool* pool, ParallelFunc func, void* arg, int count) {
+    int thread_count = pool ? FFMIN(pool->worker_count + 1, count) : 1;
+    if (thread_count <= 1) {
+        func(arg, 0, count);
+        return;
+    }
+
+    worker_pool_lock(pool);
+    for (int i = 0; i <= pool->worker_count; i++) {
+        ParallelTask* task = &pool->tasks[i];
+        task->func = i < thread_count ? func : NULL;
+        task->arg = arg;
+        task->start = i < thread_count ? (int)((int64_t)count * i / thread_count) : 0;
+        task->end = i < thread_count ? (int)((int64_t)count * (i + 1) / thread_count) : 0;
+    }
+    pool->pending = pool->worker_count;
+    pool->generation++;
+    worker_pool_wake(pool);
+    worker_pool_unlock(pool);
+
+    func(arg, pool->tasks[0].start, pool->tasks[0].end);
+
+    worker_pool_lock(pool);
+    while (pool->pending > 0) {
+#ifdef _WIN32
+        ReleaseMutex(pool->mutex);
+        WaitForSingleObject(pool->done, 10);
+        WaitForSingleObject(pool->mutex, INFINITE);
+#else
+        pthread_cond_wait(&pool->done, &pool->mutex);
+#endif
+    }
+    worker_pool_unlock(pool);
+}
+
+static uint32_t block_sad(const uint8_t* a, int stride_a, const uint8_t* b, int stride_b,
+    int width, int height) {
+    uint32_t sad = 0;
+#ifdef HAVE_SSE2
+    __m128i acc = _mm_setzero_si128();
+#endif
+
+    for (int y = 0; y < height; y++) {
+        const uint8_t* row_a = a + y * stride_a;
+        const uint8_t* row_b = b + y * stride_b;
+        int x = 0;
+
+#ifdef HAVE_SSE2
+        for (; x + 16 <= width; x += 16) {
+            __m128i va = _mm_loadu_si128((const __m128i*)(row_a + x));
+            __m128i vb = _mm_loadu_si128((const __m128i*)(row_b + x));
+            acc = _mm_add_epi64(acc, _mm_sad_epu8(va, vb));
+        }
+        for (; x + 8 <= width; x += 8) {
+            __m128i va = _mm_loadl_epi64((const __m128i*)(row_a + x));
+            __m128i vb = _mm_loadl_epi64((const __m128i*)(row_b + x));
+            acc = _mm_add_epi64(acc, _mm_sad_epu8(va, vb));
+        }
+#endif
+        for (; x < width; x++) {
+            sad += abs(row_a[x] - row_b[x]);
+        }
+    }
+
+#ifdef HAVE_SSE2
+    sad += (uint32_t)_mm_cvtsi128_si32(acc) + (uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(acc, 8));
+#endif
+    return sad;
+}
+
+static bool motion_field_alloc(MotionField* field, int blocks_x, int blocks_y) {
+    field->blocks_x = blocks_x;
+    field->blocks_y = blocks_y;
+    field->vectors = (BlockVector*)calloc((size_t)blocks_x * blocks_y, sizeof(BlockVector));
+    field->sad = (uint32_t*)calloc((size_t)blocks_x * blocks_y, sizeof(uint32_t));
+    return field->vectors && field->sad;
+}
+
+static void motion_field_free(MotionField* field) {
+    free(field->vectors);
+    free(field->sad);
+    field->vectors = NULL;
+    field->sad = NULL;
+}
+
+static bool motion_pair_alloc(MotionPair* pair, int blocks_x, int blocks_y) {
+    pair->scene_change = false;
+    return motion_field_alloc(&pair->forward, blocks_x, blocks_y) &&
+        motion_field_alloc(&pair->backward, blocks_x, blocks_y);
+}
+
+static void motion_pair_free(MotionPair* pair) {
+    motion_field_free(&pair->forward);
+    motion_field_free(&pair->backward);
+}
+
+static void downsample_plane(const LumaPlane* src, LumaPlane* dst) {
+    for (int y = 0; y < dst->height; y++) {
+        const uint8_t* row0 = src->data + (2 * y) * src->stride;
+        const uint8_t* row1 = row0 + src->stride;
+        uint8_t* out = dst->data + y * dst->stride;
+        for (int x = 0; x < dst->width; x++) {
+            out[x] = (uint8_t)((row0[2 * x] + row0[2 * x + 1] + row1[2 * x] + row1[2 * x + 1] + 2) >> 2);
+        }
+    }
+}
+
+static void build_pyramid(InterpolationContext* ctx, LumaPlane* levels, const FrameBuffer* frame) {
+    levels[0].data = frame->data[0];
+    levels[0].width = ctx->width;
+    levels[0].height = ctx->height;
+    levels[0].stride = frame->linesize[0];
+
+    for (int level = 1; level < ctx->level_count; level++) {
+        downsample_plane(&levels[level - 1], &levels[level]);
+    }
+}
+
+static uint32_t vector_cost(const LumaPlane* src, const LumaPlane* ref, int x0, int y0,
+    int bw, int bh, int vx, int vy, uint32_t* sad_out) {
+    int rx = x0 + vx;
+    int ry = y0 + vy;
+    if (rx < 0 || ry < 0 || rx + bw > ref->width || ry + bh > ref->height) {
+        return UINT32_MAX;
+    }
+
+    uint32_t sad = block_sad(src->data + y0 * src->stride + x0, src->stride,
+        ref->data + ry * ref->stride + rx, ref->stride, bw, bh);
+    uint32_t lambda = (uint32_t)(bw * bh) >> 6;
+    if (lambda < 1) lambda = 1;
+
+    *sad_out = sad;
+    return sad + lambda * (uint32_t)(abs(vx) + abs(vy));
+}
+
+static void motion_search_rows(void* arg, int start, int end) {
+    MotionSearchJob* job = (MotionSearchJob*)arg;
+    InterpolationContext* ctx = job->ctx;
+    const LumaPlane* src = job->src;
+    const LumaPlane* ref = job->ref;
+    int size = ctx->block_size >> job->level;
+    if (size < 1) size = 1;
+
+    for (int by = start; by < end; by++) {
+        for (int bx = 0; bx < ctx->blocks_x; bx++) {
+            int idx = by * ctx->blocks_x + bx;
+            int x0 = (bx * ctx->block_size) >> job->level;
+            int y0 = (by * ctx->block_size) >> job->level;
+            BlockVector best = { 0, 0 };
+            uint32_t best_sad = 0;
+
+            if (x0 >= src->width || y0 >= src->height) {
+                job->out->vectors[idx] = best;
+                job->out->sad[idx] = 0;
+                continue;
+            }
+
+            int bw = FFMIN(size, src->width - x0);
+            int bh = FFMIN(size, src->height - y0);
+
+            BlockVector candidates[7];
+            int candidate_count = 0;
+            candidates[candidate_count++] = best;
+            if (bx > 0) {
+                candidates[candidate_count++] = job->out->vectors[idx - 1];
+            }
+            if (job->seed && job->seed[idx].x != MOTION_VECTOR_INVALID) {
+                BlockVector v = job->seed[idx];
+                v.x = (int16_t)(v.x * job->seed_sign);
+                v.y = (int16_t)(v.y * job->seed_sign);
+                candidates[candidate_count++] = v;
+            }
+            if (job->parent) {
+                int neighbours[4] = { idx, bx + 1 < ctx->blocks_x ? idx + 1 : idx,
+                    by + 1 < ctx->blocks_y ? idx + ctx->blocks_x : idx, by > 0 ? idx - ctx->blocks_x : idx };
+                for (int i = 0; i < 4; i++) {
+                    BlockVector v = job->parent->vectors[neighbours[i]];
+                    v.x = (int16_t)(v.x * 2);
+                    v.y = (int16_t)(v.y * 2);
+                    candidates[candidate_count++] = v;
+                }
+            }
+
+            uint32_t best_cost = UINT32_MAX;
+            for (int i = 0; i < candidate_count; i++) {
+                uint32_t sad;
+                uint32_t cost = vector_cost(src, ref, x0, y0, bw, bh, candidates[i].x, candidates[i].y, &sad);
+                if (cost < best_cost) {
+                    best_cost = cost;
+                    best_sad = sad;
+                    best = candidates[i];
+                }
+            }
+
+            int range = job->range;
+            BlockVector center = best;
+            for (int dy = -range; dy <= range; dy++) {
+                for (int dx = -range; dx <= range; dx++) {
+                    if (dx == 0 && dy == 0) continue;
+                    uint32_t sad;
+                    int vx = center.x + dx;
+                    int vy = center.y + dy;
+                    uint32_t cost = vector_cost(src, ref, x0, y0, bw, bh, vx, vy, &sad);
+                    if (cost < best_cost) {
+                        best_cost = cost;
+                        best_sad = sad;
+                        best.x = (int16_t)vx;
+                        best.y = (int16_t)vy;
+                    }
+                }
+            }
+
+            job->out->vectors[idx] = best;
+            job->out->sad[idx] = best_cost == UINT32_MAX ? UINT32_MAX : best_sad / (uint32_t)(bw * bh);
+        }
+    }
+}
+
+static void estimate_motion(InterpolationContext* ctx, const LumaPlane* src, const LumaPlane* ref,
+    MotionField* result, const BlockVector* seed, int seed_sign) {
+    if (seed) {
+        MotionSearchJob job = { ctx, &src[0], &ref[0], NULL, result, seed, seed_sign, 0, ctx->seed_range };
+        run_parallel(ctx->pool, motion_search_rows, &job, ctx->blocks_y);
+        return;
+    }
+
+    MotionField* parent = NULL;
+
+    for (int level = ctx->level_count - 1; level >= 0; level--) {
+        MotionField* out = (level & 1) ? &ctx->scratch : result;
+        int range = parent ? INTERP_REFINE_RANGE : INTERP_SEARCH_RANGE;
+        MotionSearchJob job = { ctx, &src[level], &ref[level], parent, out, NULL, 0, level, range };
+        run_parallel(ctx->pool, motion_search_rows, &job, ctx->blocks_y);
+        parent = out;
+    }
+}
+
+static InterpolationContext* interpolation_create(const BlurConfig* config, int width, int height) {
+    InterpolationContext* ctx = (InterpolationContext*)calloc(1, sizeof(InterpolationContext));
+    if (!ctx) return NULL;
+
+    ctx->width = width;
+    ctx->height = height;
+    ctx->block_size = config->interpolation_block_size > 0 ? config->interpolation_block_size : 16;
+    ctx->blocks_x = (width + ctx->block_size - 1) / ctx->block_size;
+    ctx->blocks_y = (height + ctx->block_size - 1) / ctx->block_size;
+    ctx->thread_count = config->threads > 0 ? config->threads : get_cpu_count();
+    ctx->mask_area = config->interpolation_mask_area;
+    ctx->decoder_motion = strcmp(config->motion_vectors, "search") != 0;
+    ctx->seed_range = strcmp(config->motion_vectors, "hybrid") == 0 ? INTERP_REFINE_RANGE : 0;
+
+    ctx->level_count = 1;
+    while (ctx->level_count < INTERP_MAX_LEVELS &&
+        (ctx->block_size >> ctx->level_count) >= 2 &&
+        (width >> ctx->level_count) >= 32 && (height >> ctx->level_count) >= 32) {
+        ctx->level_count++;
+    }
+
+    for (int level = 1; level < ctx->level_count; level++) {
+        LumaPlane* planes[2] = { &ctx->prev_levels[level], &ctx->next_levels[level] };
+        for (int i = 0; i < 2; i++) {
+            planes[i]->width = width >> level;
+            planes[i]->height = height >> level;
+            planes[i]->stride = FFALIGN(planes[i]->width, 32);
+            planes[i]->data = (uint8_t*)av_malloc((size_t)planes[i]->stride * planes[i]->height);
+            if (!planes[i]->data) {
+                goto fail;
+            }
+        }
+    }
+
+    if (!motion_pair_alloc(&ctx->pair, ctx->blocks_x, ctx->blocks_y) ||
+        !motion_field_alloc(&ctx->scratch, ctx->blocks_x, ctx->blocks_y)) {
+        goto fail;
+    }
+
+    ctx->pool = worker_pool_create(ctx->thread_count);
+    return ctx;
+
+fail:
+    for (int level = 1; level < INTERP_MAX_LEVELS; level++) {
+        av_free(ctx->prev_levels[level].data);
+        av_free(ctx->next_levels[level].data);
+    }
+    motion_pair_free(&ctx->pair);
+    motion_field_free(&ctx->scratch);
+    free(ctx);
+    return NULL;
+}
+
+static void interpolation_destroy(InterpolationContext* ctx) {
+    if (!ctx) return;
+
+    for (int level = 1; level < INTERP_MAX_LEVELS; level++) {
+        av_free(ctx->prev_levels[level].data);
+        av_free(ctx->next_levels[level].data);
+    }
+    worker_pool_destroy(ctx->pool);
+    motion_pair_free(&ctx->pair);
+    motion_field_free(&ctx->scratch);
+    free(ctx);
+}
+
+static void interpolation_prepare(InterpolationContext* ctx, const FrameBuffer* prev, const FrameBuffer* next,
+    MotionPair* pair) {
+    if (prev->sequence > 0 && ctx->last_next_sequence == prev->sequence) {
+        for (int level = 0; level < ctx->level_count; level++) {
+            LumaPlane tmp = ctx->prev_levels[level];
+            ctx->prev_levels[level] = ctx->next_levels[level];
+            ctx->next_levels[level] = tmp;
+        }
+        ctx->prev_levels[0].data = prev->data[0];
+        ctx->prev_levels[0].stride = prev->linesize[0];
+    }
+    else {
+        build_pyramid(ctx, ctx->prev_levels, prev);
+    }
+    build_pyramid(ctx, ctx->next_levels, next);
+    ctx->last_next_sequence = next->sequence;
+
+    const BlockVector* seed = NULL;
+    if (ctx->decoder_motion && next->has_motion && next->motion_blocks == ctx->blocks_x * ctx->blocks_y) {
+        seed = next->motion;
+    }
+
+    estimate_motion(ctx, ctx->prev_levels, ctx->next_levels, &pair->forward, seed, -1);
+    estimate_motion(ctx, ctx->next_levels, ctx->prev_levels, &pair->backward, seed, 1);
+
+    uint64_t sad_sum = 0;
+    int block_count = ctx->blocks_x * ctx->blocks_y;
+    for (int i = 0; i < block_count; i++) {
+        sad_sum += FFMIN(pair->forward.sad[i], pair->backward.sad[i]);
+    }
+    pair->scene_change = block_count > 0 && sad_sum / block_count > INTERP_SCENE_CHANGE_SAD;
+}
+
+static inline int sample_q4(const uint8_t* plane, int stride, int width, int height, int xq, int yq) {
+    int ix = xq >> 4;
+    int iy = yq >> 4;
+    int fx = xq & 15;
+    int fy = yq & 15;
+    int x0 = CLAMP(ix, 0, width - 1);
+    int x1 = CLAMP(ix + 1, 0, width - 1);
+    const uint8_t* row0 = plane + CLAMP(iy, 0, height - 1) * stride;
+    const uint8_t* row1 = plane + CLAMP(iy + 1, 0, height - 1) * stride;
+
+    int top = row0[x0] * (16 - fx) + row0[x1] * fx;
+    int bottom = row1[x0] * (16 - fx) + row1[x1] * fx;
+    return (top * (16 - fy) + bottom * fy + 128) >> 8;
+}
+
+static void warp_block(const FrameBuffer* prev, const FrameBuffer* next, FrameBuffer* output, int plane,
+    int x0, int y0, int bw, int bh, int width, int height,
+    int prev_dx, int prev_dy, int next_dx, int next_dy, int prev_weight) {
+    const uint8_t* src_prev = prev->data[plane];
+    const uint8_t* src_next = next->data[plane];
+    int stride_prev = prev->linesize[plane];
+    int stride_next = next->linesize[plane];
+    int next_weight = 256 - prev_weight;
+
+    for (int y = y0; y < y0 + bh; y++) {
+        uint8_t* out = output->data[plane] + y * output->linesize[plane];
+        for (int x = x0; x < x0 + bw; x++) {
+            int a = prev_weight ? sample_q4(src_prev, stride_prev, width, height,
+                x * 16 + prev_dx, y * 16 + prev_dy) : 0;
+            int b = next_weight ? sample_q4(src_next, stride_next, width, height,
+                x * 16 + next_dx, y * 16 + next_dy) : 0;
+            out[x] = (uint8_t)((a * prev_weight + b * next_weight + 128) >> 8);
+        }
+    }
+}
+
+static void accumulate_warp_block(const FrameBuffer* prev, const FrameBuffer* next, BlendAccumulator* accum,
+    float weight, int plane, int x0, int y0, int bw, int bh, int width, int height,
+    int prev_dx, int prev_dy, int next_dx, int next_dy, int prev_weight) {
+    const uint8_t* src_prev = prev->data[plane];
+    const uint8_t* src_next = next->data[plane];
+    int stride_prev = prev->linesize[plane];
+    int stride_next = next->linesize[plane];
+    int next_weight = 256 - prev_weight;
+    float scale = weight / 256.0f;
+
+    for (int y = y0; y < y0 + bh; y++) {
+        float* out = accum->planes[plane] + y * accum->width[plane];
+        for (int x = x0; x < x0 + bw; x++) {
+            int a = prev_weight ? sample_q4(src_prev, stride_prev, width, height,
+                x * 16 + prev_dx, y * 16 + prev_dy) : 0;
+            int b = next_weight ? sample_q4(src_next, stride_next, width, height,
+                x * 16 + next_dx, y * 16 + next_dy) : 0;
+            out[x] += (a * prev_weight + b * next_weight) * scale;
+        }
+    }
+}
+
+static void interpolate_rows(void* arg, int start, int end) {
+    InterpolationJob* job = (InterpolationJob*)arg;
+    InterpolationContext* ctx = job->ctx;
+    float t = job->t;
+    int temporal_weight = (int)((1.0f - t) * 256.0f + 0.5f);
+    int anchor_weight = (int)((0.5f + 0.5f * ctx->mask_area) * 256.0f + 0.5f);
+
+    for (int by = start; by < end; by++) {
+        for (int bx = 0; bx < ctx->blocks_x; bx++) {
+            int idx = by * ctx->blocks_x + bx;
+            const MotionPair* pair = job->pair;
+            BlockVector fwd = pair->forward.vectors[idx];
+            BlockVector bwd = pair->backward.vectors[idx];
+            float vx = 0.0f, vy = 0.0f;
+            int prev_weight = temporal_weight;
+
+            if (pair->scene_change) {
+                prev_weight = t < 0.5f ? 256 : 0;
+            }
+            else if (abs(fwd.x + bwd.x) + abs(fwd.y + bwd.y) <= INTERP_CONSISTENCY_THRESHOLD) {
+                vx = (fwd.x - bwd.x) * 0.5f;
+                vy = (fwd.y - bwd.y) * 0.5f;
+            }
+            else if (pair->forward.sad[idx] <= pair->backward.sad[idx]) {
+                vx = fwd.x;
+                vy = fwd.y;
+                prev_weight = FFMAX(temporal_weight, anchor_weight);
+            }
+            else {
+                vx = -bwd.x;
+                vy = -bwd.y;
+                prev_weight = FFMIN(temporal_weight, 256 - anchor_weight);
+            }
+
+            int prev_dx = (int)lrintf(-t * vx * 16.0f);
+            int prev_dy = (int)lrintf(-t * vy * 16.0f);
+            int next_dx = (int)lrintf((1.0f - t) * vx * 16.0f);
+            int next_dy = (int)lrintf((1.0f - t) * vy * 16.0f);
+
+            for (int plane = 0; plane < 3; plane++) {
+                int shift = plane ? 1 : 0;
+                int width = plane ? (ctx->width + 1) >> 1 : ctx->width;
+                int height = plane ? (ctx->height + 1) >> 1 : ctx->height;
+                int size = ctx->block_size >> shift;
+                int x0 = bx * size;
+                int y0 = by * size;
+                if (x0 >= width || y0 >= height) continue;
+
+                int bw = FFMIN(size, width - x0);
+                int bh = FFMIN(size, height - y0);
+
+                if (job->accum) {
+                    accumulate_warp_block(job->prev, job->next, job->accum, job->weight, plane,
+                        x0, y0, bw, bh, width, height,
+                        prev_dx >> shift, prev_dy >> shift, next_dx >> shift, next_dy >> shift, prev_weight);
+                }
+                else {
+                    warp_block(job->prev, job->next, job->output, plane,
+                        x0, y0, bw, bh, width, height,
+                        prev_dx >> shift, prev_dy >> shift, next_dx >> shift, next_dy >> shift, prev_weight);
+                }
+            }
+        }
+    }
+}
+
+static bool interpolation_generate(InterpolationContext* ctx, const MotionPair* pair,
+    const FrameBuffer* prev, const FrameBuffer* next, float t, FrameBuffer* output) {
+    if (output->release) {
+        frame_buffer_free(output);
+    }
+
+    if (!output->allocated) {
+        if (!frame_buffer_alloc(output, ctx->width, ctx->height, AV_PIX_FMT_YUV420P)) {
+            return false;
+        }
+    }
+
+    InterpolationJob job = { ctx, pair, prev, next, output, NULL, 0.0f, t };
+    run_parallel(ctx->pool, interpolate_rows, &job, ctx->blocks_y);
+
+    output->pts = prev->pts + (int64_t)((next->pts - prev->pts) * (double)t + 0.5);
+    output->sequence = 0;
+    return true;
+}
+
+static void interpolation_accumulate(InterpolationContext* ctx, const MotionPair* pair,
+    const FrameBuffer* prev, const FrameBuffer* next, float t, float weight, BlendAccumulator* accum) {
+    InterpolationJob job = { ctx, pair, prev, next, NULL, accum, weight, t };
+    run_parallel(ctx->pool, interpolate_rows, &job, ctx->blocks_y);
+}
+
+static bool blend_accumulator_alloc(BlendAccumulator* accum, int width, int height) {
+    for (int plane = 0; plane < 3; plane++) {
+        accum->width[plane] = plane ? (width + 1) >> 1 : width;
+        accum->height[plane] = plane ? (height + 1) >> 1 : height;
+        accum->planes[plane] = (float*)av_malloc((size_t)accum->width[plane] * accum->height[plane] * sizeof(float));
+        if (!accum->planes[plane]) return false;
+    }
+    return true;
+}
+
+static void blend_accumulator_free(BlendAccumulator* accum) {
+    for (int plane = 0; plane < 3; plane++) {
+        av_freep(&accum->planes[plane]);
+    }
+}
+
+static void blend_accumulator_clear(BlendAccumulator* accum) {
+    for (int plane = 0; plane < 3; plane++) {
+        memset(accum->planes[plane], 0, (size_t)accum->width[plane] * accum->height[plane] * sizeof(float));
+    }
+}
+
+static void accumulate_frame_rows(void* arg, int start, int end) {
+    AccumulateJob* job = (AccumulateJob*)arg;
+
+    for (int plane = 0; plane < 3; plane++) {
+        int y_start = plane ? start : start * 2;
+        int y_end = FFMIN(plane ? end : end * 2, job->accum->height[plane]);
+        for (int y = y_start; y < y_end; y++) {
+            const uint8_t* src = job->frame->data[plane] + y * job->frame->linesize[plane];
+            float* out = job->accum->planes[plane] + y * job->accum->width[plane];
+            for (int x = 0; x < job->accum->width[plane]; x++) {
+                out[x] += src[x] * job->weight;
+            }
+        }
+    }
+}
+
+static void accumulate_frame(BlendAccumulator* accum, const FrameBuffer* frame, float weight, WorkerPool* pool) {
+    AccumulateJob job = { accum, frame, weight };
+    run_parallel(pool, accumulate_frame_rows, &job, accum->height[1]);
+}
+
+static bool blend_accumulator_resolve(BlendAccumulator* accum, FrameBuffer* output) {
+    if (!output->allocated) {
+        if (!frame_buffer_alloc(output, accum->width[0], accum->height[0], AV_PIX_FMT_YUV420P)) {
+            return false;
+        }
+    }
+
+    for (int plane = 0; plane < 3; plane++) {
+        for (int y = 0; y < accum->height[plane]; y++) {
+            const float* src = accum->planes[plane] + y * accum->width[plane];
+            uint8_t* out = output->data[plane] + y * output->linesize[plane];
+            for (int x = 0; x < accum->width[plane]; x++) {
+                out[x] = (uint8_t)CLAMP(src[x] + 0.5f, 0, 255);
+            }
+        }
+    }
+    return true;
+}
+
+static int get_interpolation_factor(const BlurConfig* config, double input_fps) {
+    if (!config->interpolate || input_fps <= 0) return 1;
+
+    double target_fps = parse_fps_string(config->interpolated_fps, input_fps);
+    int factor = (int)(target_fps / input_fps + 0.5);
+    return CLAMP(factor, 1, 16);
+}
+
+#define MOTION_CACHE_MAGIC "SWBMV001"
+#define MOTION_CACHE_SAMPLE_SIZE 65536
+
+typedef struct {
+    char magic[8];
+    uint64_t key;
+    int32_t width;
+    int32_t height;
+    int32_t blocks_x;
+    int32_t blocks_y;
+    int64_t record_size;
+    int64_t capacity;
+    int64_t frame_count;
+    int32_t complete;
+    int32_t reserved;
+} MotionCacheHeader;
+
+typedef struct {
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#else
+    int fd;
+#endif
+    uint8_t* base;
+    size_t size;
+    MotionCacheHeader* header;
+    int64_t block_count;
+    int64_t next_frame;
+    bool reading;
+    char path[1024];
+    char temp_path[1040];
+} MotionCache;
+
+static uint64_t fnv1a_update(uint64_t hash, const void* data, size_t size) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static bool hash_input_file(const char* filename, uint64_t* hash) {
+    int64_t file_size;
+    int64_t modified;
+#ifdef _WIN32
+    struct __stat64 st;
+    if (_stat64(filename, &st) != 0) return false;
+#else
+    struct stat st;
+    if (stat(filename, &st) != 0) return false;
+#endif
+    file_size = (int64_t)st.st_size;
+    modified = (int64_t)st.st_mtime;
+
+    FILE* file = fopen(filename, "rb");
+    if (!file) return false;
+
+    uint8_t* sample = (uint8_t*)malloc(MOTION_CACHE_SAMPLE_SIZE);
+    if (!sample) {
+        fclose(file);
+        return false;
+    }
+
+    *hash = fnv1a_update(14695981039346656037ULL, &file_size, sizeof(file_size));
+    *hash = fnv1a_update(*hash, &modified, sizeof(modified));
+
+    int64_t offsets[3] = { 0, file_size / 2, file_size - MOTION_CACHE_SAMPLE_SIZE };
+    for (int i = 0; i < 3; i++) {
+        int64_t offset = FFMAX(offsets[i], 0);
+#ifdef _WIN32
+        _fseeki64(file, offset, SEEK_SET);
+#else
+        fseeko(file, (off_t)offset, SEEK_SET);
+#endif
+        size_t read = fread(sample, 1, MOTION_CACHE_SAMPLE_SIZE, file);
+        *hash = fnv1a_update(*hash, sample, read);
+    }
+
+    free(sample);
+    fclose(file);
+    return true;
+}
+
+static uint64_t motion_cache_key(const BlurConfig* config, uint64_t file_hash, int width, int height) {
+    int32_t params[5] = { width, height, config->interpolation_block_size, config->deduplicate ? 1 : 0,
+        config->deduplicate ? config->deduplicate_range : 0 };
+    float adjustments[5] = { config->brightness, config->saturation, config->contrast, config->gamma,
+        config->deduplicate_threshold };
+
+    uint64_t key = fnv1a_update(file_hash, params, sizeof(params));
+    key = fnv1a_update(key, adjustments, sizeof(adjustments));
+    key = fnv1a_update(key, config->blur_mode, strlen(config->blur_mode));
+    key = fnv1a_update(key, config->motion_vectors, strlen(config->motion_vectors));
+    key = fnv1a_update(key, config->ffmpeg_filters, strlen(config->ffmpeg_filters));
+    return key;
+}
+
+static void motion_cache_unmap(MotionCache* cache) {
+#ifdef _WIN32
+    if (cache->base) UnmapViewOfFile(cache->base);
+    if (cache->mapping) CloseHandle(cache->mapping);
+    if (cache->file != INVALID_HANDLE_VALUE) CloseHandle(cache->file);
+#else
+    if (cache->base) munmap(cache->base, cache->size);
+    if (cache->fd >= 0) close(cache->fd);
+#endif
+    free(cache);
+}
+
+static bool motion_cache_map(MotionCache* cache, const char* path, size_t size, bool create) {
+    cache->size = size;
+#ifdef _WIN32
+    cache->file = CreateFileA(path, GENERIC_READ | (create ? GENERIC_WRITE : 0), FILE_SHARE_READ, NULL,
+        create ? CREATE_NEW : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (cache->file == INVALID_HANDLE_VALUE) return false;
+
+    if (!create) {
+        LARGE_INTEGER file_size;
+        if (!GetFileSizeEx(cache->file, &file_size) || (size_t)file_size.QuadPart < size) return false;
+        cache->size = size = (size_t)file_size.QuadPart;
+    }
+
+    cache->mapping = CreateFileMappingA(cache->file, NULL, create ? PAGE_READWRITE : PAGE_READONLY,
+        (DWORD)((uint64_t)size >> 32), (DWORD)(size & 0xFFFFFFFF), NULL);
+    if (!cache->mapping) return false;
+
+    cache->base = (uint8_t*)MapViewOfFile(cache->mapping, create ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, size);
+#else
+    cache->fd = open(path, create ? O_RDWR | O_CREAT | O_EXCL : O_RDONLY, 0644);
+    if (cache->fd < 0) return false;
+
+    if (create) {
+        if (ftruncate(cache->fd, (off_t)size) != 0) return false;
+    }
+    else {
+        struct stat st;
+        if (fstat(cache->fd, &st) != 0 || (size_t)st.st_size < size) return false;
+        cache->size = size = (size_t)st.st_size;
+    }
+
+    cache->base = (uint8_t*)mmap(NULL, size, create ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, cache->fd, 0);
+    if (cache->base == MAP_FAILED) {
+        cache->base = NULL;
+    }
+#endif
+    cache->header = (MotionCacheHeader*)cache->base;
+    return cache->base != NULL;
+}
+
+static MotionCache* motion_cache_open(const BlurConfig* config, const InterpolationContext* ctx,
+    int64_t expected_frames) {
+    uint64_t file_hash;
+    if (!hash_input_file(config->input_file, &file_hash)) {
+        fprintf(stderr, "Warning: Could not hash input for motion cache\n");
+        return NULL;
+    }
+
+    uint64_t key = motion_cache_key(config, file_hash, ctx->width, ctx->height);
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/%016llx.swbmv", config->cache_dir, (unsigned long long)key);
+
+    int64_t block_count = (int64_t)ctx->blocks_x * ctx->blocks_y;
+    int64_t record_size = block_count * 2 * (sizeof(BlockVector) + sizeof(uint32_t)) + sizeof(int32_t);
+    record_size = (record_size + 7) & ~7LL;
+
+    MotionCache* cache = (MotionCache*)calloc(1, sizeof(MotionCache));
+    if (!cache) return NULL;
+#ifdef _WIN32
+    cache->file = INVALID_HANDLE_VALUE;
+#else
+    cache->fd = -1;
+#endif
+    cache->block_count = block_count;
+
+    if (motion_cache_map(cache, path, sizeof(MotionCacheHeader), false)) {
+        MotionCacheHeader* header = cache->header;
+        if (memcmp(header->magic, MOTION_CACHE_MAGIC, 8) == 0 && header->key == key && header->complete &&
+            header->width == ctx->width && header->height == ctx->height &&
+            header->blocks_x == ctx->blocks_x && header->blocks_y == ctx->blocks_y &&
+            header->record_size == record_size &&
+            cache->size >= sizeof(MotionCacheHeader) + (size_t)(header->frame_count * record_size)) {
+            cache->reading = true;
+            if (config->verbose) {
+                printf("Motion cache hit: %s (%lld frames)\n", path, (long long)header->frame_count);
+            }
+            return cache;
+        }
+    }
+
+    motion_cache_unmap(cache);
+    if (expected_frames <= 0) {
+        if (config->verbose) {
+            printf("Motion cache disabled: input frame count is unknown\n");
+        }
+        return NULL;
+    }
+
+    cache = (MotionCache*)calloc(1, sizeof(MotionCache));
+    if (!cache) return NULL;
+#ifdef _WIN32
+    cache->file = INVALID_HANDLE_VALUE;
+#else
+    cache->fd = -1;
+#endif
+    cache->block_count = block_count;
+
+#ifdef _WIN32
+    unsigned long pid = (unsigned long)GetCurrentProcessId();
+#else
+    unsigned long pid = (unsigned long)getpid();
+#endif
+
+    strcpy(cache->path, path);
+    snprintf(cache->temp_path, sizeof(cache->temp_path), "%s.%lu.tmp", path, pid);
+
+    int64_t capacity = expected_frames + expected_frames / 50 + 16;
+    if (!motion_cache_map(cache, cache->temp_path, sizeof(MotionCacheHeader) + (size_t)(capacity * record_size), true)) {
+#ifdef _WIN32
+        bool created = cache->file != INVALID_HANDLE_VALUE;
+        bool exists = !created && GetLastError() == ERROR_FILE_EXISTS;
+#else
+        bool created = cache->fd >= 0;
+        bool exists = !created && errno == EEXIST;
+#endif
+        if (exists) {
+            if (config->verbose) {
+                printf("Motion cache %s is already being recorded by another job\n", path);
+            }
+        }
+        else {
+            fprintf(stderr, "Warning: Could not create motion cache file %s\n", cache->temp_path);
+        }
+
+        char temp_path[sizeof(cache->temp_path)];
+        strcpy(temp_path, cache->temp_path);
+        motion_cache_unmap(cache);
+        if (created) {
+            remove(temp_path);
+        }
+        return NULL;
+    }
+
+    MotionCacheHeader* header = cache->header;
+    memcpy(header->magic, MOTION_CACHE_MAGIC, 8);
+    header->key = key;
+    header->width = ctx->width;
+    header->height = ctx->height;
+    header->blocks_x = ctx->blocks_x;
+    header->blocks_y = ctx->blocks_y;
+    header->record_size = record_size;
+    header->capacity = capacity;
+    header->frame_count = 0;
+    header->complete = 0;
+    cache->next_frame = 1;
+
+    if (config->verbose) {
+        printf("Motion cache miss, recording vector fields to %s\n", path);
+    }
+    return cache;
+}
+
+static uint8_t* motion_cache_record(MotionCache* cache, int64_t frame) {
+    return cache->base + sizeof(MotionCacheHeader) + frame * cache->header->record_size;
+}
+
+static void motion_cache_prepare(MotionCache* cache, InterpolationContext* ctx, const FrameBuffer* prev,
+    const FrameBuffer* next, MotionPair* pair, int64_t frame) {
+    if (!cache) {
+        interpolation_prepare(ctx, prev, next, pair);
+        return;
+    }
+
+    size_t vectors_size = (size_t)cache->block_count * sizeof(BlockVector);
+    size_t sad_size = (size_t)cache->block_count * sizeof(uint32_t);
+
+    if (cache->reading && frame < cache->header->frame_count) {
+        const uint8_t* record = motion_cache_record(cache, frame);
+        memcpy(pair->forward.vectors, record, vectors_size);
+        memcpy(pair->backward.vectors, record + vectors_size, vectors_size);
+        memcpy(pair->forward.sad, record + 2 * vectors_size, sad_size);
+        memcpy(pair->backward.sad, record + 2 * vectors_size + sad_size, sad_size);
+        pair->scene_change = *(const int32_t*)(record + 2 * (vectors_size + sad_size)) != 0;
+        return;
+    }
+
+    interpolation_prepare(ctx, prev, next, pair);
+
+    if (cache->reading || frame != cache->next_frame || frame >= cache->header->capacity) {
+        return;
+    }
+
+    uint8_t* record = motion_cache_record(cache, frame);
+    memcpy(record, pair->forward.vectors, vectors_size);
+    memcpy(record + vectors_size, pair->backward.vectors, vectors_size);
+    memcpy(record + 2 * vectors_size, pair->forward.sad, sad_size);
+    memcpy(record + 2 * vectors_size + sad_size, pair->backward.sad, sad_size);
+    *(int32_t*)(record + 2 * (vectors_size + sad_size)) = pair->scene_change ? 1 : 0;
+    cache->next_frame = frame + 1;
+}
+
+static void motion_cache_close(MotionCache* cache, int64_t frames_processed, bool finished) {
+    if (!cache) return;
+
+    if (cache->reading) {
+        motion_cache_unmap(cache);
+        return;
+    }
+
+    bool complete = finished && cache->next_frame == frames_processed;
+    cache->header->frame_count = cache->next_frame;
+    cache->header->complete = complete ? 1 : 0;
+#ifdef _WIN32
+    bool synced = FlushViewOfFile(cache->base, 0) != 0;
+#else
+    bool synced = msync(cache->base, cache->size, MS_SYNC) == 0;
+#endif
+
+    char path[sizeof(cache->path)];
+    char temp_path[sizeof(cache->temp_path)];
+    strcpy(path, cache->path);
+    strcpy(temp_path, cache->temp_path);
+    motion_cache_unmap(cache);
+
+    if (!complete || !synced) {
+        remove(temp_path);
+        return;
+    }
+
+#ifdef _WIN32
+    bool renamed = MoveFileExA(temp_path, path, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    bool renamed = rename(temp_path, path) == 0;
+#endif
+    if (!renamed) {
+        fprintf(stderr, "Warning: Could not move motion cache into place at %s\n", path);
+        remove(temp_path);
+    }
+}
+
+#define PACKET_INDEX_MAGIC "SWBIX001"
+#define PACKET_INDEX_INITIAL_CAPACITY 4096
+
+typedef struct {
+    char magic[8];
+    uint64_t key;
+    int32_t time_base_num;
+    int32_t time_base_den;
+    int64_t count;
+    int64_t keyframes;
+} PacketIndexHeader;
+
+typedef struct {
+    int64_t pts;
+    int64_t dts;
+    int64_t pos;
+    int32_t size;
+    int32_t flags;
+} PacketIndexEntry;
+
+struct PacketIndex {
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#else
+    int fd;
+#endif
+    uint8_t* base;
+    size_t size;
+    const PacketIndexHeader* header;
+    const PacketIndexEntry* entries;
+    PacketIndexEntry* recorded;
+    int64_t recorded_count;
+    int64_t recorded_capacity;
+    int64_t keyframes;
+    uint64_t key;
+    AVRational time_base;
+    bool verbose;
+    char path[1024];
+};
+
+static bool packet_index_map(PacketIndex* index) {
+#ifdef _WIN32
+    index->file = CreateFileA(index->path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL, NULL);
+    LARGE_INTEGER size;
+    if (index->file == INVALID_HANDLE_VALUE || !GetFileSizeEx(index->file, &size) ||
+        (size_t)size.QuadPart < sizeof(PacketIndexHeader)) {
+        return false;
+    }
+    index->size = (size_t)size.QuadPart;
+    index->mapping = CreateFileMapping(index->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    index->base = index->mapping ? (uint8_t*)MapViewOfFile(index->mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+#else
+    index->fd = open(index->path, O_RDONLY);
+    struct stat st;
+    if (index->fd < 0 || fstat(index->fd, &st) != 0 || (size_t)st.st_size < sizeof(PacketIndexHeader)) {
+        return false;
+    }
+    index->size = (size_t)st.st_size;
+    void* map = mmap(NULL, index->size, PROT_READ, MAP_SHARED, index->fd, 0);
+    index->base = map == MAP_FAILED ? NULL : (uint8_t*)map;
+#endif
+    return index->base != NULL;
+}
+
+static void packet_index_unmap(PacketIndex* index) {
+#ifdef _WIN32
+    if (index->base) UnmapViewOfFile(index->base);
+    if (index->mapping) CloseHandle(index->mapping);
+    if (index->file != INVALID_HANDLE_VALUE) CloseHandle(index->file);
+    index->mapping = NULL;
+    index->file = INVALID_HANDLE_VALUE;
+#else
+    if (index->base) munmap(index->base, index->size);
+    if (index->fd >= 0) close(index->fd);
+    index->fd = -1;
+#endif
+    index->base = NULL;
+    index->header = NULL;
+    index->entries = NULL;
+}
+
+static PacketIndex* packet_index_open(const BlurConfig* config, const VideoContext* input) {
+    if (!config->packet_index || is_pipe_path(config->input_file)) {
+        return NULL;
+    }
+
+    uint64_t file_hash;
+    if (!hash_input_file(config->input_file, &file_hash)) {
+        fprintf(stderr, "Warning: Could not hash input for packet index\n");
+        return NULL;
+    }
+
+    PacketIndex* index = (PacketIndex*)calloc(1, sizeof(PacketIndex));
+    if (!index) return NULL;
+#ifdef _WIN32
+    index->file = INVALID_HANDLE_VALUE;
+#else
+    index->fd = -1;
+#endif
+    index->key = fnv1a_update(file_hash, &input->video_stream_idx, sizeof(input->video_stream_idx));
+    index->time_base = input->video_stream->time_base;
+    index->verbose = config->verbose;
+    if (strlen(config->cache_dir) > 0) {
+        snprintf(index->path, sizeof(index->path), "%s/%016llx.swbidx", config->cache_dir,
+            (unsigned long long)index->key);
+    }
+    else {
+        snprintf(index->path, sizeof(index->path), "%s.swbidx", config->input_file);
+    }
+
+    if (packet_index_map(index)) {
+        const PacketIndexHeader* header = (const PacketIndexHeader*)index->base;
+        if (memcmp(header->magic, PACKET_INDEX_MAGIC, 8) == 0 && header->key == index->key &&
+            header->time_base_num == index->time_base.num && header->time_base_den == index->time_base.den &&
+            header->count > 0 &&
+            index->size >= sizeof(PacketIndexHeader) + (size_t)header->count * sizeof(PacketIndexEntry)) {
+            index->header = header;
+            index->entries = (const PacketIndexEntry*)(index->base + sizeof(PacketIndexHeader));
+            if (config->verbose) {
+                printf("Packet index hit: %s (%lld packets, %lld keyframes)\n", index->path,
+                    (long long)header->count, (long long)header->keyframes);
+            }
+            return index;
+        }
+    }
+
+    packet_index_unmap(index);
+    if (config->verbose) {
+        printf("Packet index miss, recording packets to %s\n", index->path);
+    }
+    return index;
+}
+
+static void packet_index_record(PacketIndex* index, const AVPacket* packet) {
+    if (!index || index->header || index->recorded_capacity < 0) return;
+
+    if (index->recorded_count == index->recorded_capacity) {
+        int64_t capacity = index->recorded_capacity > 0 ? index->recorded_capacity * 2 : PACKET_INDEX_INITIAL_CAPACITY;
+        PacketIndexEntry* recorded = (PacketIndexEntry*)realloc(index->recorded, capacity * sizeof(PacketIndexEntry));
+        if (!recorded) {
+            free(index->recorded);
+            index->recorded = NULL;
+            index->recorded_capacity = -1;
+            return;
+        }
+        index->recorded = recorded;
+        index->recorded_capacity = capacity;
+    }
+
+    PacketIndexEntry* entry = &index->recorded[index->recorded_count++];
+    entry->pts = packet->pts;
+    entry->dts = packet->dts != AV_NOPTS_VALUE ? packet->dts : packet->pts;
+    entry->pos = packet->pos;
+    entry->size = packet->size;
+    entry->flags = packet->flags;
+    if (packet->flags & AV_PKT_FLAG_KEY) {
+        index->keyframes++;
+    }
+}
+
+static void packet_index_save(PacketIndex* index, bool complete) {
+    if (!index || index->header || !index->recorded || index->recorded_count == 0) return;
+
+    if (!complete) {
+        if (index->verbose) {
+            printf("Packet index not saved, the input was not read to the end\n");
+        }
+        return;
+    }
+
+    PacketIndexHeader header = { 0 };
+    memcpy(header.magic, PACKET_INDEX_MAGIC, 8);
+    header.key = index->key;
+    header.time_base_num = index->time_base.num;
+    header.time_base_den = index->time_base.den;
+    header.count = index->recorded_count;
+    header.keyframes = index->keyframes;
+
+    FILE* file = fopen(index->path, "wb");
+    bool written = file &&
+        fwrite(&header, sizeof(header), 1, file) == 1 &&
+        fwrite(index->recorded, sizeof(PacketIndexEntry), (size_t)index->recorded_count, file) ==
+            (size_t)index->recorded_count;
+    if (file && fclose(file) != 0) {
+        written = false;
+    }
+
+    if (!written) {
+        fprintf(stderr, "Warning: Could not write packet index %s\n", index->path);
+        remove(index->path);
+    }
+    else if (index->verbose) {
+        printf("Packet index saved: %s (%lld packets, %lld keyframes)\n", index->path,
+            (long long)index->recorded_count, (long long)index->keyframes);
+    }
+}
+
+static void packet_index_close(PacketIndex* index) {
+    if (!index) return;
+
+    packet_index_unmap(index);
+    free(index->recorded);
+    free(index);
+}
+
+static int64_t packet_index_frame_count(const PacketIndex* index) {
+    return index && index->header ? index->header->count : 0;
+}
+
+static const PacketIndexEntry* packet_index_find_keyframe(const PacketIndex* index, int64_t ts) {
+    if (!index || !index->header) return NULL;
+
+    int64_t low = 0;
+    int64_t high = index->header->count;
+    while (low < high) {
+        int64_t mid = low + (high - low) / 2;
+        if (index->entries[mid].dts <= ts) {
+            low = mid + 1;
+        }
+        else {
+            high = mid;
+        }
+    }
+
+    for (int64_t i = low - 1; i >= 0; i--) {
+        const PacketIndexEntry* entry = &index->entries[i];
+        if ((entry->flags & AV_PKT_FLAG_KEY) && entry->pts != AV_NOPTS_VALUE && entry->pts <= ts) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+static int64_t estimate_input_frames(void) {
+    int64_t indexed = packet_index_frame_count(g_input_ctx->packet_index);
+    if (indexed > 0) {
+        return indexed;
+    }
+
+    int64_t frames = g_input_ctx->video_stream->nb_frames;
+    double fps = av_q2d(g_input_ctx->video_stream->avg_frame_rate);
+    if (frames <= 0 && g_input_ctx->fmt_ctx->duration != AV_NOPTS_VALUE && fps > 0) {
+        frames = (int64_t)(g_input_ctx->fmt_ctx->duration * fps / AV_TIME_BASE) + 1;
+    }
+    return frames;
+}
+
+static bool trim_before(int64_t ts, AVRational time_base, int64_t bound) {
+    return g_trim.active && ts != AV_NOPTS_VALUE && av_compare_ts(ts, time_base, bound, AV_TIME_BASE_Q) < 0;
+}
+
+static bool trim_after_end(int64_t ts, AVRational time_base) {
+    return g_trim.active && ts != AV_NOPTS_VALUE && av_compare_ts(ts, time_base, g_trim.end, AV_TIME_BASE_Q) >= 0;
+}
+
+static void blur_ring_advance(BlurFrameBuffer* blur_buffer) {
+    blur_buffer->current_pos = (blur_buffer->current_pos + 1) % blur_buffer->capacity;
+    if (blur_buffer->count < blur_buffer->capacity) {
+        blur_buffer->count++;
+    }
+}
+
+#ifdef _WIN32
+static long atomic_load_long(volatile long* value) {
+    return InterlockedCompareExchange(value, 0, 0);
+}
+
+static void atomic_store_long(volatile long* value, long desired) {
+    InterlockedExchange(value, desired);
+}
+
+static bool atomic_cas_long(volatile long* value, long expected, long desired) {
+    return InterlockedCompareExchange(value, desired, expected) == expected;
+}
+#else
+static long atomic_load_long(volatile long* value) {
+    return __atomic_load_n(value, __ATOMIC_ACQUIRE);
+}
+
+static void atomic_store_long(volatile long* value, long desired) {
+    __atomic_store_n(value, desired, __ATOMIC_RELEASE);
+}
+
+static bool atomic_cas_long(volatile long* value, long expected, long desired) {
+    return __atomic_compare_exchange_n(value, &expected, desired, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+}
+#endif
+
+static bool packet_ring_init(PacketRing* ring, int capacity) {
+    ring->cells = (PacketCell*)calloc(capacity, sizeof(PacketCell));
+    if (!ring->cells) return false;
+
+    for (int i = 0; i < capacity; i++) {
+        ring->cells[i].sequence = i;
+    }
+    ring->mask = capacity - 1;
+    ring->enqueue_pos = 0;
+    ring->dequeue_pos = 0;
+    return true;
+}
+
+static bool packet_ring_push(PacketRing* ring, void* data) {
+    long pos = atomic_load_long(&ring->enqueue_pos);
+
+    while (true) {
+        PacketCell* cell = &ring->cells[pos & ring->mask];
+        long diff = (long)((unsigned long)atomic_load_long(&cell->sequence) - (unsigned long)pos);
+
+        if (diff == 0) {
+            if (atomic_cas_long(&ring->enqueue_pos, pos, (long)((unsigned long)pos + 1))) {
+                cell->data = data;
+                atomic_store_long(&cell->sequence, (long)((unsigned long)pos + 1));
+                return true;
+            }
+            pos = atomic_load_long(&ring->enqueue_pos);
+        }
+        else if (diff < 0) {
+            return false;
+        }
+        else {
+            pos = atomic_load_long(&ring->enqueue_pos);
+        }
+    }
+}
+
+static void* packet_ring_pop(PacketRing* ring) {
+    long pos = atomic_load_long(&ring->dequeue_pos);
+
+    while (true) {
+        PacketCell* cell = &ring->cells[pos & ring->mask];
+        long diff = (long)((unsigned long)atomic_load_long(&cell->sequence) - ((unsigned long)pos + 1));
+
+        if (diff == 0) {
+            if (atomic_cas_long(&ring->dequeue_pos, pos, (long)((unsigned long)pos + 1))) {
+                void* data = cell->data;
+                atomic_store_long(&cell->sequence, (long)((unsigned long)pos + ring->mask + 1));
+                return data;
+            }
+            pos = atomic_load_long(&ring->dequeue_pos);
+        }
+        else if (diff < 0) {
+            return NULL;
+        }
+        else {
+            pos = atomic_load_long(&ring->dequeue_pos);
+        }
+    }
+}
+
+static THREAD_FUNC mux_thread(void* arg) {
+    Muxer* muxer = (Muxer*)arg;
+    int64_t written = 0;
+
+    while (true) {
+        MuxItem* item = (MuxItem*)packet_ring_pop(&muxer->queue);
+        if (!item) {
+            if (atomic_load_long(&muxer->stopping)) {
+                break;
+            }
+            av_usleep(500);
+            continue;
+        }
+
+        int ret = av_interleaved_write_frame(item->output->fmt_ctx, item->packet);
+        if (ret < 0 && muxer->debug) {
+            fprintf(stderr, "Error writing packet: %d\n", ret);
+        }
+        av_packet_unref(item->packet);
+        written++;
+
+        while (!packet_ring_push(&muxer->pool, item)) {
+            av_usleep(100);
+        }
+    }
+
+    if (muxer->debug) {
+        printf("Mux thread finished, wrote %lld packets\n", (long long)written);
+    }
+
+#ifdef _WIN32
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+static void mux_destroy(void) {
+    for (int i = 0; i < g_muxer.item_count; i++) {
+        av_packet_free(&g_muxer.items[i].packet);
+    }
+    free(g_muxer.items);
+    free(g_muxer.queue.cells);
+    free(g_muxer.pool.cells);
+    memset(&g_muxer, 0, sizeof(g_muxer));
+}
+
+static bool mux_start(bool debug) {
+    g_muxer.debug = debug;
+    g_muxer.items = (MuxItem*)calloc(MUX_QUEUE_PACKETS, sizeof(MuxItem));
+    if (!g_muxer.items || !packet_ring_init(&g_muxer.queue, MUX_QUEUE_PACKETS) ||
+        !packet_ring_init(&g_muxer.pool, MUX_QUEUE_PACKETS)) {
+        mux_destroy();
+        return false;
+    }
+
+    for (int i = 0; i < MUX_QUEUE_PACKETS; i++) {
+        g_muxer.items[i].packet = av_packet_alloc();
+        if (!g_muxer.items[i].packet) {
+            mux_destroy();
+            return false;
+        }
+        g_muxer.item_count = i + 1;
+        packet_ring_push(&g_muxer.pool, &g_muxer.items[i]);
+    }
+
+#ifdef _WIN32
+    g_muxer.thread = CreateThread(NULL, 0, mux_thread, &g_muxer, 0, NULL);
+    g_muxer.started = g_muxer.thread != NULL;
+#else
+    g_muxer.started = pthread_create(&g_muxer.thread, NULL, mux_thread, &g_muxer) == 0;
+#endif
+
+    if (!g_muxer.started) {
+        mux_destroy();
+        return false;
+    }
+    return true;
+}
+
+static void mux_stop(void) {
+    if (g_muxer.started) {
+        atomic_store_long(&g_muxer.stopping, 1);
+#ifdef _WIN32
+        WaitForSingleObject(g_muxer.thread, INFINITE);
+        CloseHandle(g_muxer.thread);
+#else
+        pthread_join(g_muxer.thread, NULL);
+#endif
+    }
+    mux_destroy();
+}
+
+static MuxItem* mux_acquire(void) {
+    MuxItem* item;
+    while (!(item = (MuxItem*)packet_ring_pop(&g_muxer.pool))) {
+        av_usleep(100);
+    }
+    return item;
+}
+
+static void mux_submit(MuxItem* item, VideoContext* output) {
+    item->output = output;
+    while (!packet_ring_push(&g_muxer.queue, item)) {
+        av_usleep(100);
+    }
+}
+
+static void write_packet(VideoContext* output, AVPacket* packet) {
+    if (!g_muxer.started) {
+        fprintf(stderr, "Dropping packet for stream %d, mux thread is not running\n", packet->stream_index);
+        av_packet_unref(packet);
+        return;
+    }
+
+    MuxItem* item = mux_acquire();
+    av_packet_move_ref(item->packet, packet);
+    mux_submit(item, output);
+}
+
+static void encode_frame(VideoContext* output, const BlurConfig* config, AVFrame* frame) {
+    int64_t source_pts = frame->pts;
+    int64_t pts = output->next_pts == AV_NOPTS_VALUE ? 0 : output->next_pts;
+
+    AVRational time_base = output->raw_sink ? output->raw_sink->time_base :
+        output->shm_sink ? output->shm_sink->time_base :
+        output->image_sink ? output->image_sink->time_base : output->codec_ctx->time_base;
+
+    if (source_pts != AV_NOPTS_VALUE && g_input_ctx && g_input_ctx->video_stream) {
+        if (trim_before(source_pts, g_input_ctx->video_stream->time_base, g_trim.start)) {
+            return;
+        }
+        pts = av_rescale_q(source_pts, g_input_ctx->video_stream->time_base, time_base);
+        if (g_trim.active) {
+            pts -= av_rescale_q(g_trim.start, AV_TIME_BASE_Q, time_base);
+        }
+        if (config->timescale != 1.0) {
+            pts = (int64_t)llrint(pts / config->timescale);
+        }
+        if (output->next_pts != AV_NOPTS_VALUE && pts < output->next_pts) {
+            return;
+        }
+    }
+
+    output->next_pts = pts + 1;
+
+    if (output->raw_sink) {
+        raw_sink_write_frame(output->raw_sink, frame);
+        return;
+    }
+
+    if (output->shm_sink) {
+        shm_sink_write_frame(output->shm_sink, frame, pts);
+        return;
+    }
+
+    if (output->image_sink) {
+        image_sink_write_frame(output->image_sink, frame);
+        return;
+    }
+
+    frame->pts = pts;
+    int ret = avcodec_send_frame(output->codec_ctx, frame);
+    frame->pts = source_pts;
+    if (ret < 0) {
+        if (config->debug) {
+            fprintf(stderr, "Error sending frame to encoder: %d\n", ret);
+        }
+    }
+
+    while (ret >= 0) {
+        ret = avcodec_receive_packet(output->codec_ctx, output->packet);
+        if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
+            break;
+        }
+        else if (ret < 0) {
+            if (config->debug) {
+                fprintf(stderr, "Error receiving packet from encoder: %d\n", ret);
+            }
+            break;
+        }
+
+        output->packet->stream_index = output->video_stream->index;
+        av_packet_rescale_ts(output->packet,
+            output->codec_ctx->time_base,
+            output->video_stream->time_base);
+
+        write_packet(output, output->packet);
+    }
+}
+
+static void publish_renditions(RenderBranch* branch, AVFrame* frame) {
+    SharedFrame* shared = shared_frame_acquire();
+    if (!shared) return;
+
+    frame_buffer_copy(&shared->frame, frame);
+    shared_frame_fan_out(shared, branch->rendition_queues, branch->rendition_count, NULL);
+}
+
+static void encode_frame_buffer(RenderBranch* branch, FrameBuffer* output_buffer, AVFrame* output_frame) {
+    frame_buffer_to_avframe(output_buffer, output_frame);
+    encode_frame(branch->output, branch->config, output_frame);
+
+    if (branch->rendition_count > 0) {
+        publish_renditions(branch, output_frame);
+    }
+}
+
+static void blur_and_encode(RenderBranch* branch, BlurFrameBuffer* blur_buffer, int blur_frame_count,
+    float* weights, FrameBuffer* output_buffer, AVFrame* output_frame) {
+    FrameBuffer* ordered_frames = (FrameBuffer*)malloc(blur_frame_count * sizeof(FrameBuffer));
+    if (!ordered_frames) return;
+
+    for (int i = 0; i < blur_frame_count; i++) {
+        int idx = (blur_buffer->current_pos - blur_frame_count + i + blur_buffer->capacity) % blur_buffer->capacity;
+        ordered_frames[i] = blur_buffer->buffer[idx];
+    }
+
+    if (apply_motion_blur(ordered_frames, blur_frame_count, weights, output_buffer)) {
+        encode_frame_buffer(branch, output_buffer, output_frame);
+    }
+
+    free(ordered_frames);
+}
+
+static int get_blur_frame_count(const BlurConfig* config, double input_fps, double output_fps, int interp_factor) {
+    int blur_frame_count = (int)(output_fps / input_fps * config->blur_amount * 5.0 + 0.5);
+    if (interp_factor > 1) {
+        blur_frame_count = (int)(interp_factor * config->blur_amount + 0.5);
+    }
+    if (blur_frame_count < 1) blur_frame_count = 1;
+    if (blur_frame_count > 64) blur_frame_count = 64;
+    return blur_frame_count;
+}
+
+static int get_fused_frame_count(int blur_frame_count, int interp_factor) {
+    return (blur_frame_count - 1 + interp_factor - 1) / interp_factor + 1;
+}
+
+static int get_preroll_frames(const BlurConfig* config, double input_fps) {
+    if (strcmp(config->blur_mode, "vector") == 0) {
+        return 1;
+    }
+
+    double output_fps = parse_fps_string(config->blur_output_fps, input_fps);
+    int interp_factor = get_interpolation_factor(config, input_fps);
+    int blur_frame_count = get_blur_frame_count(config, input_fps, output_fps, interp_factor);
+    return get_fused_frame_count(blur_frame_count, interp_factor) - 1;
+}
+
+static void trim_open(const BlurConfig* config, double input_fps) {
+    if (config->start_time <= 0 && config->end_time <= 0) {
+        return;
+    }
+
+    AVFormatContext* fmt_ctx = g_input_ctx->fmt_ctx;
+    AVStream* stream = g_input_ctx->video_stream;
+    int64_t origin = fmt_ctx->start_time != AV_NOPTS_VALUE ? fmt_ctx->start_time : 0;
+
+    int preroll_frames = 0;
+    for (int i = 0; i < g_branch_count; i++) {
+        preroll_frames = FFMAX(preroll_frames, get_preroll_frames(g_branches[i].config, input_fps));
+    }
+
+    g_trim.active = true;
+    g_trim.start = origin + (int64_t)llrint(config->start_time * (double)AV_TIME_BASE);
+    g_trim.end = config->end_time > 0 ? origin + (int64_t)llrint(config->end_time * (double)AV_TIME_BASE) : INT64_MAX;
+    g_trim.preroll = g_trim.start;
+    if (input_fps > 0) {
+        g_trim.preroll -= (int64_t)llrint((preroll_frames + 0.5) * AV_TIME_BASE / input_fps);
+    }
+
+    if (config->start_time <= 0) {
+        return;
+    }
+
+    int64_t seek_ts = av_rescale_q(g_trim.preroll, AV_TIME_BASE_Q, stream->time_base);
+    const PacketIndexEntry* keyframe = packet_index_find_keyframe(g_input_ctx->packet_index, seek_ts);
+
+    if (config->verbose) {
+        printf("Seeking to %.3f s with %d frames of pre-roll\n", config->start_time, preroll_frames);
+        if (keyframe) {
+            printf("Indexed keyframe at pts %lld, byte %lld\n", (long long)keyframe->pts, (long long)keyframe->pos);
+        }
+    }
+
+    int ret;
+    if (keyframe && keyframe->pos >= 0 && (fmt_ctx->iformat->flags & AVFMT_TS_DISCONT) &&
+        !(fmt_ctx->iformat->flags & AVFMT_NO_BYTE_SEEK)) {
+        ret = av_seek_frame(fmt_ctx, g_input_ctx->video_stream_idx, keyframe->pos, AVSEEK_FLAG_BYTE);
+    }
+    else {
+        ret = av_seek_frame(fmt_ctx, g_input_ctx->video_stream_idx, keyframe ? keyframe->pts : seek_ts,
+            AVSEEK_FLAG_BACKWARD);
+    }
+    if (ret < 0) {
+        fprintf(stderr, "Warning: Seeking to %.3f s failed, decoding from the beginning\n", config->start_time);
+        return;
+    }
+    avcodec_flush_buffers(g_input_ctx->codec_ctx);
+}
+
+static void fused_blur_and_encode(RenderBranch* branch, InterpolationContext* interp,
+    BlurFrameBuffer* blur_buffer, MotionPair* pairs, int blur_frame_count, int interp_factor,
+    float* weights, BlendAccumulator* accum, FrameBuffer* output_buffer, AVFrame* output_frame) {
+    int newest = (blur_buffer->current_pos - 1 + blur_buffer->capacity) % blur_buffer->capacity;
+    int64_t middle_pts = 0;
+
+    blend_accumulator_clear(accum);
+
+    for (int i = 0; i < blur_frame_count; i++) {
+        int distance = blur_frame_count - 1 - i;
+        int phase = distance % interp_factor;
+        int idx = (newest - distance / interp_factor + blur_buffer->capacity) % blur_buffer->capacity;
+        FrameBuffer* next = &blur_buffer->buffer[idx];
+        int64_t pts = next->pts;
+
+        if (phase == 0) {
+            accumulate_frame(accum, next, weights[i], interp->pool);
+        }
+        else {
+            FrameBuffer* prev = &blur_buffer->buffer[(idx - 1 + blur_buffer->capacity) % blur_buffer->capacity];
+            float t = (float)(interp_factor - phase) / interp_factor;
+            interpolation_accumulate(interp, &pairs[idx], prev, next, t, weights[i], accum);
+            pts = prev->pts + (int64_t)((next->pts - prev->pts) * (double)t + 0.5);
+        }
+
+        if (i == blur_frame_count / 2) {
+            middle_pts = pts;
+        }
+    }
+
+    if (blend_accumulator_resolve(accum, output_buffer)) {
+        output_buffer->pts = middle_pts;
+        encode_frame_buffer(branch, output_buffer, output_frame);
+    }
+}
+
+static void flush_encoder(VideoContext* output) {
+    if (output->raw_sink || output->shm_sink || output->image_sink) return;
+
+    avcodec_send_frame(output->codec_ctx, NULL);
+    while (true) {
+        int ret = avcodec_receive_packet(output->codec_ctx, output->packet);
+        if (ret == AVERROR_EOF) {
+            break;
+        }
+        else if (ret < 0) {
+            break;
+        }
+
+        output->packet->stream_index = output->video_stream->index;
+        av_packet_rescale_ts(output->packet,
+            output->codec_ctx->time_base,
+            output->video_stream->time_base);
+
+        write_packet(output, output->packet);
+    }
+}
+
+static THREAD_FUNC processing_thread(void* arg) {
+    RenderBranch* branch = (RenderBranch*)arg;
+    const BlurConfig* config = branch->config;
+    BlurFrameBuffer blur_buffer = { 0 };
+    int weight_count = 0;
+    float* weights = NULL;
+
+    double input_fps = av_q2d(g_input_ctx->video_stream->avg_frame_rate);
+    double output_fps = parse_fps_string(config->blur_output_fps, input_fps);
+
+    int interp_factor = get_interpolation_factor(config, input_fps);
+    InterpolationContext* interp = NULL;
+    MotionPair* pairs = NULL;
+    MotionCache* motion_cache = NULL;
+    BlendAccumulator accum = { 0 };
+    bool fused = false;
+
+    int blur_frame_count = get_blur_frame_count(config, input_fps, output_fps, interp_factor);
+
+    if (interp_factor > 1 && vapoursynth_active()) {
+        if (config->verbose) {
+            printf("Frames are interpolated %dx by VapourSynth (%s)\n", interp_factor, config->interpolation_method);
+        }
+        interp_factor = 1;
+    }
+
+    weights = config_get_weights(config, blur_frame_count, interp_factor, &weight_count);
+    if (!weights) {
+        fprintf(stderr, "Failed to generate blur weights\n");
+#ifdef _WIN32
+        return 1;
+#else
+        return NULL;
+#endif
+    }
+
+    if (interp_factor > 1 && strcmp(config->interpolation_method, "blend") == 0) {
+        if (config->verbose) {
+            printf("Folded %dx linear blend interpolation into %d blur weights\n", interp_factor, weight_count);
+        }
+        blur_frame_count = weight_count;
+        interp_factor = 1;
+    }
+
+    if (interp_factor > 1) {
+        if (strcmp(config->interpolation_method, "native") != 0 && config->verbose) {
+            printf("Interpolation method '%s' is not available, using native block matching\n",
+                config->interpolation_method);
+        }
+
+        interp = interpolation_create(config, g_frame_width, g_frame_height);
+        if (!interp) {
+            fprintf(stderr, "Failed to create interpolation context, continuing without interpolation\n");
+            interp_factor = 1;
+        }
+    }
+
+    if (interp && strlen(config->cache_dir) > 0 && !g_trim.active) {
+        motion_cache = motion_cache_open(config, interp, estimate_input_frames());
+    }
+
+    fused = interp && config->fused_interpolation;
+    blur_buffer.capacity = fused ? get_fused_frame_count(blur_frame_count, interp_factor) :
+        blur_frame_count + interp_factor;
+    blur_buffer.buffer = (FrameBuffer*)calloc(blur_buffer.capacity, sizeof(FrameBuffer));
+    blur_buffer.count = 0;
+    blur_buffer.current_pos = 0;
+
+    if (fused) {
+        pairs = (MotionPair*)calloc(blur_buffer.capacity, sizeof(MotionPair));
+        bool allocated = pairs != NULL &&
+            blend_accumulator_alloc(&accum, g_frame_width, g_frame_height);
+        for (int i = 0; allocated && i < blur_buffer.capacity; i++) {
+            allocated = motion_pair_alloc(&pairs[i], interp->blocks_x, interp->blocks_y);
+        }
+
+        if (!allocated) {
+            fprintf(stderr, "Failed to allocate fused interpolation buffers, interpolating into the ring\n");
+            if (pairs) {
+                for (int i = 0; i < blur_buffer.capacity; i++) {
+                    motion_pair_free(&pairs[i]);
+                }
+                free(pairs);
+                pairs = NULL;
+            }
+            blend_accumulator_free(&accum);
+            fused = false;
+
+            free(blur_buffer.buffer);
+            blur_buffer.capacity = blur_frame_count + interp_factor;
+            blur_buffer.buffer = (FrameBuffer*)calloc(blur_buffer.capacity, sizeof(FrameBuffer));
+        }
+    }
+
+    if (!blur_buffer.buffer) {
+        interpolation_destroy(interp);
+        free(weights);
+#ifdef _WIN32
+        return 1;
+#else
+        return NULL;
+#endif
+    }
+
+    FrameBuffer output_buffer = { 0 };
+    FrameBuffer incoming = { 0 };
+    AVFrame* output_frame = av_frame_alloc();
+    AVFrame* input_frame = av_frame_alloc();
+
+    int frames_processed = 0;
+    int previous_pos = -1;
+    FrameBuffer dedup_frames[16] = { 0 };
+    int dedup_count = 0;
+
+    if (config->verbose) {
+        if (interp_factor > 1) {
+            printf("Interpolating %dx with %dpx blocks on %d threads%s\n",
+                interp_factor, interp->block_size, interp->thread_count,
+                fused ? ", fused into the blur" : "");
+        }
+        printf("Processing with %d blur frames, weights: ", blur_frame_count);
+        for (int i = 0; i < weight_count; i++) {
+            printf("%.3f ", weights[i]);
+        }
+        printf("\n");
+    }
+
+    while (!is_interrupted()) {
+        if (!frame_queue_pop(branch->queue, &incoming)) {
+            break;
+        }
+
+        bool is_duplicate = false;
+
+        if (config->deduplicate && dedup_count > 0) {
+            FrameBuffer temp_buffer = { 0 };
+            frame_buffer_to_avframe(&incoming, input_frame);
+            frame_buffer_copy(&temp_buffer, input_frame);
+
+            for (int i = 0; i < dedup_count && i < config->deduplicate_range; i++) {
+                if (detect_duplicate_frames(&temp_buffer, &dedup_frames[i], config->deduplicate_threshold)) {
+                    is_duplicate = true;
+                    break;
+                }
+            }
+
+            if (!is_duplicate && dedup_count < 16) {
+                frame_buffer_free(&dedup_frames[dedup_count]);
+                dedup_frames[dedup_count] = temp_buffer;
+                dedup_count++;
+            }
+            else {
+                frame_buffer_free(&temp_buffer);
+            }
+        }
+
+        if (is_duplicate) {
+            continue;
+        }
+
+        int real_pos = blur_buffer.current_pos;
+        if (interp && !fused && previous_pos >= 0) {
+            real_pos = (blur_buffer.current_pos + interp_factor - 1) % blur_buffer.capacity;
+        }
+        FrameBuffer recycled = blur_buffer.buffer[real_pos];
+        blur_buffer.buffer[real_pos] = incoming;
+        incoming = recycled;
+
+        if (fused && previous_pos >= 0) {
+            motion_cache_prepare(motion_cache, interp, &blur_buffer.buffer[previous_pos],
+                &blur_buffer.buffer[real_pos], &pairs[real_pos], frames_processed);
+        }
+        else if (interp && previous_pos >= 0) {
+            FrameBuffer* prev = &blur_buffer.buffer[previous_pos];
+            FrameBuffer* next = &blur_buffer.buffer[real_pos];
+
+            motion_cache_prepare(motion_cache, interp, prev, next, &interp->pair, frames_processed);
+            for (int i = 1; i < interp_factor; i++) {
+                FrameBuffer* slot = &blur_buffer.buffer[blur_buffer.current_pos];
+                interpolation_generate(interp, &interp->pair, prev, next, (float)i / interp_factor, slot);
+                blur_ring_advance(&blur_buffer);
+            }
+        }
+
+        blur_ring_advance(&blur_buffer);
+        previous_pos = real_pos;
+
+        if (fused) {
+            if (blur_buffer.count >= blur_buffer.capacity) {
+                fused_blur_and_encode(branch, interp, &blur_buffer, pairs, blur_frame_count, interp_factor,
+                    weights, &accum, &output_buffer, output_frame);
+            }
+        }
+        else if (blur_buffer.count >= blur_frame_count) {
+            blur_and_encode(branch, &blur_buffer, blur_frame_count, weights, &output_buffer, output_frame);
+        }
+
+        frames_processed++;
+        if (branch->index == 0 && frames_processed % 30 == 0) {
+            update_progress(frames_processed);
+        }
+    }
+
+    flush_encoder(branch->output);
+
+    frame_buffer_free(&output_buffer);
+    frame_buffer_free(&incoming);
+
+    for (int i = 0; i < blur_buffer.capacity; i++) {
+        frame_buffer_free(&blur_buffer.buffer[i]);
+    }
+
+    for (int i = 0; i < dedup_count; i++) {
+        frame_buffer_free(&dedup_frames[i]);
+    }
+
+    if (pairs) {
+        for (int i = 0; i < blur_buffer.capacity; i++) {
+            motion_pair_free(&pairs[i]);
+        }
+        free(pairs);
+    }
+
+    motion_cache_close(motion_cache, frames_processed, !is_interrupted());
+    blend_accumulator_free(&accum);
+    free(blur_buffer.buffer);
+    free(weights);
+    interpolation_destroy(interp);
+    av_frame_free(&output_frame);
+    av_frame_free(&input_frame);
+
+    if (config->verbose) {
+        printf("Processing thread finished, processed %d frames\n", frames_processed);
+    }
+
+#ifdef _WIN32
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+#define VECTOR_BLUR_MAX_TAPS 32
+
+typedef struct {
+    InterpolationContext* ctx;
+    const MotionPair* pair;
+    const FrameBuffer* src;
+    FrameBuffer* output;
+    float amount;
+} VectorBlurJob;
+
+static void line_blur_block(const uint8_t* src, int src_stride, uint8_t* dst, int dst_stride,
+    int width, int height, int x0, int y0, int bw, int bh, float dx, float dy) {
+    int taps = (int)ceilf(FFMAX(fabsf(dx), fabsf(dy))) + 1;
+    if (taps > VECTOR_BLUR_MAX_TAPS) taps = VECTOR_BLUR_MAX_TAPS;
+
+    if (taps <= 1) {
+        for (int y = y0; y < y0 + bh; y++) {
+            memcpy(dst + y * dst_stride + x0, src + y * src_stride + x0, bw);
+        }
+        return;
+    }
+
+    int offset_x[VECTOR_BLUR_MAX_TAPS];
+    int offset_y[VECTOR_BLUR_MAX_TAPS];
+    int min_x = 0, max_x = 0, min_y = 0, max_y = 0;
+    for (int k = 0; k < taps; k++) {
+        offset_x[k] = (int)lrintf(dx * k / (taps - 1));
+        offset_y[k] = (int)lrintf(dy * k / (taps - 1));
+        min_x = FFMIN(min_x, offset_x[k]);
+        max_x = FFMAX(max_x, offset_x[k]);
+        min_y = FFMIN(min_y, offset_y[k]);
+        max_y = FFMAX(max_y, offset_y[k]);
+    }
+
+    uint32_t reciprocal = (65536 + taps - 1) / taps;
+    bool inside = x0 + min_x >= 0 && x0 + bw - 1 + max_x < width &&
+        y0 + min_y >= 0 && y0 + bh - 1 + max_y < height;
+
+    for (int y = y0; y < y0 + bh; y++) {
+        uint8_t* out = dst + y * dst_stride;
+        int x = x0;
+
+#ifdef HAVE_SSE2
+        if (inside) {
+            __m128i zero = _mm_setzero_si128();
+            __m128i bias = _mm_set1_epi16((short)(taps / 2));
+            __m128i scale = _mm_set1_epi16((short)reciprocal);
+            for (; x + 8 <= x0 + bw; x += 8) {
+                __m128i sum = zero;
+                for (int k = 0; k < taps; k++) {
+                    const uint8_t* row = src + (y + offset_y[k]) * src_stride + x + offset_x[k];
+                    sum = _mm_add_epi16(sum, _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)row), zero));
+                }
+                sum = _mm_mulhi_epu16(_mm_add_epi16(sum, bias), scale);
+                _mm_storel_epi64((__m128i*)(out + x), _mm_packus_epi16(sum, zero));
+            }
+        }
+#endif
+
+        for (; x < x0 + bw; x++) {
+            uint32_t sum = 0;
+            for (int k = 0; k < taps; k++) {
+                int sx = CLAMP(x + offset_x[k], 0, width - 1);
+                int sy = CLAMP(y + offset_y[k], 0, height - 1);
+                sum += src[sy * src_stride + sx];
+            }
+            out[x] = (uint8_t)(((sum + taps / 2) * reciprocal) >> 16);
+        }
+    }
+}
+
+static void vector_blur_rows(void* arg, int start, int end) {
+    VectorBlurJob* job = (VectorBlurJob*)arg;
+    InterpolationContext* ctx = job->ctx;
+    const MotionPair* pair = job->pair;
+
+    for (int by = start; by < end; by++) {
+        for (int bx = 0; bx < ctx->blocks_x; bx++) {
+            int idx = by * ctx->blocks_x + bx;
+            BlockVector bwd = pair->backward.vectors[idx];
+            float vx = 0.0f, vy = 0.0f;
+
+            if (!pair->scene_change && pair->backward.sad[idx] <= INTERP_SCENE_CHANGE_SAD) {
+                vx = bwd.x * job->amount;
+                vy = bwd.y * job->amount;
+            }
+
+            for (int plane = 0; plane < 3; plane++) {
+                int shift = plane ? 1 : 0;
+                int width = plane ? (ctx->width + 1) >> 1 : ctx->width;
+                int height = plane ? (ctx->height + 1) >> 1 : ctx->height;
+                int size = ctx->block_size >> shift;
+                int x0 = bx * size;
+                int y0 = by * size;
+                if (x0 >= width || y0 >= height) continue;
+
+                line_blur_block(job->src->data[plane], job->src->linesize[plane],
+                    job->output->data[plane], job->output->linesize[plane], width, height,
+                    x0, y0, FFMIN(size, width - x0), FFMIN(size, height - y0),
+                    plane ? vx * 0.5f : vx, plane ? vy * 0.5f : vy);
+            }
+        }
+    }
+}
+
+static bool vector_blur_generate(InterpolationContext* ctx, const MotionPair* pair, const FrameBuffer* src,
+    float amount, FrameBuffer* output) {
+    if (!output->allocated) {
+        if (!frame_buffer_alloc(output, ctx->width, ctx->height, AV_PIX_FMT_YUV420P)) {
+            return false;
+        }
+    }
+
+    VectorBlurJob job = { ctx, pair, src, output, amount };
+    run_parallel(ctx->pool, vector_blur_rows, &job, ctx->blocks_y);
+
+    output->pts = src->pts;
+    return true;
+}
+
+static THREAD_FUNC vector_blur_thread(void* arg) {
+    RenderBranch* branch = (RenderBranch*)arg;
+    const BlurConfig* config = branch->config;
+    MotionPair pair = { 0 };
+    FrameBuffer previous = { 0 };
+    FrameBuffer current = { 0 };
+    FrameBuffer incoming = { 0 };
+    FrameBuffer output_buffer = { 0 };
+    AVFrame* output_frame = av_frame_alloc();
+    int frames_processed = 0;
+
+    InterpolationContext* ctx = interpolation_create(config, g_frame_width, g_frame_height);
+    if (!ctx || !output_frame || !motion_pair_alloc(&pair, ctx->blocks_x, ctx->blocks_y)) {
+        fprintf(stderr, "Failed to create vector blur context\n");
+        motion_pair_free(&pair);
+        interpolation_destroy(ctx);
+        av_frame_free(&output_frame);
+#ifdef _WIN32
+        return 1;
+#else
+        return NULL;
+#endif
+    }
+
+    MotionCache* motion_cache = NULL;
+    if (strlen(config->cache_dir) > 0 && !g_trim.active) {
+        motion_cache = motion_cache_open(config, ctx, estimate_input_frames());
+    }
+
+    if (config->verbose) {
+        if (config->interpolate) {
+            printf("Vector blur mode ignores frame interpolation\n");
+        }
+        printf("Processing with vector blur, %dpx blocks on %d threads, amount %.2f\n",
+            ctx->block_size, ctx->thread_count, config->blur_amount);
+    }
+
+    while (!is_interrupted()) {
+        if (!frame_queue_pop(branch->queue, &incoming)) {
+            break;
+        }
+
+        if (config->deduplicate && current.allocated &&
+            detect_duplicate_frames(&incoming, &current, config->deduplicate_threshold)) {
+            continue;
+        }
+
+        FrameBuffer recycled = previous;
+        previous = current;
+        current = incoming;
+        incoming = recycled;
+
+        if (previous.allocated) {
+            motion_cache_prepare(motion_cache, ctx, &previous, &current, &pair, frames_processed);
+            if (vector_blur_generate(ctx, &pair, &current, config->blur_amount, &output_buffer)) {
+                encode_frame_buffer(branch, &output_buffer, output_frame);
+            }
+        }
+        else {
+            encode_frame_buffer(branch, &current, output_frame);
+        }
+
+        frames_processed++;
+        if (branch->index == 0 && frames_processed % 30 == 0) {
+            update_progress(frames_processed);
+        }
+    }
+
+    flush_encoder(branch->output);
+    motion_cache_close(motion_cache, frames_processed, !is_interrupted());
+
+    frame_buffer_free(&previous);
+    frame_buffer_free(&current);
+    frame_buffer_free(&incoming);
+    frame_buffer_free(&output_buffer);
+    motion_pair_free(&pair);
+    interpolation_destroy(ctx);
+    av_frame_free(&output_frame);
+
+    if (config->verbose) {
+        printf("Vector blur thread finished, processed %d frames\n", frames_processed);
+    }
+
+#ifdef _WIN32
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+static struct SwsContext* create_rendition_scaler(const Rendition* rendition, const FrameBuffer* source) {
+    struct SwsContext* sws = sws_alloc_context();
+    if (!sws) return NULL;
+
+    av_opt_set_int(sws, "srcw", source->width, 0);
+    av_opt_set_int(sws, "srch", source->height, 0);
+    av_opt_set_int(sws, "src_format", source->format, 0);
+    av_opt_set_int(sws, "dstw", rendition->width, 0);
+    av_opt_set_int(sws, "dsth", rendition->height, 0);
+    av_opt_set_int(sws, "dst_format", rendition->output->codec_ctx->pix_fmt, 0);
+    av_opt_set_int(sws, "sws_flags", SWS_BICUBIC, 0);
+    av_opt_set_int(sws, "threads", rendition->thread_count, 0);
+
+    if (sws_init_context(sws, NULL, NULL) < 0) {
+        sws_freeContext(sws);
+        return NULL;
+    }
+    return sws;
+}
+
+static THREAD_FUNC rendition_thread(void* arg) {
+    Rendition* rendition = (Rendition*)arg;
+    VideoContext* output = rendition->output;
+    AVFrame* source = av_frame_alloc();
+    AVFrame* scaled = output->frame;
+    FrameBuffer incoming = { 0 };
+    int frames_encoded = 0;
+
+    scaled->width = rendition->width;
+    scaled->height = rendition->height;
+    scaled->format = output->codec_ctx->pix_fmt;
+    bool ready = source && av_frame_get_buffer(scaled, 32) >= 0;
+    if (!ready) {
+        fprintf(stderr, "Failed to allocate %dp rendition frames\n", rendition->height);
+    }
+
+    while (frame_queue_pop(rendition->queue, &incoming)) {
+        if (ready && !output->sws_ctx) {
+            output->sws_ctx = create_rendition_scaler(rendition, &incoming);
+            if (!output->sws_ctx) {
+                fprintf(stderr, "Failed to create %dp rendition scaler\n", rendition->height);
+                ready = false;
+            }
+        }
+
+        if (ready && av_frame_make_writable(scaled) >= 0) {
+            frame_buffer_to_avframe(&incoming, source);
+            if (sws_scale_frame(output->sws_ctx, scaled, source) >= 0) {
+                scaled->pts = incoming.pts;
+                encode_frame(output, &rendition->config, scaled);
+                frames_encoded++;
+            }
+        }
+
+        frame_buffer_free(&incoming);
+    }
+
+    flush_encoder(output);
+    av_frame_free(&source);
+
+    if (rendition->config.verbose) {
+        printf("Rendition %dp finished, encoded %d frames\n", rendition->height, frames_encoded);
+    }
+
+#ifdef _WIN32
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+static bool filter_and_push_buffer(FrameBuffer* buffer, AVFrame* view, AVFrame* filtered) {
+    frame_buffer_to_avframe(buffer, view);
+    if (av_buffersrc_add_frame_flags(g_buffersrc_ctx, view, AV_BUFFERSRC_FLAG_KEEP_REF) < 0) {
+        return true;
+    }
+
+    while (av_buffersink_get_frame(g_buffersink_ctx, filtered) >= 0) {
+        bool pushed = render_branches_push(filtered);
+        av_frame_unref(filtered);
+        if (!pushed) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static THREAD_FUNC raw_read_thread(void* arg) {
+    RawSource* source = (RawSource*)arg;
+    AVFrame* view = g_filter_graph ? av_frame_alloc() : NULL;
+    AVFrame* filtered = g_filter_graph ? av_frame_alloc() : NULL;
+    FrameBuffer buffer = { 0 };
+
+    while (!is_interrupted() && raw_source_next(source, &buffer)) {
+        bool pushed;
+        if (g_filter_graph) {
+            pushed = view && filtered && filter_and_push_buffer(&buffer, view, filtered);
+        }
+        else {
+            pushed = render_branches_push_buffer(&buffer);
+        }
+        if (!pushed) {
+            break;
+        }
+        if (source->frames_read % 100 == 0 && source->verbose) {
+            printf("Read %lld frames\n", (long long)source->frames_read);
+        }
+    }
+    frame_buffer_free(&buffer);
+
+    if (source->verbose) {
+        printf("Raw input delivered %lld frames\n", (long long)source->frames_read);
+    }
+
+    av_frame_free(&view);
+    av_frame_free(&filtered);
+
+#ifdef _WIN32
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+#define IMAGE_SEQUENCE_MAX_WORKERS 32
+#define IMAGE_SEQUENCE_START_RANGE 5
+
+typedef struct {
+    FrameBuffer frame;
+    bool ready;
+    bool failed;
+} ImageSlot;
+
+typedef struct {
+    ImageSequence* sequence;
+    pthread_t thread;
+    bool started;
+    AVCodecContext* codec_ctx;
+    struct SwsContext* sws_ctx;
+    AVFrame* frame;
+    AVPacket* packet;
+} ImageWorker;
+
+struct ImageSequence {
+    char pattern[512];
+    int start_number;
+    int64_t frame_count;
+    int width;
+    int height;
+    AVRational frame_rate;
+    ImageWorker* workers;
+    int worker_count;
+    ImageSlot* slots;
+    int window;
+    int64_t next_index;
+    int64_t delivered;
+    bool stopping;
+    int64_t decode_us;
+    int64_t wait_us;
+    bool verbose;
+#ifdef _WIN32
+    HANDLE mutex;
+    HANDLE slot_ready;
+    HANDLE slot_free;
+#else
+    pthread_mutex_t mutex;
+    pthread_cond_t slot_ready;
+    pthread_cond_t slot_free;
+#endif
+};
+
+static bool image_sequence_path(const ImageSequence* sequence, int64_t index, char* path, size_t size) {
+    snprintf(path, size, sequence->pattern, (int)(sequence->start_number + index));
+    struct stat st;
+    return stat(path, &st) == 0;
+}
+
+static void image_sequence_lock(ImageSequence* sequence) {
+#ifdef _WIN32
+    WaitForSingleObject(sequence->mutex, INFINITE);
+#else
+    pthread_mutex_lock(&sequence->mutex);
+#endif
+}
+
+static void image_sequence_unlock(ImageSequence* sequence) {
+#ifdef _WIN32
+    ReleaseMutex(sequence->mutex);
+#else
+    pthread_mutex_unlock(&sequence->mutex);
+#endif
+}
+
+#ifdef _WIN32
+static void image_sequence_wait(ImageSequence* sequence, HANDLE event) {
+    ReleaseMutex(sequence->mutex);
+    WaitForSingleObject(event, 10);
+    WaitForSingleObject(sequence->mutex, INFINITE);
+}
+
+static void image_sequence_signal(HANDLE event) {
+    SetEvent(event);
+}
+#else
+static void image_sequence_wait(ImageSequence* sequence, pthread_cond_t* cond) {
+    pthread_cond_wait(cond, &sequence->mutex);
+}
+
+static void image_sequence_signal(pthread_cond_t* cond) {
+    pthread_cond_broadcast(cond);
+}
+#endif
+
+static bool image_sequence_decode(ImageWorker* worker, int64_t index, FrameBuffer* buffer) {
+    ImageSequence* sequence = worker->sequence;
+    char path[1024];
+    image_sequence_path(sequence, index, path, sizeof(path));
+
+    AVFormatContext* fmt_ctx = NULL;
+    if (avformat_open_input(&fmt_ctx, path, NULL, NULL) < 0) {
+        fprintf(stderr, "Error opening image '%s'\n", path);
+        return false;
+    }
+
+    bool decoded = fmt_ctx->nb_streams > 0 && av_read_frame(fmt_ctx, worker->packet) >= 0;
+    AVCodecParameters* codecpar = decoded ? fmt_ctx->streams[0]->codecpar : NULL;
+
+    if (decoded && (!worker->codec_ctx || worker->codec_ctx->codec_id != codecpar->codec_id)) {
+        avcodec_free_context(&worker->codec_ctx);
+        const AVCodec* codec = avcodec_find_decoder(codecpar->codec_id);
+        worker->codec_ctx = codec ? avcodec_alloc_context3(codec) : NULL;
+        decoded = worker->codec_ctx && avcodec_parameters_to_context(worker->codec_ctx, codecpar) >= 0;
+        if (decoded) {
+            worker->codec_ctx->thread_count = 1;
+            decoded = avcodec_open2(worker->codec_ctx, codec, NULL) >= 0;
+        }
+    }
+
+    decoded = decoded && avcodec_send_packet(worker->codec_ctx, worker->packet) >= 0 &&
+        avcodec_receive_frame(worker->codec_ctx, worker->frame) >= 0;
+    av_packet_unref(worker->packet);
+    avformat_close_input(&fmt_ctx);
+
+    if (!decoded) {
+        fprintf(stderr, "Error decoding image '%s'\n", path);
+        return false;
+    }
+
+    AVFrame* frame = worker->frame;
+    worker->sws_ctx = sws_getCachedContext(worker->sws_ctx, frame->width, frame->height, frame->format,
+        sequence->width, sequence->height, AV_PIX_FMT_YUV420P, SWS_BILINEAR, NULL, NULL, NULL);
+
+    if (buffer->allocated && (buffer->release || buffer->width != sequence->width ||
+        buffer->height != sequence->height || buffer->format != AV_PIX_FMT_YUV420P)) {
+        frame_buffer_free(buffer);
+    }
+    if (!worker->sws_ctx ||
+        (!buffer->allocated && !frame_buffer_alloc(buffer, sequence->width, sequence->height, AV_PIX_FMT_YUV420P))) {
+        av_frame_unref(frame);
+        return false;
+    }
+
+    sws_scale(worker->sws_ctx, (const uint8_t* const*)frame->data, frame->linesize, 0, frame->height,
+        buffer->data, buffer->linesize);
+    buffer->pts = index;
+    av_frame_unref(frame);
+    return true;
+}
+
+static THREAD_FUNC image_sequence_worker(void* arg) {
+    ImageWorker* worker = (ImageWorker*)arg;
+    ImageSequence* sequence = worker->sequence;
+
+    while (true) {
+        image_sequence_lock(sequence);
+        while (!sequence->stopping && sequence->next_index < sequence->frame_count &&
+            sequence->next_index >= sequence->delivered + sequence->window) {
+#ifdef _WIN32
+            image_sequence_wait(sequence, sequence->slot_free);
+#else
+            image_sequence_wait(sequence, &sequence->slot_free);
+#endif
+        }
+        if (sequence->stopping || sequence->next_index >= sequence->frame_count) {
+            image_sequence_unlock(sequence);
+            break;
+        }
+        int64_t index = sequence->next_index++;
+        image_sequence_unlock(sequence);
+
+        ImageSlot* slot = &sequence->slots[index % sequence->window];
+        int64_t start = av_gettime_relative();
+        bool decoded = image_sequence_decode(worker, index, &slot->frame);
+        int64_t elapsed = av_gettime_relative() - start;
+
+        image_sequence_lock(sequence);
+        slot->failed = !decoded;
+        slot->ready = true;
+        sequence->decode_us += elapsed;
+#ifdef _WIN32
+        image_sequence_signal(sequence->slot_ready);
+#else
+        image_sequence_signal(&sequence->slot_ready);
+#endif
+        image_sequence_unlock(sequence);
+    }
+
+#ifdef _WIN32
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+static void image_sequence_stop(ImageSequence* sequence) {
+    image_sequence_lock(sequence);
+    sequence->stopping = true;
+#ifdef _WIN32
+    image_sequence_signal(sequence->slot_free);
+#else
+    image_sequence_signal(&sequence->slot_free);
+#endif
+    image_sequence_unlock(sequence);
+
+    for (int i = 0; i < sequence->worker_count; i++) {
+        if (!sequence->workers[i].started) continue;
+#ifdef _WIN32
+        WaitForSingleObject(sequence->workers[i].thread, INFINITE);
+        CloseHandle(sequence->workers[i].thread);
+#else
+        pthread_join(sequence->workers[i].thread, NULL);
+#endif
+        sequence->workers[i].started = false;
+    }
+}
+
+static THREAD_FUNC image_sequence_thread(void* arg) {
+    ImageSequence* sequence = (ImageSequence*)arg;
+    AVFrame* view = g_filter_graph ? av_frame_alloc() : NULL;
+    AVFrame* filtered = g_filter_graph ? av_frame_alloc() : NULL;
+    int started = 0;
+
+    for (int i = 0; i < sequence->worker_count; i++) {
+        ImageWorker* worker = &sequence->workers[i];
+#ifdef _WIN32
+        worker->thread = CreateThread(NULL, 0, image_sequence_worker, worker, 0, NULL);
+        worker->started = worker->thread != NULL;
+#else
+        worker->started = pthread_create(&worker->thread, NULL, image_sequence_worker, worker) == 0;
+#endif
+        started += worker->started;
+    }
+    if (started == 0) {
+        fprintf(stderr, "Failed to create image decode threads\n");
+    }
+
+    while (started > 0 && sequence->delivered < sequence->frame_count && !is_interrupted()) {
+        ImageSlot* slot = &sequence->slots[sequence->delivered % sequence->window];
+
+        int64_t start = av_gettime_relative();
+        image_sequence_lock(sequence);
+        while (!slot->ready && !is_interrupted()) {
+#ifdef _WIN32
+            image_sequence_wait(sequence, sequence->slot_ready);
+#else
+            image_sequence_wait(sequence, &sequence->slot_ready);
+#endif
+        }
+        bool ready = slot->ready && !slot->failed;
+        image_sequence_unlock(sequence);
+        sequence->wait_us += av_gettime_relative() - start;
+
+        if (!ready) {
+            break;
+        }
+
+        bool pushed;
+        if (g_filter_graph) {
+            pushed = view && filtered && filter_and_push_buffer(&slot->frame, view, filtered);
+        }
+        else {
+            pushed = render_branches_push_buffer(&slot->frame);
+        }
+
+        image_sequence_lock(sequence);
+        slot->ready = false;
+        sequence->delivered++;
+#ifdef _WIN32
+        image_sequence_signal(sequence->slot_free);
+#else
+        image_sequence_signal(&sequence->slot_free);
+#endif
+        image_sequence_unlock(sequence);
+
+        if (!pushed) {
+            break;
+        }
+        if (sequence->delivered % 100 == 0 && sequence->verbose) {
+            printf("Read %lld frames\n", (long long)sequence->delivered);
+        }
+    }
+
+    image_sequence_stop(sequence);
+
+    if (sequence->verbose) {
+        printf("Image sequence: %lld of %lld frames on %d decode threads, %.2f s decoding, reader waited %.2f s\n",
+            (long long)sequence->delivered, (long long)sequence->frame_count, sequence->worker_count,
+            sequence->decode_us / 1000000.0, sequence->wait_us / 1000000.0);
+    }
+
+    av_frame_free(&view);
+    av_frame_free(&filtered);
+
+#ifdef _WIN32
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+static void image_sequence_close(ImageSequence* sequence) {
+    if (!sequence) return;
+
+    if (sequence->workers) {
+        image_sequence_stop(sequence);
+        for (int i = 0; i < sequence->worker_count; i++) {
+            ImageWorker* worker = &sequence->workers[i];
+            avcodec_free_context(&worker->codec_ctx);
+            if (worker->sws_ctx) sws_freeContext(worker->sws_ctx);
+            av_frame_free(&worker->frame);
+            av_packet_free(&worker->packet);
+        }
+        free(sequence->workers);
+    }
+
+    if (sequence->slots) {
+        for (int i = 0; i < sequence->window; i++) {
+            frame_buffer_free(&sequence->slots[i].frame);
+        }
+        free(sequence->slots);
+    }
+
+#ifdef _WIN32
+    if (sequence->mutex) CloseHandle(sequence->mutex);
+    if (sequence->slot_ready) CloseHandle(sequence->slot_ready);
+    if (sequence->slot_free) CloseHandle(sequence->slot_free);
+#else
+    pthread_mutex_destroy(&sequence->mutex);
+    pthread_cond_destroy(&sequence->slot_ready);
+    pthread_cond_destroy(&sequence->slot_free);
+#endif
+    free(sequence);
+}
+
+static bool image_sequence_probe(ImageSequence* sequence) {
+    char path[1024];
+    image_sequence_path(sequence, 0, path, sizeof(path));
+
+    AVFormatContext* fmt_ctx = NULL;
+    if (avformat_open_input(&fmt_ctx, path, NULL, NULL) < 0) {
+        fprintf(stderr, "Error opening image '%s'\n", path);
+        return false;
+    }
+
+    bool probed = avformat_find_stream_info(fmt_ctx, NULL) >= 0 && fmt_ctx->nb_streams > 0;
+    if (probed) {
+        sequence->width = fmt_ctx->streams[0]->codecpar->width & ~1;
+        sequence->height = fmt_ctx->streams[0]->codecpar->height & ~1;
+        probed = sequence->width > 0 && sequence->height > 0;
+    }
+    avformat_close_input(&fmt_ctx);
+
+    if (!probed) {
+        fprintf(stderr, "Could not read the frame size of '%s'\n", path);
+    }
+    return probed;
+}
+
+static ImageSequence* image_sequence_open(const char* pattern, const BlurConfig* config) {
+    ImageSequence* sequence = (ImageSequence*)calloc(1, sizeof(ImageSequence));
+    if (!sequence) return NULL;
+
+#ifdef _WIN32
+    sequence->mutex = CreateMutex(NULL, FALSE, NULL);
+    sequence->slot_ready = CreateEvent(NULL, FALSE, FALSE, NULL);
+    sequence->slot_free = CreateEvent(NULL, FALSE, FALSE, NULL);
+#else
+    pthread_mutex_init(&sequence->mutex, NULL);
+    pthread_cond_init(&sequence->slot_ready, NULL);
+    pthread_cond_init(&sequence->slot_free, NULL);
+#endif
+
+    snprintf(sequence->pattern, sizeof(sequence->pattern), "%s", pattern);
+    sequence->frame_rate = av_d2q(config->sequence_fps, 1001000);
+    sequence->verbose = config->verbose;
+
+    char path[1024];
+    while (sequence->start_number < IMAGE_SEQUENCE_START_RANGE &&
+        !image_sequence_path(sequence, 0, path, sizeof(path))) {
+        sequence->start_number++;
+    }
+    while (image_sequence_path(sequence, sequence->frame_count, path, sizeof(path))) {
+        sequence->frame_count++;
+    }
+
+    if (sequence->frame_count == 0) {
+        fprintf(stderr, "No images found matching '%s'\n", pattern);
+        image_sequence_close(sequence);
+        return NULL;
+    }
+
+    if (!image_sequence_probe(sequence)) {
+        image_sequence_close(sequence);
+        return NULL;
+    }
+
+    sequence->worker_count = config->threads > 0 ? config->threads : get_cpu_count();
+    if (sequence->worker_count > IMAGE_SEQUENCE_MAX_WORKERS) sequence->worker_count = IMAGE_SEQUENCE_MAX_WORKERS;
+    if (sequence->worker_count > sequence->frame_count) sequence->worker_count = (int)sequence->frame_count;
+    sequence->window = sequence->worker_count * 2;
+    sequence->workers = (ImageWorker*)calloc(sequence->worker_count, sizeof(ImageWorker));
+    sequence->slots = (ImageSlot*)calloc(sequence->window, sizeof(ImageSlot));
+    if (!sequence->workers || !sequence->slots) {
+        image_sequence_close(sequence);
+        return NULL;
+    }
+
+    for (int i = 0; i < sequence->worker_count; i++) {
+        ImageWorker* worker = &sequence->workers[i];
+        worker->sequence = sequence;
+        worker->frame = av_frame_alloc();
+        worker->packet = av_packet_alloc();
+        if (!worker->frame || !worker->packet) {
+            image_sequence_close(sequence);
+            return NULL;
+        }
+    }
+
+    if (config->verbose) {
+        printf("Image sequence: %lld frames from %d, %dx%d, decoding on %d threads\n",
+            (long long)sequence->frame_count, sequence->start_number, sequence->width, sequence->height,
+            sequence->worker_count);
+    }
+    return sequence;
+}
+
+#define PROXY_MAGIC "SWBPX001"
+#define PROXY_CHUNK_FRAMES 64
+
+typedef struct {
+    char magic[8];
+    uint64_t key;
+    int32_t width;
+    int32_t height;
+    int64_t frame_size;
+    int32_t frames_per_chunk;
+    int32_t complete;
+    int64_t frame_count;
+} ProxyIndexHeader;
+
+typedef struct {
+    uint8_t* base;
+    size_t size;
+    int refs;
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#endif
+} ProxyChunk;
+
+typedef struct {
+    char directory[1024];
+    ProxyIndexHeader header;
+    int64_t* pts;
+    int64_t pts_capacity;
+    bool reading;
+    bool failed;
+    FILE* chunk_file;
+    struct SwsContext* sws_ctx;
+    AVFrame* scaled;
+    ProxyChunk* chunks;
+    int chunk_count;
+    const BlurConfig* config;
+    pthread_mutex_t mutex;
+} ProxyCache;
+
+typedef struct {
+    ProxyCache* cache;
+    int chunk;
+} ProxyFrameRef;
+
+static void make_directory(const char* path) {
+#ifdef _WIN32
+    _mkdir(path);
+#else
+    mkdir(path, 0755);
+#endif
+}
+
+static bool proxy_cache_load_index(ProxyCache* cache, uint64_t key) {
+    char path[1100];
+    snprintf(path, sizeof(path), "%s/index.bin", cache->directory);
+
+    FILE* file = fopen(path, "rb");
+    if (!file) return false;
+
+    bool valid = fread(&cache->header, sizeof(ProxyIndexHeader), 1, file) == 1 &&
+        memcmp(cache->header.magic, PROXY_MAGIC, 8) == 0 && cache->header.key == key &&
+        cache->header.complete && cache->header.frame_count > 0 &&
+        cache->header.frames_per_chunk == PROXY_CHUNK_FRAMES;
+
+    if (valid) {
+        cache->pts = (int64_t*)malloc(cache->header.frame_count * sizeof(int64_t));
+        valid = cache->pts && fread(cache->pts, sizeof(int64_t), cache->header.frame_count, file) ==
+            (size_t)cache->header.frame_count;
+    }
+
+    fclose(file);
+    if (!valid) {
+        free(cache->pts);
+        cache->pts = NULL;
+    }
+    return valid;
+}
+
+static ProxyCache* proxy_cache_open(const BlurConfig* config, int width, int height) {
+    uint64_t file_hash;
+    if (!hash_input_file(config->input_file, &file_hash)) {
+        fprintf(stderr, "Warning: Could not hash input for proxy cache\n");
+        return NULL;
+    }
+
+    int32_t scale = config->proxy_scale;
+    uint64_t key = fnv1a_update(file_hash, &scale, sizeof(scale));
+
+    ProxyCache* cache = (ProxyCache*)calloc(1, sizeof(ProxyCache));
+    if (!cache) return NULL;
+
+    cache->config = config;
+    make_directory(config->proxy_cache);
+    snprintf(cache->directory, sizeof(cache->directory), "%s/%016llx", config->proxy_cache, (unsigned long long)key);
+    make_directory(cache->directory);
+
+#ifdef _WIN32
+    cache->mutex = CreateMutex(NULL, FALSE, NULL);
+#else
+    pthread_mutex_init(&cache->mutex, NULL);
+#endif
+
+    if (proxy_cache_load_index(cache, key)) {
+        cache->reading = true;
+        cache->chunk_count = (int)((cache->header.frame_count + PROXY_CHUNK_FRAMES - 1) / PROXY_CHUNK_FRAMES);
+        cache->chunks = (ProxyChunk*)calloc(cache->chunk_count, sizeof(ProxyChunk));
+        if (cache->chunks) {
+            if (config->verbose) {
+                printf("Proxy cache hit: %s (%lld frames at %dx%d)\n", cache->directory,
+                    (long long)cache->header.frame_count, cache->header.width, cache->header.height);
+            }
+            return cache;
+        }
+        cache->reading = false;
+    }
+
+    memset(&cache->header, 0, sizeof(ProxyIndexHeader));
+    memcpy(cache->header.magic, PROXY_MAGIC, 8);
+    cache->header.key = key;
+    cache->header.width = (width / scale) & ~1;
+    cache->header.height = (height / scale) & ~1;
+    cache->header.frame_size = (int64_t)cache->header.width * cache->header.height * 3 / 2;
+    cache->header.frames_per_chunk = PROXY_CHUNK_FRAMES;
+
+    cache->scaled = av_frame_alloc();
+    if (cache->scaled) {
+        cache->scaled->format = AV_PIX_FMT_YUV420P;
+        cache->scaled->width = cache->header.width;
+        cache->scaled->height = cache->header.height;
+    }
+    if (!cache->scaled || av_frame_get_buffer(cache->scaled, 32) < 0) {
+        fprintf(stderr, "Warning: Could not allocate proxy cache frame\n");
+        av_frame_free(&cache->scaled);
+#ifdef _WIN32
+        CloseHandle(cache->mutex);
+#else
+        pthread_mutex_destroy(&cache->mutex);
+#endif
+        free(cache);
+        return NULL;
+    }
+
+    if (config->verbose) {
+        printf("Proxy cache miss, storing %dx%d frames in %s\n",
+            cache->header.width, cache->header.height, cache->directory);
+    }
+    return cache;
+}
+
+static bool proxy_cache_write(ProxyCache* cache, const AVFrame* frame) {
+    int64_t index = cache->header.frame_count;
+    if (index % PROXY_CHUNK_FRAMES == 0) {
+        char path[1100];
+        if (cache->chunk_file) fclose(cache->chunk_file);
+        snprintf(path, sizeof(path), "%s/chunk_%05lld.raw", cache->directory,
+            (long long)(index / PROXY_CHUNK_FRAMES));
+        cache->chunk_file = fopen(path, "wb");
+        if (!cache->chunk_file) return false;
+    }
+
+    if (index >= cache->pts_capacity) {
+        int64_t capacity = cache->pts_capacity ? cache->pts_capacity * 2 : 1024;
+        int64_t* pts = (int64_t*)realloc(cache->pts, capacity * sizeof(int64_t));
+        if (!pts) return false;
+        cache->pts = pts;
+        cache->pts_capacity = capacity;
+    }
+
+    for (int plane = 0; plane < 3; plane++) {
+        int plane_width = plane ? cache->header.width / 2 : cache->header.width;
+        int plane_height = plane ? cache->header.height / 2 : cache->header.height;
+        for (int y = 0; y < plane_height; y++) {
+            if (fwrite(frame->data[plane] + y * frame->linesize[plane], 1, plane_width, cache->chunk_file) !=
+                (size_t)plane_width) {
+                return false;
+            }
+        }
+    }
+
+    cache->pts[index] = frame->pts;
+    cache->header.frame_count++;
+    return true;
+}
+
+static AVFrame* proxy_cache_store(ProxyCache* cache, AVFrame* frame) {
+    AVFrame* stored = frame;
+
+    if (frame->width != cache->header.width || frame->height != cache->header.height ||
+        frame->format != AV_PIX_FMT_YUV420P) {
+        cache->sws_ctx = sws_getCachedContext(cache->sws_ctx, frame->width, frame->height, frame->format,
+            cache->header.width, cache->header.height, AV_PIX_FMT_YUV420P, SWS_BILINEAR, NULL, NULL, NULL);
+        if (!cache->sws_ctx || av_frame_make_writable(cache->scaled) < 0) {
+            cache->failed = true;
+            return frame;
+        }
+
+        sws_scale(cache->sws_ctx, (const uint8_t* const*)frame->data, frame->linesize, 0, frame->height,
+            cache->scaled->data, cache->scaled->linesize);
+        cache->scaled->pts = frame->pts;
+        stored = cache->scaled;
+    }
+
+    if (!cache->failed && !proxy_cache_write(cache, stored)) {
+        fprintf(stderr, "Warning: Proxy cache write failed, it will not be reused\n");
+        cache->failed = true;
+    }
+    return stored;
+}
+
+static void proxy_chunk_unmap(ProxyChunk* chunk) {
+#ifdef _WIN32
+    if (chunk->base) UnmapViewOfFile(chunk->base);
+    if (chunk->mapping) CloseHandle(chunk->mapping);
+    if (chunk->file && chunk->file != INVALID_HANDLE_VALUE) CloseHandle(chunk->file);
+    chunk->mapping = NULL;
+    chunk->file = NULL;
+#else
+    if (chunk->base) munmap(chunk->base, chunk->size);
+#endif
+    chunk->base = NULL;
+}
+
+static bool proxy_chunk_map(ProxyCache* cache, int index) {
+    ProxyChunk* chunk = &cache->chunks[index];
+    int64_t frames = FFMIN((int64_t)PROXY_CHUNK_FRAMES, cache->header.frame_count - (int64_t)index * PROXY_CHUNK_FRAMES);
+    char path[1100];
+
+    chunk->size = (size_t)(frames * cache->header.frame_size);
+    snprintf(path, sizeof(path), "%s/chunk_%05d.raw", cache->directory, index);
+
+#ifdef _WIN32
+    chunk->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+        FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (chunk->file == INVALID_HANDLE_VALUE) return false;
+    chunk->mapping = CreateFileMappingA(chunk->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!chunk->mapping) return false;
+    chunk->base = (uint8_t*)MapViewOfFile(chunk->mapping, FILE_MAP_READ, 0, 0, chunk->size);
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < chunk->size) {
+        close(fd);
+        return false;
+    }
+
+    chunk->base = (uint8_t*)mmap(NULL, chunk->size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (chunk->base == MAP_FAILED) {
+        chunk->base = NULL;
+    }
+    else {
+        madvise(chunk->base, chunk->size, MADV_SEQUENTIAL);
+        madvise(chunk->base, chunk->size, MADV_WILLNEED);
+    }
+#endif
+    return chunk->base != NULL;
+}
+
+static void proxy_chunk_release(ProxyCache* cache, int index) {
+#ifdef _WIN32
+    WaitForSingleObject(cache->mutex, INFINITE);
+#else
+    pthread_mutex_lock(&cache->mutex);
+#endif
+
+    if (--cache->chunks[index].refs == 0) {
+        proxy_chunk_unmap(&cache->chunks[index]);
+    }
+
+#ifdef _WIN32
+    ReleaseMutex(cache->mutex);
+#else
+    pthread_mutex_unlock(&cache->mutex);
+#endif
+}
+
+static bool proxy_chunk_acquire(ProxyCache* cache, int index) {
+    bool mapped = true;
+
+#ifdef _WIN32
+    WaitForSingleObject(cache->mutex, INFINITE);
+#else
+    pthread_mutex_lock(&cache->mutex);
+#endif
+
+    if (!cache->chunks[index].base) {
+        mapped = proxy_chunk_map(cache, index);
+    }
+    if (mapped) {
+        cache->chunks[index].refs++;
+    }
+    else {
+        proxy_chunk_unmap(&cache->chunks[index]);
+    }
+
+#ifdef _WIN32
+    ReleaseMutex(cache->mutex);
+#else
+    pthread_mutex_unlock(&cache->mutex);
+#endif
+    return mapped;
+}
+
+static void proxy_release_frame(void* opaque) {
+    ProxyFrameRef* ref = (ProxyFrameRef*)opaque;
+    proxy_chunk_release(ref->cache, ref->chunk);
+    free(ref);
+}
+
+static bool proxy_wrap_frame(ProxyCache* cache, int64_t index, FrameBuffer* buffer) {
+    int chunk = (int)(index / PROXY_CHUNK_FRAMES);
+    ProxyFrameRef* ref = (ProxyFrameRef*)malloc(sizeof(ProxyFrameRef));
+    buffer->data = (uint8_t**)av_mallocz(4 * sizeof(uint8_t*));
+    buffer->linesize = (int*)av_mallocz(4 * sizeof(int));
+
+    if (!ref || !buffer->data || !buffer->linesize || !proxy_chunk_acquire(cache, chunk)) {
+        free(ref);
+        av_freep(&buffer->data);
+        av_freep(&buffer->linesize);
+        return false;
+    }
+
+    int width = cache->header.width;
+    int height = cache->header.height;
+    uint8_t* frame = cache->chunks[chunk].base + (index % PROXY_CHUNK_FRAMES) * cache->header.frame_size;
+
+    buffer->data[0] = frame;
+    buffer->data[1] = frame + (size_t)width * height;
+    buffer->data[2] = buffer->data[1] + (size_t)(width / 2) * (height / 2);
+    buffer->linesize[0] = width;
+    buffer->linesize[1] = width / 2;
+    buffer->linesize[2] = width / 2;
+
+    ref->cache = cache;
+    ref->chunk = chunk;
+    buffer->width = width;
+    buffer->height = height;
+    buffer->format = AV_PIX_FMT_YUV420P;
+    buffer->pts = cache->pts[index];
+    buffer->allocated = true;
+    buffer->release = proxy_release_frame;
+    buffer->opaque = ref;
+    return true;
+}
+
+static THREAD_FUNC proxy_read_thread(void* arg) {
+    ProxyCache* cache = (ProxyCache*)arg;
+    AVFrame* view = g_filter_graph ? av_frame_alloc() : NULL;
+    AVFrame* filtered = g_filter_graph ? av_frame_alloc() : NULL;
+    FrameBuffer buffer = { 0 };
+    int64_t delivered = 0;
+
+    while (delivered < cache->header.frame_count && !is_interrupted()) {
+        if (!proxy_wrap_frame(cache, delivered, &buffer)) {
+            fprintf(stderr, "Failed to map proxy frame %lld\n", (long long)delivered);
+            break;
+        }
+
+        bool pushed;
+        if (g_filter_graph) {
+            pushed = view && filtered && filter_and_push_buffer(&buffer, view, filtered);
+        }
+        else {
+            pushed = render_branches_push_buffer(&buffer);
+        }
+        frame_buffer_free(&buffer);
+        if (!pushed) {
+            break;
+        }
+        delivered++;
+    }
+
+    if (cache->config->verbose) {
+        printf("Proxy cache delivered %lld frames\n", (long long)delivered);
+    }
+
+    av_frame_free(&view);
+    av_frame_free(&filtered);
+
+#ifdef _WIN32
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+static void proxy_cache_close(ProxyCache* cache, bool finished) {
+    if (!cache) return;
+
+    if (!cache->reading) {
+        if (cache->chunk_file) fclose(cache->chunk_file);
+
+        char path[1100];
+        snprintf(path, sizeof(path), "%s/index.bin", cache->directory);
+        cache->header.complete = finished && !cache->failed && cache->header.frame_count > 0 ? 1 : 0;
+
+        FILE* file = fopen(path, "wb");
+        if (file) {
+            fwrite(&cache->header, sizeof(ProxyIndexHeader), 1, file);
+            if (cache->header.frame_count > 0) {
+                fwrite(cache->pts, sizeof(int64_t), cache->header.frame_count, file);
+            }
+            fclose(file);
+        }
+
+        if (cache->config->verbose) {
+            printf("Proxy cache stored %lld frames%s\n", (long long)cache->header.frame_count,
+                cache->header.complete ? "" : " (incomplete, will be rebuilt)");
+        }
+    }
+
+    for (int i = 0; i < cache->chunk_count; i++) {
+        proxy_chunk_unmap(&cache->chunks[i]);
+    }
+
+#ifdef _WIN32
+    CloseHandle(cache->mutex);
+#else
+    pthread_mutex_destroy(&cache->mutex);
+#endif
+
+    sws_freeContext(cache->sws_ctx);
+    av_frame_free(&cache->scaled);
+    free(cache->chunks);
+    free(cache->pts);
+    free(cache);
+}
+
+#ifdef HAVE_VAPOURSYNTH
+#define VS_MAX_REQUESTS 64
+
+typedef struct {
+    const VSFrameRef* frame;
+    bool ready;
+} VSPendingFrame;
+
+typedef struct {
+    const BlurConfig* config;
+    VapourSynthContext* vs;
+    VSPendingFrame pending[VS_MAX_REQUESTS];
+    int window;
+    char error[256];
+    pthread_mutex_t mutex;
+    pthread_cond_t frame_ready;
+} VSFrameReader;
+
+typedef struct {
+    const VSAPI* vsapi;
+    const VSFrameRef* frame;
+} VSFrameRelease;
+
+static void append_python_string(char* script, size_t size, const char* value) {
+    size_t len = strlen(script);
+    if (len + 1 < size) script[len++] = '"';
+    for (const char* c = value; *c && len + 3 < size; c++) {
+        if (*c == '\\' || *c == '"') script[len++] = '\\';
+        script[len++] = *c;
+    }
+    if (len + 1 < size) script[len++] = '"';
+    script[len] = '\0';
+}
+
+static void append_script(char* script, size_t size, const char* format, ...) {
+    size_t len = strlen(script);
+    if (len >= size) return;
+
+    va_list args;
+    va_start(args, format);
+    vsnprintf(script + len, size - len, format, args);
+    va_end(args);
+}
+
+static void build_vapoursynth_script(const BlurConfig* config, int factor, char* script, size_t size) {
+    script[0] = '\0';
+    append_script(script, size, "import vapoursynth as vs\ncore = vs.core\npath = ");
+    append_python_string(script, size, config->input_file);
+    append_script(script, size, "\nif hasattr(core, 'lsmas'):\n"
+        "    clip = core.lsmas.LWLibavSource(path)\n"
+        "else:\n"
+        "    clip = core.ffms2.Source(path)\n"
+        "clip = core.resize.Bicubic(clip, format=vs.YUV420P8)\n");
+
+    if (strcmp(config->interpolation_method, "svp") == 0) {
+        char super_string[256];
+        char smooth_string[256];
+
+        if (config->manual_svp) {
+            snprintf(super_string, sizeof(super_string), "%s", config->svp_super_string);
+            snprintf(smooth_string, sizeof(smooth_string), "%s", config->svp_smooth_string);
+        }
+        else {
+            snprintf(super_string, sizeof(super_string), "{pel:2,gpu:%d}", config->gpu_interpolation ? 1 : 0);
+            snprintf(smooth_string, sizeof(smooth_string), "{rate:{num:%d,den:1},algo:%d,mask:{area:%d}}",
+                factor, config->svp_algorithm, (int)(config->interpolation_mask_area * 100.0f + 0.5f));
+        }
+
+        append_script(script, size, "super = core.svp1.Super(clip, ");
+        append_python_string(script, size, super_string);
+        append_script(script, size, ")\nvectors = core.svp1.Analyse(super['clip'], super['data'], clip, ");
+        append_python_string(script, size, config->svp_vectors_string);
+        append_script(script, size, ")\nclip = core.svp2.SmoothFps(clip, super['clip'], super['data'], "
+            "vectors['clip'], vectors['data'], ");
+        append_python_string(script, size, smooth_string);
+        append_script(script, size, ")\n");
+    }
+    else {
+        append_script(script, size, "clip = core.resize.Bicubic(clip, format=vs.RGBS, matrix_in_s='709')\n"
+            "clip = core.rife.RIFE(clip, factor_num=%d, factor_den=1)\n"
+            "clip = core.resize.Bicubic(clip, format=vs.YUV420P8, matrix_s='709')\n", factor);
+    }
+
+    append_script(script, size, "clip.set_output()\n");
+}
+
+static bool vapoursynth_open(VapourSynthContext* vs_ctx, const BlurConfig* config, int factor,
+    int width, int height) {
+    if (!init_vapoursynth(vs_ctx)) {
+        fprintf(stderr, "Failed to load VapourSynth\n");
+        return false;
+    }
+
+    char script[4096];
+    build_vapoursynth_script(config, factor, script, sizeof(script));
+    if (config->debug) {
+        printf("VapourSynth script:\n%s", script);
+    }
+
+    if (vsscript_evaluateScript(&vs_ctx->script, script, "swuabblur.vpy", efSetWorkingDir) != 0) {
+        fprintf(stderr, "VapourSynth script error: %s\n",
+            vs_ctx->script ? vsscript_getError(vs_ctx->script) : "unknown");
+        return false;
+    }
+
+    vs_ctx->core = vsscript_getCore(vs_ctx->script);
+    vs_ctx->node = vsscript_getOutput(vs_ctx->script, 0);
+    if (!vs_ctx->node) {
+        fprintf(stderr, "VapourSynth script has no output node\n");
+        return false;
+    }
+
+    const VSVideoInfo* info = vs_ctx->vsapi->getVideoInfo(vs_ctx->node);
+    if (!info->format || info->format->id != pfYUV420P8 || info->width != width || info->height != height ||
+        info->numFrames <= 0 || info->fpsNum <= 0 || info->fpsDen <= 0) {
+        fprintf(stderr, "VapourSynth output must be constant %dx%d YUV420P8 with a known length and rate\n",
+            width, height);
+        return false;
+    }
+
+    return true;
+}
+
+static bool vapoursynth_active(void) {
+    return g_vs_ctx && g_vs_ctx->node;
+}
+
+static void VS_CC vapoursynth_frame_done(void* user_data, const VSFrameRef* frame, int n, VSNodeRef* node,
+    const char* error) {
+    VSFrameReader* reader = (VSFrameReader*)user_data;
+    (void)node;
+
+#ifdef _WIN32
+    WaitForSingleObject(reader->mutex, INFINITE);
+#else
+    pthread_mutex_lock(&reader->mutex);
+#endif
+
+    VSPendingFrame* pending = &reader->pending[n % reader->window];
+    pending->frame = frame;
+    pending->ready = true;
+    if (!frame && error && !reader->error[0]) {
+        snprintf(reader->error, sizeof(reader->error), "frame %d: %s", n, error);
+    }
+
+#ifdef _WIN32
+    SetEvent(reader->frame_ready);
+    ReleaseMutex(reader->mutex);
+#else
+    pthread_cond_broadcast(&reader->frame_ready);
+    pthread_mutex_unlock(&reader->mutex);
+#endif
+}
+
+static const VSFrameRef* vapoursynth_wait_frame(VSFrameReader* reader, int n, bool allow_interrupt) {
+    VSPendingFrame* pending = &reader->pending[n % reader->window];
+
+#ifdef _WIN32
+    WaitForSingleObject(reader->mutex, INFINITE);
+    while (!pending->ready && !(allow_interrupt && is_interrupted())) {
+        ReleaseMutex(reader->mutex);
+        WaitForSingleObject(reader->frame_ready, 1000);
+        WaitForSingleObject(reader->mutex, INFINITE);
+    }
+#else
+    pthread_mutex_lock(&reader->mutex);
+    while (!pending->ready && !(allow_interrupt && is_interrupted())) {
+        struct timespec timeout;
+        clock_gettime(CLOCK_REALTIME, &timeout);
+        timeout.tv_sec += 1;
+        pthread_cond_timedwait(&reader->frame_ready, &reader->mutex, &timeout);
+    }
+#endif
+
+    const VSFrameRef* frame = pending->ready ? pending->frame : NULL;
+    bool ready = pending->ready;
+    pending->frame = NULL;
+    pending->ready = false;
+
+#ifdef _WIN32
+    ReleaseMutex(reader->mutex);
+#else
+    pthread_mutex_unlock(&reader->mutex);
+#endif
+
+    if (!ready) {
+        return NULL;
+    }
+    return frame;
+}
+
+static void vapoursynth_release_frame(void* opaque) {
+    VSFrameRelease* release = (VSFrameRelease*)opaque;
+    release->vsapi->freeFrame(release->frame);
+    free(release);
+}
+
+static bool vapoursynth_wrap_frame(const VSAPI* vsapi, const VSFrameRef* frame, FrameBuffer* buffer) {
+    VSFrameRelease* release = (VSFrameRelease*)malloc(sizeof(VSFrameRelease));
+    buffer->data = (uint8_t**)av_mallocz(4 * sizeof(uint8_t*));
+    buffer->linesize = (int*)av_mallocz(4 * sizeof(int));
+
+    if (!release || !buffer->data || !buffer->linesize) {
+        free(release);
+        av_freep(&buffer->data);
+        av_freep(&buffer->linesize);
+        return false;
+    }
+
+    for (int plane = 0; plane < 3; plane++) {
+        buffer->data[plane] = (uint8_t*)vsapi->getReadPtr(frame, plane);
+        buffer->linesize[plane] = vsapi->getStride(frame, plane);
+    }
+
+    release->vsapi = vsapi;
+    release->frame = frame;
+    buffer->width = vsapi->getFrameWidth(frame, 0);
+    buffer->height = vsapi->getFrameHeight(frame, 0);
+    buffer->format = AV_PIX_FMT_YUV420P;
+    buffer->allocated = true;
+    buffer->release = vapoursynth_release_frame;
+    buffer->opaque = release;
+    return true;
+}
+
+static bool vapoursynth_push_filtered(const VSAPI* vsapi, const VSFrameRef* frame, int64_t pts,
+    AVFrame* view, AVFrame* filtered) {
+    FrameBuffer buffer = { 0 };
+    if (!vapoursynth_wrap_frame(vsapi, frame, &buffer)) {
+        vsapi->freeFrame(frame);
+        return false;
+    }
+    buffer.pts = pts;
+
+    bool pushed = filter_and_push_buffer(&buffer, view, filtered);
+    frame_buffer_free(&buffer);
+    return pushed;
+}
+
+static THREAD_FUNC vapoursynth_read_thread(void* arg) {
+    VSFrameReader* reader = (VSFrameReader*)arg;
+    const VSAPI* vsapi = reader->vs->vsapi;
+    VSNodeRef* node = reader->vs->node;
+    const VSVideoInfo* info = vsapi->getVideoInfo(node);
+    const VSCoreInfo* core_info = vsapi->getCoreInfo(reader->vs->core);
+    AVRational frame_duration = { (int)info->fpsDen, (int)info->fpsNum };
+    AVFrame* view = g_filter_graph ? av_frame_alloc() : NULL;
+    AVFrame* filtered = g_filter_graph ? av_frame_alloc() : NULL;
+    FrameBuffer buffer = { 0 };
+    int requested = 0;
+    int delivered = 0;
+
+    reader->window = CLAMP(core_info->numThreads, 1, VS_MAX_REQUESTS);
+    if (reader->config->verbose) {
+        printf("VapourSynth: %d frames at %lld/%lld fps, %d requests in flight\n",
+            info->numFrames, (long long)info->fpsNum, (long long)info->fpsDen, reader->window);
+    }
+
+    for (; requested < info->numFrames && requested < reader->window; requested++) {
+        vsapi->getFrameAsync(requested, node, vapoursynth_frame_done, reader);
+    }
+
+    while (delivered < info->numFrames) {
+        const VSFrameRef* frame = vapoursynth_wait_frame(reader, delivered, true);
+        if (!frame) {
+            break;
+        }
+
+        delivered++;
+        if (requested < info->numFrames) {
+            vsapi->getFrameAsync(requested++, node, vapoursynth_frame_done, reader);
+        }
+
+        int64_t pts = av_rescale_q(delivered - 1, frame_duration, g_input_ctx->video_stream->time_base);
+        if (g_filter_graph) {
+            if (!view || !filtered) {
+                vsapi->freeFrame(frame);
+                break;
+            }
+            if (!vapoursynth_push_filtered(vsapi, frame, pts, view, filtered)) {
+                break;
+            }
+            continue;
+        }
+
+        if (!vapoursynth_wrap_frame(vsapi, frame, &buffer)) {
+            vsapi->freeFrame(frame);
+            break;
+        }
+        buffer.pts = pts;
+
+        bool pushed = render_branches_push_buffer(&buffer);
+        frame_buffer_free(&buffer);
+        if (!pushed) {
+            break;
+        }
+    }
+
+    for (int n = delivered; n < requested; n++) {
+        const VSFrameRef* frame = vapoursynth_wait_frame(reader, n, false);
+        if (frame) {
+            vsapi->freeFrame(frame);
+        }
+    }
+
+    if (reader->error[0]) {
+        fprintf(stderr, "VapourSynth error at %s\n", reader->error);
+    }
+    else if (reader->config->verbose) {
+        printf("VapourSynth delivered %d frames\n", delivered);
+    }
+
+    av_frame_free(&view);
+    av_frame_free(&filtered);
+
+#ifdef _WIN32
+    return 0;
+#else
+    return NULL;
+#endif
+}
+#else
+static bool vapoursynth_active(void) {
+    return false;
+}
+#endif
+
+static void rendition_filename(const char* output_file, int height, char* filename, size_t size) {
+    const char* extension = strrchr(output_file, '.');
+    const char* separator = strrchr(output_file, '/');
+    const char* backslash = strrchr(output_file, '\\');
+    if (backslash > separator) separator = backslash;
+
+    if (!extension || (separator && extension < separator)) {
+        snprintf(filename, size, "%s_%dp", output_file, height);
+    }
+    else {
+        snprintf(filename, size, "%.*s_%dp%s", (int)(extension - output_file), output_file, height, extension);
+    }
+}
+
+static bool render_branch_open_renditions(RenderBranch* branch, int width, int height, double output_fps) {
+    const BlurConfig* config = branch->config;
+    int heights[MAX_RENDITIONS];
+    int count = 0;
+
+    const char* cursor = config->renditions;
+    while (*cursor && count < MAX_RENDITIONS) {
+        char* end;
+        heights[count++] = (int)strtol(cursor, &end, 10);
+        cursor = *end == ',' ? end + 1 : end;
+    }
+
+    if (count == 0) return true;
+
+    branch->renditions = (Rendition*)calloc(count, sizeof(Rendition));
+    branch->rendition_queues = (FrameQueue**)calloc(count, sizeof(FrameQueue*));
+    if (!branch->renditions || !branch->rendition_queues) {
+        fprintf(stderr, "Failed to allocate renditions\n");
+        return false;
+    }
+
+    int threads = config->threads > 0 ? config->threads : get_cpu_count();
+
+    for (int i = 0; i < count; i++) {
+        Rendition* rendition = &branch->renditions[i];
+        rendition->height = heights[i] & ~1;
+        rendition->width = (int)((double)width * rendition->height / height + 0.5) & ~1;
+        rendition->thread_count = threads / count > 1 ? threads / count : 1;
+
+        rendition->config = *config;
+        rendition->config.custom_weights = NULL;
+        rendition->config.custom_weights_count = 0;
+        rendition->config.jobs = NULL;
+        rendition->config.job_count = 0;
+        if (config->bitrate > 0) {
+            double area = (double)rendition->width * rendition->height / ((double)width * height);
+            rendition->config.bitrate = (int)(config->bitrate * area) > 1 ? (int)(config->bitrate * area) : 1;
+        }
+        rendition_filename(config->output_file, rendition->height, rendition->filename, sizeof(rendition->filename));
+
+        rendition->queue = (FrameQueue*)calloc(1, sizeof(FrameQueue));
+        if (!rendition->queue) {
+            fprintf(stderr, "Failed to allocate rendition queue\n");
+            return false;
+        }
+        frame_queue_init(rendition->queue, RENDITION_QUEUE_FRAMES);
+        branch->rendition_queues[i] = rendition->queue;
+        branch->rendition_count = i + 1;
+
+        rendition->output = (VideoContext*)calloc(1, sizeof(VideoContext));
+        if (!rendition->output) {
+            fprintf(stderr, "Failed to allocate output context\n");
+            return false;
+        }
+
+        printf("Rendition %dx%d: %s\n", rendition->width, rendition->height, rendition->filename);
+        if (!create_output_video(rendition->output, rendition->filename, &rendition->config,
+            rendition->width, rendition->height, output_fps)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool render_branch_open(RenderBranch* branch, const BlurConfig* config, int index,
+    int width, int height, double input_fps) {
+    double output_fps = parse_fps_string(config->blur_output_fps, input_fps);
+    if (config->timescale != 1.0) {
+        output_fps *= config->timescale;
+    }
+
+    branch->config = config;
+    branch->index = index;
+
+    branch->queue = (FrameQueue*)calloc(1, sizeof(FrameQueue));
+    if (!branch->queue) {
+        fprintf(stderr, "Failed to allocate frame queue\n");
+        return false;
+    }
+
+    frame_queue_init(branch->queue, 200);
+
+    if (uses_decoder_motion(config)) {
+        branch->queue->motion_block_size = config->interpolation_block_size;
+    }
+
+    branch->output = (VideoContext*)calloc(1, sizeof(VideoContext));
+    if (!branch->output) {
+        fprintf(stderr, "Failed to allocate output context\n");
+        return false;
+    }
+
+    if (config->gpu_encoding && g_input_ctx->hw_device_ctx) {
+        branch->output->hw_device_ctx = g_input_ctx->hw_device_ctx;
+    }
+
+    if (index > 0) {
+        printf("Render job %d: %s @ %.2f fps\n", index, config->output_file, output_fps);
+    }
+
+    if (!create_output_video(branch->output, config->output_file, config, width, height, output_fps)) {
+        return false;
+    }
+
+    return render_branch_open_renditions(branch, width, height, output_fps);
+}
+
+static bool render_branch_start(RenderBranch* branch) {
+    bool vector_mode = strcmp(branch->config->blur_mode, "vector") == 0;
+
+    for (int i = 0; i < branch->rendition_count; i++) {
+        Rendition* rendition = &branch->renditions[i];
+#ifdef _WIN32
+        rendition->thread = CreateThread(NULL, 0, rendition_thread, rendition, 0, NULL);
+        rendition->started = rendition->thread != NULL;
+#else
+        rendition->started = pthread_create(&rendition->thread, NULL, rendition_thread, rendition) == 0;
+#endif
+        if (!rendition->started) {
+            return false;
+        }
+    }
+
+#ifdef _WIN32
+    branch->thread = CreateThread(NULL, 0, vector_mode ? vector_blur_thread : processing_thread,
+        branch, 0, NULL);
+    branch->started = branch->thread != NULL;
+#else
+    branch->started = pthread_create(&branch->thread, NULL,
+        vector_mode ? vector_blur_thread : processing_thread, branch) == 0;
+#endif
+
+    return branch->started;
+}
+
+static void render_branches_finish(void) {
+    for (int i = 0; i < g_branch_count; i++) {
+        frame_queue_signal_finished(g_branches[i].queue);
+    }
+
+    for (int i = 0; i < g_branch_count; i++) {
+        if (!g_branches[i].started) continue;
+#ifdef _WIN32
+        WaitForSingleObject(g_branches[i].thread, INFINITE);
+        CloseHandle(g_branches[i].thread);
+#else
+        pthread_join(g_branches[i].thread, NULL);
+#endif
+        g_branches[i].started = false;
+    }
+
+    for (int i = 0; i < g_branch_count; i++) {
+        RenderBranch* branch = &g_branches[i];
+        for (int j = 0; j < branch->rendition_count; j++) {
+            frame_queue_signal_finished(branch->renditions[j].queue);
+        }
+
+        for (int j = 0; j < branch->rendition_count; j++) {
+            Rendition* rendition = &branch->renditions[j];
+            if (!rendition->started) continue;
+#ifdef _WIN32
+            WaitForSingleObject(rendition->thread, INFINITE);
+            CloseHandle(rendition->thread);
+#else
+            pthread_join(rendition->thread, NULL);
+#endif
+            rendition->started = false;
+        }
+    }
+}
+
+static void write_audio_packet(VideoContext* output, const BlurConfig* config, const AVPacket* packet,
+    AVPacket* audio_pkt) {
+    if (output->audio_stream_idx < 0) return;
+    if (av_packet_ref(audio_pkt, packet) < 0) return;
+
+    audio_pkt->stream_index = output->audio_stream_idx;
+    av_packet_rescale_ts(audio_pkt,
+        g_input_ctx->audio_stream->time_base,
+        output->audio_stream->time_base);
+
+    if (g_trim.active) {
+        int64_t offset = av_rescale_q(g_trim.start, AV_TIME_BASE_Q, output->audio_stream->time_base);
+        audio_pkt->pts -= offset;
+        audio_pkt->dts -= offset;
+    }
+
+    if (config->timescale != 1.0 && !config->pitch_correction) {
+        audio_pkt->pts = (int64_t)(audio_pkt->pts / config->timescale);
+        audio_pkt->dts = (int64_t)(audio_pkt->dts / config->timescale);
+        audio_pkt->duration = (int64_t)(audio_pkt->duration / config->timescale);
+    }
+
+    write_packet(output, audio_pkt);
+}
+
+#define DEMUX_QUEUE_PACKETS 8192
+
+typedef struct {
+    AVPacket** packets;
+    int capacity;
+    int count;
+    int read_pos;
+    int write_pos;
+    size_t bytes;
+    size_t max_bytes;
+    size_t peak_bytes;
+    bool finished;
+    int64_t starved_us;
+    int64_t blocked_us;
+#ifdef _WIN32
+    HANDLE mutex;
+    HANDLE not_empty;
+    HANDLE not_full;
+#else
+    pthread_mutex_t mutex;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+#endif
+} PacketQueue;
+
+typedef struct {
+    PacketQueue queue;
+    const BlurConfig* config;
+    AVPacket* audio_packet;
+    bool external_video;
+    bool reached_end;
+    int64_t packets_read;
+} Demuxer;
+
+static bool packet_queue_init(PacketQueue* queue, int capacity, size_t max_bytes) {
+    memset(queue, 0, sizeof(PacketQueue));
+    queue->packets = (AVPacket**)calloc(capacity, sizeof(AVPacket*));
+    if (!queue->packets) return false;
+
+    queue->capacity = capacity;
+    queue->max_bytes = max_bytes;
+#ifdef _WIN32
+    queue->mutex = CreateMutex(NULL, FALSE, NULL);
+    queue->not_empty = CreateEvent(NULL, FALSE, FALSE, NULL);
+    queue->not_full = CreateEvent(NULL, FALSE, FALSE, NULL);
+#else
+    pthread_mutex_init(&queue->mutex, NULL);
+    pthread_cond_init(&queue->not_empty, NULL);
+    pthread_cond_init(&queue->not_full, NULL);
+#endif
+    return true;
+}
+
+static void packet_queue_destroy(PacketQueue* queue) {
+    if (!queue->packets) return;
+
+    for (int i = 0; i < queue->capacity; i++) {
+        av_packet_free(&queue->packets[i]);
+    }
+    free(queue->packets);
+    queue->packets = NULL;
+
+#ifdef _WIN32
+    CloseHandle(queue->mutex);
+    CloseHandle(queue->not_empty);
+    CloseHandle(queue->not_full);
+#else
+    pthread_mutex_destroy(&queue->mutex);
+    pthread_cond_destroy(&queue->not_empty);
+    pthread_cond_destroy(&queue->not_full);
+#endif
+}
+
+static bool packet_queue_full(const PacketQueue* queue) {
+    return queue->count >= queue->capacity || (queue->count > 0 && queue->bytes >= queue->max_bytes);
+}
+
+static bool packet_queue_push(PacketQueue* queue, AVPacket* packet) {
+    int64_t wait_start = 0;
+
+#ifdef _WIN32
+    WaitForSingleObject(queue->mutex, INFINITE);
+
+    while (packet_queue_full(queue) && !is_interrupted()) {
+        if (!wait_start) wait_start = av_gettime_relative();
+        ReleaseMutex(queue->mutex);
+        WaitForSingleObject(queue->not_full, 1000);
+        WaitForSingleObject(queue->mutex, INFINITE);
+    }
+
+    if (is_interrupted()) {
+        ReleaseMutex(queue->mutex);
+        return false;
+    }
+#else
+    pthread_mutex_lock(&queue->mutex);
+
+    while (packet_queue_full(queue) && !is_interrupted()) {
+        if (!wait_start) wait_start = av_gettime_relative();
+        struct timespec timeout;
+        clock_gettime(CLOCK_REALTIME, &timeout);
+        timeout.tv_sec += 1;
+        pthread_cond_timedwait(&queue->not_full, &queue->mutex, &timeout);
+    }
+
+    if (is_interrupted()) {
+        pthread_mutex_unlock(&queue->mutex);
+        return false;
+    }
+#endif
+
+    if (wait_start) {
+        queue->blocked_us += av_gettime_relative() - wait_start;
+    }
+
+    AVPacket** slot = &queue->packets[queue->write_pos];
+    if (!*slot) {
+        *slot = av_packet_alloc();
+    }
+
+    bool pushed = *slot != NULL;
+    if (pushed) {
+        av_packet_move_ref(*slot, packet);
+        queue->write_pos = (queue->write_pos + 1) % queue->capacity;
+        queue->count++;
+        queue->bytes += (*slot)->size;
+        if (queue->bytes > queue->peak_bytes) {
+            queue->peak_bytes = queue->bytes;
+        }
+    }
+
+#ifdef _WIN32
+    SetEvent(queue->not_empty);
+    ReleaseMutex(queue->mutex);
+#else
+    pthread_cond_signal(&queue->not_empty);
+    pthread_mutex_unlock(&queue->mutex);
+#endif
+
+    return pushed;
+}
+
+static bool packet_queue_pop(PacketQueue* queue, AVPacket* packet) {
+    int64_t wait_start = 0;
+
+#ifdef _WIN32
+    WaitForSingleObject(queue->mutex, INFINITE);
+
+    while (queue->count == 0 && !queue->finished && !is_interrupted()) {
+        if (!wait_start) wait_start = av_gettime_relative();
+        ReleaseMutex(queue->mutex);
+        WaitForSingleObject(queue->not_empty, 1000);
+        WaitForSingleObject(queue->mutex, INFINITE);
+    }
+
+    if ((queue->count == 0 && queue->finished) || is_interrupted()) {
+        ReleaseMutex(queue->mutex);
+        return false;
+    }
+#else
+    pthread_mutex_lock(&queue->mutex);
+
+    while (queue->count == 0 && !queue->finished && !is_interrupted()) {
+        if (!wait_start) wait_start = av_gettime_relative();
+        struct timespec timeout;
+        clock_gettime(CLOCK_REALTIME, &timeout);
+        timeout.tv_sec += 1;
+        pthread_cond_timedwait(&queue->not_empty, &queue->mutex, &timeout);
+    }
+
+    if ((queue->count == 0 && queue->finished) || is_interrupted()) {
+        pthread_mutex_unlock(&queue->mutex);
+        return false;
+    }
+#endif
+
+    if (wait_start) {
+        queue->starved_us += av_gettime_relative() - wait_start;
+    }
+
+    AVPacket* slot = queue->packets[queue->read_pos];
+    queue->bytes -= slot->size;
+    av_packet_move_ref(packet, slot);
+    queue->read_pos = (queue->read_pos + 1) % queue->capacity;
+    queue->count--;
+
+#ifdef _WIN32
+    SetEvent(queue->not_full);
+    ReleaseMutex(queue->mutex);
+#else
+    pthread_cond_signal(&queue->not_full);
+    pthread_mutex_unlock(&queue->mutex);
+#endif
+
+    return true;
+}
 
-                    g_output_ctx->packet->stream_index = g_output_ctx->video_stream->index;
-                    av_packet_rescale_ts(g_output_ctx->packet,
-                        g_output_ctx->codec_ctx->time_base,
-                        g_output_ctx->video_stream->time_base);
+static void packet_queue_finish(PacketQueue* queue) {
+#ifdef _WIN32
+    WaitForSingleObject(queue->mutex, INFINITE);
+    queue->finished = true;
+    SetEvent(queue->not_empty);
+    ReleaseMutex(queue->mutex);
+#else
+    pthread_mutex_lock(&queue->mutex);
+    queue->finished = true;
+    pthread_cond_broadcast(&queue->not_empty);
+    pthread_mutex_unlock(&queue->mutex);
+#endif
+}
+
+static THREAD_FUNC demux_thread(void* arg) {
+    Demuxer* demuxer = (Demuxer*)arg;
+    const BlurConfig* config = demuxer->config;
+    AVPacket* packet = g_input_ctx->packet;
+    bool video_done = false;
+    bool audio_done = g_input_ctx->audio_stream_idx < 0 || !demuxer->audio_packet;
+
+    while (!is_interrupted()) {
+        int ret = av_read_frame(g_input_ctx->fmt_ctx, packet);
+        if (ret < 0) {
+            if (ret == AVERROR_EOF) {
+                demuxer->reached_end = true;
+                if (config->verbose) {
+                    printf("Reached end of input file\n");
+                }
+            }
+            else {
+                fprintf(stderr, "Error reading frame: %d\n", ret);
+            }
+            break;
+        }
 
-                    ret = av_interleaved_write_frame(g_output_ctx->fmt_ctx, g_output_ctx->packet);
-                    if (ret < 0) {
-                        if (config->debug) {
-                            fprintf(stderr, "Error writing packet: %d\n", ret);
-                        }
+        demuxer->packets_read++;
+
+        if (packet->stream_index == g_input_ctx->video_stream_idx) {
+            packet_index_record(g_input_ctx->packet_index, packet);
+            if (video_done || trim_after_end(packet->dts, g_input_ctx->video_stream->time_base)) {
+                video_done = true;
+            }
+            else if (!demuxer->external_video && !packet_queue_push(&demuxer->queue, packet)) {
+                av_packet_unref(packet);
+                break;
+            }
+        }
+        else if (packet->stream_index == g_input_ctx->audio_stream_idx && demuxer->audio_packet) {
+            AVRational audio_time_base = g_input_ctx->audio_stream->time_base;
+            if (audio_done || trim_after_end(packet->pts, audio_time_base)) {
+                audio_done = true;
+            }
+            else if (!trim_before(packet->pts, audio_time_base, g_trim.start)) {
+                for (int i = 0; i < g_branch_count; i++) {
+                    RenderBranch* branch = &g_branches[i];
+                    write_audio_packet(branch->output, branch->config, packet, demuxer->audio_packet);
+                    for (int j = 0; j < branch->rendition_count; j++) {
+                        write_audio_packet(branch->renditions[j].output, branch->config, packet,
+                            demuxer->audio_packet);
                     }
+                }
+            }
+        }
+
+        av_packet_unref(packet);
+
+        if (video_done && audio_done) {
+            if (config->verbose) {
+                printf("Reached end time\n");
+            }
+            break;
+        }
+    }
+
+    packet_queue_finish(&demuxer->queue);
+
+#ifdef _WIN32
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+static bool finish_output(VideoContext* output) {
+    if (output->raw_sink) {
+        return !output->raw_sink->error;
+    }
+    if (output->shm_sink) {
+        return !output->shm_sink->error;
+    }
+    if (output->image_sink) {
+        return image_sink_finish(output->image_sink);
+    }
+
+    av_write_trailer(output->fmt_ctx);
+    return output_io_finish(output->output_io);
+}
+
+static AVFrame* convert_ingest_frame(const BlurConfig* config, AVFrame* frame) {
+    if (frame->format == AV_PIX_FMT_YUV420P) {
+        return frame;
+    }
+
+    if (g_ingest_frame && (g_ingest_frame->width != frame->width || g_ingest_frame->height != frame->height)) {
+        av_frame_free(&g_ingest_frame);
+    }
+    if (!g_ingest_frame) {
+        g_ingest_frame = av_frame_alloc();
+        if (!g_ingest_frame) return NULL;
+        g_ingest_frame->format = AV_PIX_FMT_YUV420P;
+        g_ingest_frame->width = frame->width;
+        g_ingest_frame->height = frame->height;
+        if (av_frame_get_buffer(g_ingest_frame, 32) < 0) {
+            av_frame_free(&g_ingest_frame);
+            return NULL;
+        }
+        if (config->verbose) {
+            printf("Converting %s input to yuv420p\n", av_get_pix_fmt_name(frame->format));
+        }
+    }
+
+    g_input_ctx->sws_ctx = sws_getCachedContext(g_input_ctx->sws_ctx, frame->width, frame->height, frame->format,
+        frame->width, frame->height, AV_PIX_FMT_YUV420P, SWS_BILINEAR, NULL, NULL, NULL);
+    if (!g_input_ctx->sws_ctx || av_frame_make_writable(g_ingest_frame) < 0) {
+        return NULL;
+    }
+
+    sws_scale(g_input_ctx->sws_ctx, (const uint8_t* const*)frame->data, frame->linesize, 0, frame->height,
+        g_ingest_frame->data, g_ingest_frame->linesize);
+    av_frame_copy_props(g_ingest_frame, frame);
+    return g_ingest_frame;
+}
+
+static bool deliver_decoded_frame(const BlurConfig* config, ProxyCache* proxy, AVFrame* decoded_frame,
+    AVFrame* filtered_frame, int64_t* frames_read) {
+    AVRational time_base = g_input_ctx->video_stream->time_base;
+    if (trim_before(decoded_frame->pts, time_base, g_trim.preroll) || trim_after_end(decoded_frame->pts, time_base)) {
+        return true;
+    }
+
+    AVFrame* source_frame = convert_ingest_frame(config,
+        proxy ? proxy_cache_store(proxy, decoded_frame) : decoded_frame);
+    if (!source_frame) {
+        fprintf(stderr, "Failed to convert decoded frame to yuv420p\n");
+        return false;
+    }
 
-                    av_packet_unref(g_output_ctx->packet);
+    if (g_filter_graph) {
+        int ret = av_buffersrc_add_frame_flags(g_buffersrc_ctx, source_frame, AV_BUFFERSRC_FLAG_KEEP_REF);
+        if (ret < 0) {
+            if (config->debug) {
+                fprintf(stderr, "Error feeding frame to filter graph: %d\n", ret);
+            }
+            return true;
+        }
+
+        while (true) {
+            ret = av_buffersink_get_frame(g_buffersink_ctx, filtered_frame);
+            if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
+                break;
+            }
+            else if (ret < 0) {
+                if (config->debug) {
+                    fprintf(stderr, "Error getting frame from filter: %d\n", ret);
                 }
+                break;
+            }
+
+            if (!render_branches_push(filtered_frame)) {
+                av_frame_unref(filtered_frame);
+                break;
             }
+            av_frame_unref(filtered_frame);
+        }
+    }
+    else {
+        if (!render_branches_push(source_frame)) {
+            return false;
+        }
+    }
+
+    (*frames_read)++;
+    if (*frames_read % 100 == 0 && config->verbose) {
+        printf("Read %lld frames\n", (long long)*frames_read);
+    }
+    return true;
+}
+
+#define PARALLEL_DECODE_MAX_WORKERS 16
+
+typedef struct ParallelDecoder ParallelDecoder;
+
+typedef struct {
+    AVPacket* packet;
+    AVFrame* frame;
+    bool decoded;
+    bool failed;
+} DecodeSlot;
+
+typedef struct {
+    ParallelDecoder* decoder;
+    pthread_t thread;
+    bool started;
+    AVCodecContext* codec_ctx;
+} DecodeWorker;
+
+struct ParallelDecoder {
+    DecodeWorker* workers;
+    int worker_count;
+    DecodeSlot* slots;
+    int window;
+    int64_t submitted;
+    int64_t claimed;
+    int64_t delivered;
+    bool stopping;
+    bool debug;
+    bool verbose;
+    int64_t decode_us;
+    int64_t wait_us;
+#ifdef _WIN32
+    HANDLE mutex;
+    HANDLE work_ready;
+    HANDLE frame_ready;
+#else
+    pthread_mutex_t mutex;
+    pthread_cond_t work_ready;
+    pthread_cond_t frame_ready;
+#endif
+};
+
+static void parallel_decoder_lock(ParallelDecoder* decoder) {
+#ifdef _WIN32
+    WaitForSingleObject(decoder->mutex, INFINITE);
+#else
+    pthread_mutex_lock(&decoder->mutex);
+#endif
+}
+
+static void parallel_decoder_unlock(ParallelDecoder* decoder) {
+#ifdef _WIN32
+    ReleaseMutex(decoder->mutex);
+#else
+    pthread_mutex_unlock(&decoder->mutex);
+#endif
+}
+
+#ifdef _WIN32
+static void parallel_decoder_wait(ParallelDecoder* decoder, HANDLE event) {
+    ReleaseMutex(decoder->mutex);
+    WaitForSingleObject(event, 10);
+    WaitForSingleObject(decoder->mutex, INFINITE);
+}
+
+static void parallel_decoder_signal(HANDLE event) {
+    SetEvent(event);
+}
+#else
+static void parallel_decoder_wait(ParallelDecoder* decoder, pthread_cond_t* cond) {
+    pthread_cond_wait(cond, &decoder->mutex);
+}
+
+static void parallel_decoder_signal(pthread_cond_t* cond) {
+    pthread_cond_broadcast(cond);
+}
+#endif
+
+static THREAD_FUNC parallel_decode_worker(void* arg) {
+    DecodeWorker* worker = (DecodeWorker*)arg;
+    ParallelDecoder* decoder = worker->decoder;
+
+    while (true) {
+        parallel_decoder_lock(decoder);
+        while (!decoder->stopping && decoder->claimed == decoder->submitted) {
+#ifdef _WIN32
+            parallel_decoder_wait(decoder, decoder->work_ready);
+#else
+            parallel_decoder_wait(decoder, &decoder->work_ready);
+#endif
+        }
+        if (decoder->claimed == decoder->submitted) {
+            parallel_decoder_unlock(decoder);
+            break;
+        }
+        DecodeSlot* slot = &decoder->slots[decoder->claimed++ % decoder->window];
+        parallel_decoder_unlock(decoder);
+
+        int64_t start = av_gettime_relative();
+        int ret = avcodec_send_packet(worker->codec_ctx, slot->packet);
+        if (ret >= 0) {
+            ret = avcodec_receive_frame(worker->codec_ctx, slot->frame);
+        }
+        av_packet_unref(slot->packet);
+        if (ret < 0 && decoder->debug) {
+            fprintf(stderr, "Error decoding intra frame: %d\n", ret);
+        }
+        int64_t elapsed = av_gettime_relative() - start;
+
+        parallel_decoder_lock(decoder);
+        slot->failed = ret < 0;
+        slot->decoded = true;
+        decoder->decode_us += elapsed;
+#ifdef _WIN32
+        parallel_decoder_signal(decoder->frame_ready);
+#else
+        parallel_decoder_signal(&decoder->frame_ready);
+#endif
+        parallel_decoder_unlock(decoder);
+    }
+
+#ifdef _WIN32
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+static bool parallel_decoder_full(ParallelDecoder* decoder) {
+    return decoder->submitted - decoder->delivered >= decoder->window;
+}
+
+static void parallel_decoder_submit(ParallelDecoder* decoder, AVPacket* packet) {
+    DecodeSlot* slot = &decoder->slots[decoder->submitted % decoder->window];
+    av_packet_move_ref(slot->packet, packet);
+
+    parallel_decoder_lock(decoder);
+    slot->decoded = false;
+    decoder->submitted++;
+#ifdef _WIN32
+    parallel_decoder_signal(decoder->work_ready);
+#else
+    parallel_decoder_signal(&decoder->work_ready);
+#endif
+    parallel_decoder_unlock(decoder);
+}
 
-            free(ordered_frames);
+static bool parallel_decoder_next(ParallelDecoder* decoder, AVFrame* frame, bool wait) {
+    while (decoder->delivered < decoder->submitted) {
+        DecodeSlot* slot = &decoder->slots[decoder->delivered % decoder->window];
+
+        int64_t start = av_gettime_relative();
+        parallel_decoder_lock(decoder);
+        while (wait && !slot->decoded) {
+#ifdef _WIN32
+            parallel_decoder_wait(decoder, decoder->frame_ready);
+#else
+            parallel_decoder_wait(decoder, &decoder->frame_ready);
+#endif
         }
+        bool decoded = slot->decoded;
+        parallel_decoder_unlock(decoder);
+        decoder->wait_us += av_gettime_relative() - start;
 
-        frames_processed++;
-        if (frames_processed % 30 == 0) {
-            update_progress(frames_processed);
+        if (!decoded) {
+            return false;
         }
 
-        av_frame_unref(input_frame);
+        decoder->delivered++;
+        if (!slot->failed) {
+            av_frame_move_ref(frame, slot->frame);
+            return true;
+        }
     }
+    return false;
+}
 
-    avcodec_send_frame(g_output_ctx->codec_ctx, NULL);
-    while (true) {
-        int ret = avcodec_receive_packet(g_output_ctx->codec_ctx, g_output_ctx->packet);
-        if (ret == AVERROR_EOF) {
-            break;
-        }
-        else if (ret < 0) {
-            break;
-        }
+static void parallel_decoder_close(ParallelDecoder* decoder) {
+    if (!decoder) return;
 
-        g_output_ctx->packet->stream_index = g_output_ctx->video_stream->index;
-        av_packet_rescale_ts(g_output_ctx->packet,
-            g_output_ctx->codec_ctx->time_base,
-            g_output_ctx->video_stream->time_base);
+    parallel_decoder_lock(decoder);
+    decoder->stopping = true;
+#ifdef _WIN32
+    parallel_decoder_signal(decoder->work_ready);
+#else
+    parallel_decoder_signal(&decoder->work_ready);
+#endif
+    parallel_decoder_unlock(decoder);
 
-        av_interleaved_write_frame(g_output_ctx->fmt_ctx, g_output_ctx->packet);
-        av_packet_unref(g_output_ctx->packet);
+    for (int i = 0; i < decoder->worker_count; i++) {
+        DecodeWorker* worker = &decoder->workers[i];
+        if (worker->started) {
+#ifdef _WIN32
+            WaitForSingleObject(worker->thread, INFINITE);
+            CloseHandle(worker->thread);
+#else
+            pthread_join(worker->thread, NULL);
+#endif
+        }
+        avcodec_free_context(&worker->codec_ctx);
     }
 
-    if (output_buffer.allocated && output_buffer.data) {
-        for (int i = 0; i < 4; i++) {
-            if (output_buffer.data[i]) {
-                av_free(output_buffer.data[i]);
-            }
+    if (decoder->slots) {
+        for (int i = 0; i < decoder->window; i++) {
+            av_packet_free(&decoder->slots[i].packet);
+            av_frame_free(&decoder->slots[i].frame);
         }
-        av_free(output_buffer.data);
-        av_free(output_buffer.linesize);
     }
 
-    for (int i = 0; i < blur_buffer.capacity; i++) {
-        if (blur_buffer.buffer[i].allocated && blur_buffer.buffer[i].data) {
-            for (int j = 0; j < 4; j++) {
-                if (blur_buffer.buffer[i].data[j]) {
-                    av_free(blur_buffer.buffer[i].data[j]);
-                }
-            }
-            av_free(blur_buffer.buffer[i].data);
-            av_free(blur_buffer.buffer[i].linesize);
-        }
+    if (decoder->verbose) {
+        printf("Parallel decode: %lld frames on %d decoders, %.2f s decoding, reader waited %.2f s\n",
+            (long long)decoder->delivered, decoder->worker_count,
+            decoder->decode_us / 1000000.0, decoder->wait_us / 1000000.0);
     }
 
-    for (int i = 0; i < dedup_count; i++) {
-        if (dedup_frames[i].allocated && dedup_frames[i].data) {
-            for (int j = 0; j < 4; j++) {
-                if (dedup_frames[i].data[j]) {
-                    av_free(dedup_frames[i].data[j]);
-                }
-            }
-            av_free(dedup_frames[i].data);
-            av_free(dedup_frames[i].linesize);
-        }
+#ifdef _WIN32
+    CloseHandle(decoder->mutex);
+    CloseHandle(decoder->work_ready);
+    CloseHandle(decoder->frame_ready);
+#else
+    pthread_mutex_destroy(&decoder->mutex);
+    pthread_cond_destroy(&decoder->work_ready);
+    pthread_cond_destroy(&decoder->frame_ready);
+#endif
+    free(decoder->workers);
+    free(decoder->slots);
+    free(decoder);
+}
+
+static bool is_intra_only_codec(enum AVCodecID codec_id) {
+    switch (codec_id) {
+    case AV_CODEC_ID_PRORES:
+    case AV_CODEC_ID_DNXHD:
+    case AV_CODEC_ID_MJPEG:
+    case AV_CODEC_ID_FFV1:
+        return true;
+    default: {
+        const AVCodecDescriptor* desc = avcodec_descriptor_get(codec_id);
+        return desc && (desc->props & AV_CODEC_PROP_INTRA_ONLY);
+    }
     }
+}
 
-    free(blur_buffer.buffer);
-    free(weights);
-    av_frame_free(&output_frame);
-    av_frame_free(&input_frame);
+static ParallelDecoder* parallel_decoder_open(const BlurConfig* config) {
+    AVCodecParameters* codecpar = g_input_ctx->video_stream->codecpar;
+    int worker_count = config->threads > 0 ? config->threads : get_cpu_count();
+    if (worker_count > PARALLEL_DECODE_MAX_WORKERS) worker_count = PARALLEL_DECODE_MAX_WORKERS;
 
-    if (config->verbose) {
-        printf("Processing thread finished, processed %d frames\n", frames_processed);
+    if (g_input_ctx->hw_device_ctx || worker_count < 2 || !is_intra_only_codec(codecpar->codec_id)) {
+        return NULL;
     }
 
+    ParallelDecoder* decoder = (ParallelDecoder*)calloc(1, sizeof(ParallelDecoder));
+    if (!decoder) return NULL;
+
 #ifdef _WIN32
-    return 0;
+    decoder->mutex = CreateMutex(NULL, FALSE, NULL);
+    decoder->work_ready = CreateEvent(NULL, FALSE, FALSE, NULL);
+    decoder->frame_ready = CreateEvent(NULL, FALSE, FALSE, NULL);
 #else
-    return NULL;
+    pthread_mutex_init(&decoder->mutex, NULL);
+    pthread_cond_init(&decoder->work_ready, NULL);
+    pthread_cond_init(&decoder->frame_ready, NULL);
+#endif
+    decoder->debug = config->debug;
+    decoder->verbose = config->verbose;
+    decoder->worker_count = worker_count;
+    decoder->window = worker_count * 2;
+    decoder->workers = (DecodeWorker*)calloc(worker_count, sizeof(DecodeWorker));
+    decoder->slots = (DecodeSlot*)calloc(decoder->window, sizeof(DecodeSlot));
+    bool ready = decoder->workers && decoder->slots;
+
+    for (int i = 0; ready && i < decoder->window; i++) {
+        decoder->slots[i].packet = av_packet_alloc();
+        decoder->slots[i].frame = av_frame_alloc();
+        ready = decoder->slots[i].packet && decoder->slots[i].frame;
+    }
+
+    const AVCodec* codec = g_input_ctx->codec_ctx->codec;
+    for (int i = 0; ready && i < worker_count; i++) {
+        DecodeWorker* worker = &decoder->workers[i];
+        worker->decoder = decoder;
+        worker->codec_ctx = avcodec_alloc_context3(codec);
+        ready = worker->codec_ctx && avcodec_parameters_to_context(worker->codec_ctx, codecpar) >= 0;
+        if (ready) {
+            worker->codec_ctx->pkt_timebase = g_input_ctx->video_stream->time_base;
+            worker->codec_ctx->thread_count = 1;
+            ready = avcodec_open2(worker->codec_ctx, codec, NULL) >= 0;
+        }
+    }
+
+    for (int i = 0; ready && i < worker_count; i++) {
+        DecodeWorker* worker = &decoder->workers[i];
+#ifdef _WIN32
+        worker->thread = CreateThread(NULL, 0, parallel_decode_worker, worker, 0, NULL);
+        worker->started = worker->thread != NULL;
+#else
+        worker->started = pthread_create(&worker->thread, NULL, parallel_decode_worker, worker) == 0;
 #endif
+        ready = worker->started;
+    }
+
+    if (!ready) {
+        if (config->verbose) {
+            printf("Parallel intra decoding unavailable, using a single decoder\n");
+        }
+        decoder->verbose = false;
+        parallel_decoder_close(decoder);
+        return NULL;
+    }
+
+    if (config->verbose) {
+        printf("Decoding intra-only %s on %d parallel decoders\n", avcodec_get_name(codecpar->codec_id), worker_count);
+    }
+    return decoder;
 }
 
 bool video_process(const BlurConfig* config) {
-    int width = g_input_ctx->codec_ctx->width;
-    int height = g_input_ctx->codec_ctx->height;
+    RawSource* raw_source = g_input_ctx->raw_source;
+    ImageSequence* image_sequence = g_input_ctx->image_sequence;
+    bool native_input = raw_source || image_sequence;
+    int width = native_input ? g_input_ctx->video_stream->codecpar->width : g_input_ctx->codec_ctx->width;
+    int height = native_input ? g_input_ctx->video_stream->codecpar->height : g_input_ctx->codec_ctx->height;
     double input_fps = av_q2d(g_input_ctx->video_stream->avg_frame_rate);
     double output_fps = parse_fps_string(config->blur_output_fps, input_fps);
+    ProxyCache* proxy = NULL;
+    bool frame_server = false;
+
+    if (native_input && (config->start_time > 0 || config->end_time > 0)) {
+        fprintf(stderr, "--start and --end are not supported for raw and image sequence input\n");
+        return false;
+    }
+
+#ifdef HAVE_VAPOURSYNTH
+    frame_server = config->job_count == 0 && strcmp(config->blur_mode, "frames") == 0 &&
+        !is_pipe_path(config->input_file) && !native_input && config->start_time <= 0 && config->end_time <= 0 &&
+        get_interpolation_factor(config, input_fps) > 1 &&
+        (strcmp(config->interpolation_method, "svp") == 0 || strcmp(config->interpolation_method, "rife") == 0);
+#endif
+
+    if (!frame_server && !native_input && strlen(config->proxy_cache) > 0) {
+        proxy = proxy_cache_open(config, width, height);
+        if (proxy) {
+            width = proxy->header.width;
+            height = proxy->header.height;
+        }
+    }
+    g_frame_width = width;
+    g_frame_height = height;
 
     if (config->timescale != 1.0) {
         output_fps *= config->timescale;
@@ -1151,17 +8250,27 @@ bool video_process(const BlurConfig* config) {
 
     printf("Processing %dx%d video: %.2f fps -> %.2f fps\n", width, height, input_fps, output_fps);
 
-    g_output_ctx = (VideoContext*)calloc(1, sizeof(VideoContext));
-    if (!g_output_ctx) {
-        fprintf(stderr, "Failed to allocate output context\n");
+    g_branch_count = 1 + config->job_count;
+    g_branches = (RenderBranch*)calloc(g_branch_count, sizeof(RenderBranch));
+    g_branch_queues = (FrameQueue**)calloc(g_branch_count, sizeof(FrameQueue*));
+    if (!g_branches || !g_branch_queues) {
+        fprintf(stderr, "Failed to allocate render branches\n");
+        g_branch_count = 0;
         return false;
     }
 
-    if (config->gpu_encoding && g_input_ctx->hw_device_ctx) {
-        g_output_ctx->hw_device_ctx = g_input_ctx->hw_device_ctx;
+    shared_frame_pool_init();
+
+    for (int i = 0; i < g_branch_count; i++) {
+        const BlurConfig* branch_config = i == 0 ? config : &config->jobs[i - 1];
+        if (!render_branch_open(&g_branches[i], branch_config, i, width, height, input_fps)) {
+            return false;
+        }
+        g_branch_queues[i] = g_branches[i].queue;
     }
 
-    if (!create_output_video(g_output_ctx, config->output_file, config, width, height, output_fps)) {
+    if (!mux_start(config->debug)) {
+        fprintf(stderr, "Failed to start mux thread\n");
         return false;
     }
 
@@ -1172,172 +8281,288 @@ bool video_process(const BlurConfig* config) {
         }
     }
 
-    g_frame_queue = (FrameQueue*)calloc(1, sizeof(FrameQueue));
-    if (!g_frame_queue) {
-        fprintf(stderr, "Failed to allocate frame queue\n");
-        return false;
-    }
-
-    frame_queue_init(g_frame_queue, 200);
+#ifdef HAVE_VAPOURSYNTH
+    VSFrameReader* vs_reader = NULL;
+    pthread_t vs_tid;
+    bool vs_started = false;
+    int interp_factor = get_interpolation_factor(config, input_fps);
+    if (frame_server) {
+        g_vs_ctx = (VapourSynthContext*)calloc(1, sizeof(VapourSynthContext));
+        vs_reader = (VSFrameReader*)calloc(1, sizeof(VSFrameReader));
+        if (!g_vs_ctx || !vs_reader || !vapoursynth_open(g_vs_ctx, config, interp_factor, width, height)) {
+            fprintf(stderr, "Warning: VapourSynth backend unavailable, using native interpolation\n");
+            if (g_vs_ctx && g_vs_ctx->node) {
+                g_vs_ctx->vsapi->freeNode(g_vs_ctx->node);
+                g_vs_ctx->node = NULL;
+            }
+            free(vs_reader);
+            vs_reader = NULL;
+        }
+        else {
+            vs_reader->config = config;
+            vs_reader->vs = g_vs_ctx;
+#ifdef _WIN32
+            vs_reader->mutex = CreateMutex(NULL, FALSE, NULL);
+            vs_reader->frame_ready = CreateEvent(NULL, FALSE, FALSE, NULL);
+#else
+            pthread_mutex_init(&vs_reader->mutex, NULL);
+            pthread_cond_init(&vs_reader->frame_ready, NULL);
+#endif
 
 #ifdef _WIN32
-    HANDLE processing_tid = CreateThread(NULL, 0, processing_thread, (void*)config, 0, NULL);
-    if (!processing_tid) {
-        fprintf(stderr, "Failed to create processing thread\n");
-        return false;
+            vs_tid = CreateThread(NULL, 0, vapoursynth_read_thread, vs_reader, 0, NULL);
+            vs_started = vs_tid != NULL;
+#else
+            vs_started = pthread_create(&vs_tid, NULL, vapoursynth_read_thread, vs_reader) == 0;
+#endif
+            if (!vs_started) {
+                fprintf(stderr, "Warning: Failed to create VapourSynth reader thread, using native interpolation\n");
+                g_vs_ctx->vsapi->freeNode(g_vs_ctx->node);
+                g_vs_ctx->node = NULL;
+            }
+        }
     }
+#endif
+
+    pthread_t proxy_tid;
+    bool proxy_started = false;
+    if (proxy && proxy->reading) {
+#ifdef _WIN32
+        proxy_tid = CreateThread(NULL, 0, proxy_read_thread, proxy, 0, NULL);
+        proxy_started = proxy_tid != NULL;
 #else
-    pthread_t processing_tid;
-    if (pthread_create(&processing_tid, NULL, processing_thread, (void*)config) != 0) {
-        fprintf(stderr, "Failed to create processing thread\n");
-        return false;
+        proxy_started = pthread_create(&proxy_tid, NULL, proxy_read_thread, proxy) == 0;
+#endif
+        if (!proxy_started) {
+            fprintf(stderr, "Failed to create proxy reader thread\n");
+            proxy_cache_close(proxy, false);
+            return false;
+        }
     }
+
+    pthread_t native_tid;
+    bool native_started = false;
+    if (native_input) {
+        void* reader = raw_source ? (void*)raw_source : (void*)image_sequence;
+#ifdef _WIN32
+        native_tid = CreateThread(NULL, 0, raw_source ? raw_read_thread : image_sequence_thread, reader, 0, NULL);
+        native_started = native_tid != NULL;
+#else
+        native_started = pthread_create(&native_tid, NULL,
+            raw_source ? raw_read_thread : image_sequence_thread, reader) == 0;
 #endif
+        if (!native_started) {
+            fprintf(stderr, "Failed to create input reader thread\n");
+            return false;
+        }
+    }
+
+    bool external_video = vapoursynth_active() || proxy_started || native_started;
+
+    for (int i = 0; i < g_branch_count; i++) {
+        if (!render_branch_start(&g_branches[i])) {
+            fprintf(stderr, "Failed to create processing thread for %s\n", g_branches[i].config->output_file);
+            render_branches_finish();
+            mux_stop();
+            return false;
+        }
+    }
 
     AVFrame* decoded_frame = av_frame_alloc();
     AVFrame* filtered_frame = av_frame_alloc();
+    AVPacket* video_packet = av_packet_alloc();
     int64_t frames_read = 0;
     int ret;
 
+    trim_open(config, input_fps);
+
+    Demuxer demuxer = { 0 };
+    demuxer.config = config;
+    demuxer.external_video = external_video;
+    demuxer.audio_packet = av_packet_alloc();
+
+    pthread_t demux_tid;
+    bool demux_started = !native_started && video_packet &&
+        packet_queue_init(&demuxer.queue, DEMUX_QUEUE_PACKETS, (size_t)config->read_ahead_mb << 20);
+    if (demux_started) {
+#ifdef _WIN32
+        demux_tid = CreateThread(NULL, 0, demux_thread, &demuxer, 0, NULL);
+        demux_started = demux_tid != NULL;
+#else
+        demux_started = pthread_create(&demux_tid, NULL, demux_thread, &demuxer) == 0;
+#endif
+    }
+
+    if (!demux_started && !native_started) {
+        fprintf(stderr, "Failed to create demux thread\n");
+    }
+
     if (config->verbose) {
         printf("Starting frame reading and decoding...\n");
     }
 
-    while (!is_interrupted()) {
-        ret = av_read_frame(g_input_ctx->fmt_ctx, g_input_ctx->packet);
-        if (ret < 0) {
-            if (ret == AVERROR_EOF) {
-                if (config->verbose) {
-                    printf("Reached end of input file\n");
-                }
-            }
-            else {
-                fprintf(stderr, "Error reading frame: %d\n", ret);
-            }
-            break;
-        }
+    ParallelDecoder* parallel = demux_started && !external_video ? parallel_decoder_open(config) : NULL;
+    bool delivering = true;
 
-        if (g_input_ctx->packet->stream_index == g_input_ctx->video_stream_idx) {
-            ret = avcodec_send_packet(g_input_ctx->codec_ctx, g_input_ctx->packet);
-            if (ret < 0) {
-                if (config->debug) {
-                    fprintf(stderr, "Error sending packet to decoder: %d\n", ret);
-                }
-                av_packet_unref(g_input_ctx->packet);
-                continue;
-            }
+    while (demux_started && packet_queue_pop(&demuxer.queue, video_packet)) {
+        if (!delivering) {
+            av_packet_unref(video_packet);
+            continue;
+        }
 
-            while (ret >= 0) {
-                ret = avcodec_receive_frame(g_input_ctx->codec_ctx, decoded_frame);
-                if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
-                    break;
-                }
-                else if (ret < 0) {
-                    if (config->debug) {
-                        fprintf(stderr, "Error receiving frame from decoder: %d\n", ret);
-                    }
+        if (parallel) {
+            while (parallel_decoder_next(parallel, decoded_frame, parallel_decoder_full(parallel))) {
+                delivering = deliver_decoded_frame(config, proxy, decoded_frame, filtered_frame, &frames_read);
+                av_frame_unref(decoded_frame);
+                if (!delivering) {
                     break;
                 }
+            }
 
-                if (g_filter_graph) {
-                    ret = av_buffersrc_add_frame_flags(g_buffersrc_ctx, decoded_frame, AV_BUFFERSRC_FLAG_KEEP_REF);
-                    if (ret < 0) {
-                        if (config->debug) {
-                            fprintf(stderr, "Error feeding frame to filter graph: %d\n", ret);
-                        }
-                        continue;
-                    }
-
-                    while (true) {
-                        ret = av_buffersink_get_frame(g_buffersink_ctx, filtered_frame);
-                        if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
-                            break;
-                        }
-                        else if (ret < 0) {
-                            if (config->debug) {
-                                fprintf(stderr, "Error getting frame from filter: %d\n", ret);
-                            }
-                            break;
-                        }
-
-                        if (!frame_queue_push(g_frame_queue, filtered_frame)) {
-                            av_frame_unref(filtered_frame);
-                            break;
-                        }
-                        av_frame_unref(filtered_frame);
-                    }
-                }
-                else {
-                    if (!frame_queue_push(g_frame_queue, decoded_frame)) {
-                        break;
-                    }
-                }
-
-                frames_read++;
-                if (frames_read % 100 == 0 && config->verbose) {
-                    printf("Read %lld frames\n", (long long)frames_read);
-                }
-
-                av_frame_unref(decoded_frame);
+            if (!delivering) {
+                parallel_decoder_close(parallel);
+                parallel = NULL;
+                av_packet_unref(video_packet);
+                continue;
             }
+            parallel_decoder_submit(parallel, video_packet);
+            continue;
         }
-        else if (g_output_ctx->audio_stream_idx >= 0 &&
-            g_input_ctx->packet->stream_index == g_input_ctx->audio_stream_idx) {
 
-            AVPacket* audio_pkt = av_packet_clone(g_input_ctx->packet);
-            if (audio_pkt) {
-                audio_pkt->stream_index = g_output_ctx->audio_stream_idx;
-                av_packet_rescale_ts(audio_pkt,
-                    g_input_ctx->audio_stream->time_base,
-                    g_output_ctx->audio_stream->time_base);
-
-                if (config->timescale != 1.0 && !config->pitch_correction) {
-                    audio_pkt->pts = (int64_t)(audio_pkt->pts / config->timescale);
-                    audio_pkt->dts = (int64_t)(audio_pkt->dts / config->timescale);
-                    audio_pkt->duration = (int64_t)(audio_pkt->duration / config->timescale);
-                }
+        ret = avcodec_send_packet(g_input_ctx->codec_ctx, video_packet);
+        if (ret < 0) {
+            if (config->debug) {
+                fprintf(stderr, "Error sending packet to decoder: %d\n", ret);
+            }
+            av_packet_unref(video_packet);
+            continue;
+        }
 
-                ret = av_interleaved_write_frame(g_output_ctx->fmt_ctx, audio_pkt);
-                if (ret < 0 && config->debug) {
-                    fprintf(stderr, "Error writing audio packet: %d\n", ret);
+        while (ret >= 0) {
+            ret = avcodec_receive_frame(g_input_ctx->codec_ctx, decoded_frame);
+            if (ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) {
+                break;
+            }
+            else if (ret < 0) {
+                if (config->debug) {
+                    fprintf(stderr, "Error receiving frame from decoder: %d\n", ret);
                 }
+                break;
+            }
 
-                av_packet_free(&audio_pkt);
+            bool pushed = deliver_decoded_frame(config, proxy, decoded_frame, filtered_frame, &frames_read);
+            av_frame_unref(decoded_frame);
+            if (!pushed) {
+                break;
             }
         }
 
-        av_packet_unref(g_input_ctx->packet);
+        av_packet_unref(video_packet);
     }
 
-    avcodec_send_packet(g_input_ctx->codec_ctx, NULL);
-    while (avcodec_receive_frame(g_input_ctx->codec_ctx, decoded_frame) >= 0) {
-        if (g_filter_graph) {
-            av_buffersrc_add_frame_flags(g_buffersrc_ctx, decoded_frame, AV_BUFFERSRC_FLAG_KEEP_REF);
-            while (av_buffersink_get_frame(g_buffersink_ctx, filtered_frame) >= 0) {
-                frame_queue_push(g_frame_queue, filtered_frame);
-                av_frame_unref(filtered_frame);
+    if (parallel) {
+        while (parallel_decoder_next(parallel, decoded_frame, true)) {
+            bool pushed = deliver_decoded_frame(config, proxy, decoded_frame, filtered_frame, &frames_read);
+            av_frame_unref(decoded_frame);
+            if (!pushed) {
+                break;
             }
         }
-        else {
-            frame_queue_push(g_frame_queue, decoded_frame);
-        }
+        parallel_decoder_close(parallel);
+    }
+
+    if (demux_started) {
+#ifdef _WIN32
+        WaitForSingleObject(demux_tid, INFINITE);
+        CloseHandle(demux_tid);
+#else
+        pthread_join(demux_tid, NULL);
+#endif
+    }
+    bool reached_end = demuxer.reached_end;
+    packet_index_save(g_input_ctx->packet_index, reached_end && !g_trim.active && !is_interrupted());
+
+    if (demux_started && config->verbose) {
+        printf("Demux read-ahead: %lld packets, peak %.1f of %d MB, decoder starved %.2f s, reader blocked %.2f s\n",
+            (long long)demuxer.packets_read, demuxer.queue.peak_bytes / 1048576.0, config->read_ahead_mb,
+            demuxer.queue.starved_us / 1000000.0, demuxer.queue.blocked_us / 1000000.0);
+    }
+
+    packet_queue_destroy(&demuxer.queue);
+    av_packet_free(&demuxer.audio_packet);
+    av_packet_free(&video_packet);
+
+    if (g_input_ctx->codec_ctx) {
+        avcodec_send_packet(g_input_ctx->codec_ctx, NULL);
+    }
+    while (!external_video && avcodec_receive_frame(g_input_ctx->codec_ctx, decoded_frame) >= 0) {
+        deliver_decoded_frame(config, proxy, decoded_frame, filtered_frame, &frames_read);
         av_frame_unref(decoded_frame);
     }
 
-    frame_queue_signal_finished(g_frame_queue);
+    if (proxy_started) {
+#ifdef _WIN32
+        WaitForSingleObject(proxy_tid, INFINITE);
+        CloseHandle(proxy_tid);
+#else
+        pthread_join(proxy_tid, NULL);
+#endif
+    }
 
-    if (config->verbose) {
-        printf("Waiting for processing to complete...\n");
+    if (native_started) {
+#ifdef _WIN32
+        WaitForSingleObject(native_tid, INFINITE);
+        CloseHandle(native_tid);
+#else
+        pthread_join(native_tid, NULL);
+#endif
     }
 
+#ifdef HAVE_VAPOURSYNTH
+    if (vs_reader) {
+        if (vs_started) {
+#ifdef _WIN32
+            WaitForSingleObject(vs_tid, INFINITE);
+            CloseHandle(vs_tid);
+#else
+            pthread_join(vs_tid, NULL);
+#endif
+        }
 #ifdef _WIN32
-    WaitForSingleObject(processing_tid, INFINITE);
-    CloseHandle(processing_tid);
+        CloseHandle(vs_reader->mutex);
+        CloseHandle(vs_reader->frame_ready);
 #else
-    pthread_join(processing_tid, NULL);
+        pthread_mutex_destroy(&vs_reader->mutex);
+        pthread_cond_destroy(&vs_reader->frame_ready);
+#endif
+        free(vs_reader);
+    }
 #endif
 
-    av_write_trailer(g_output_ctx->fmt_ctx);
+    if (config->verbose) {
+        printf("Waiting for processing to complete...\n");
+    }
+
+    render_branches_finish();
+    mux_stop();
+
+    bool written = true;
+    for (int i = 0; i < g_branch_count; i++) {
+        written = finish_output(g_branches[i].output) && written;
+        for (int j = 0; j < g_branches[i].rendition_count; j++) {
+            written = finish_output(g_branches[i].renditions[j].output) && written;
+        }
+    }
+    if (!written) {
+        fprintf(stderr, "Error writing output file\n");
+    }
+
+    if (proxy) {
+        for (int i = 0; i < g_branch_count; i++) {
+            frame_queue_release_external(g_branches[i].queue);
+        }
+        proxy_cache_close(proxy, reached_end && !is_interrupted());
+    }
 
     av_frame_free(&decoded_frame);
     av_frame_free(&filtered_frame);
@@ -1346,42 +8571,97 @@ bool video_process(const BlurConfig* config) {
         printf("Video processing completed\n");
     }
 
-    return !is_interrupted();
+    g_render_complete = (demux_started || native_started) && written && !is_interrupted();
+    return g_render_complete;
 }
 
-bool video_get_info(const char* filename, int* width, int* height, double* fps, int64_t* frame_count) {
-    AVFormatContext* fmt_ctx = NULL;
-    int ret;
-
-    ret = avformat_open_input(&fmt_ctx, filename, NULL, NULL);
-    if (ret < 0) {
+static bool open_native_stream(VideoContext* ctx, int width, int height, AVRational frame_rate, int64_t frame_count) {
+    ctx->fmt_ctx = avformat_alloc_context();
+    ctx->video_stream = ctx->fmt_ctx ? avformat_new_stream(ctx->fmt_ctx, NULL) : NULL;
+    if (!ctx->video_stream) {
+        fprintf(stderr, "Failed to allocate input stream\n");
         return false;
     }
 
-    ret = avformat_find_stream_info(fmt_ctx, NULL);
-    if (ret < 0) {
-        avformat_close_input(&fmt_ctx);
+    AVStream* stream = ctx->video_stream;
+    stream->codecpar->codec_type = AVMEDIA_TYPE_VIDEO;
+    stream->codecpar->codec_id = AV_CODEC_ID_RAWVIDEO;
+    stream->codecpar->format = AV_PIX_FMT_YUV420P;
+    stream->codecpar->width = width;
+    stream->codecpar->height = height;
+    stream->avg_frame_rate = frame_rate;
+    stream->r_frame_rate = frame_rate;
+    stream->time_base = av_inv_q(frame_rate);
+    stream->nb_frames = frame_count;
+    ctx->fmt_ctx->duration = AV_NOPTS_VALUE;
+    ctx->video_stream_idx = stream->index;
+    ctx->audio_stream_idx = -1;
+    return true;
+}
+
+static bool open_native_input(VideoContext* ctx, const BlurConfig* config) {
+    if (is_image_sequence(config->input_file)) {
+        ctx->image_sequence = image_sequence_open(config->input_file, config);
+        return ctx->image_sequence && open_native_stream(ctx, ctx->image_sequence->width,
+            ctx->image_sequence->height, ctx->image_sequence->frame_rate, ctx->image_sequence->frame_count);
+    }
+
+    ctx->raw_source = raw_source_open(config->input_file, config);
+    return ctx->raw_source && open_native_stream(ctx, ctx->raw_source->width, ctx->raw_source->height,
+        ctx->raw_source->frame_rate, ctx->raw_source->frame_count);
+}
+
+bool video_get_info(const BlurConfig* config, int* width, int* height, double* fps, int64_t* frame_count) {
+    g_input_ctx = (VideoContext*)calloc(1, sizeof(VideoContext));
+    if (!g_input_ctx) {
         return false;
     }
 
-    int video_stream_idx = -1;
-    for (unsigned int i = 0; i < fmt_ctx->nb_streams; i++) {
-        if (fmt_ctx->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_VIDEO) {
-            video_stream_idx = i;
-            break;
+    if (uses_raw_input(config) || is_image_sequence(config->input_file)) {
+        if (!open_native_input(g_input_ctx, config)) {
+            if (g_input_ctx->fmt_ctx) avformat_free_context(g_input_ctx->fmt_ctx);
+            raw_source_close(g_input_ctx->raw_source);
+            image_sequence_close(g_input_ctx->image_sequence);
+            free(g_input_ctx);
+            g_input_ctx = NULL;
+            return false;
         }
+
+        AVStream* stream = g_input_ctx->video_stream;
+        *width = stream->codecpar->width;
+        *height = stream->codecpar->height;
+        *fps = av_q2d(stream->avg_frame_rate);
+        *frame_count = stream->nb_frames;
+        return true;
     }
 
-    if (video_stream_idx == -1) {
-        avformat_close_input(&fmt_ctx);
+    BlurConfig decode_config = { 0 };
+    decode_config.gpu_decoding = false;
+    decode_config.threads = 1;
+    strcpy(decode_config.gpu_type, "nvidia");
+    decode_config.interpolate = config->interpolate;
+    decode_config.verbose = config->verbose;
+    strcpy(decode_config.motion_vectors, config->motion_vectors);
+    strcpy(decode_config.interpolation_method, config->interpolation_method);
+    strcpy(decode_config.blur_mode, config->blur_mode);
+    decode_config.fused_interpolation = config->fused_interpolation;
+    strcpy(decode_config.input_io, config->input_io);
+    decode_config.jobs = config->jobs;
+    decode_config.job_count = config->job_count;
+
+    if (!open_input_video(g_input_ctx, config->input_file, &decode_config)) {
+        if (g_input_ctx->fmt_ctx) avformat_close_input(&g_input_ctx->fmt_ctx);
+        input_io_close(g_input_ctx->input_io);
+        free(g_input_ctx);
+        g_input_ctx = NULL;
         return false;
     }
 
-    AVStream* video_stream = fmt_ctx->streams[video_stream_idx];
-    AVCodecParameters* codecpar = video_stream->codecpar;
+    AVFormatContext* fmt_ctx = g_input_ctx->fmt_ctx;
+    AVStream* video_stream = g_input_ctx->video_stream;
 
-    *width = codecpar->width;
-    *height = codecpar->height;
+    *width = video_stream->codecpar->width;
+    *height = video_stream->codecpar->height;
 
     AVRational frame_rate = video_stream->avg_frame_rate;
     if (frame_rate.num == 0 || frame_rate.den == 0) {
@@ -1389,38 +8669,80 @@ bool video_get_info(const char* filename, int* width, int* height, double* fps,
     }
     *fps = av_q2d(frame_rate);
 
-    *frame_count = video_stream->nb_frames;
+    g_input_ctx->packet_index = packet_index_open(config, g_input_ctx);
+
+    *frame_count = packet_index_frame_count(g_input_ctx->packet_index);
+    if (*frame_count <= 0) {
+        *frame_count = video_stream->nb_frames;
+    }
     if (*frame_count <= 0 && fmt_ctx->duration != AV_NOPTS_VALUE) {
         *frame_count = (int64_t)(fmt_ctx->duration * (*fps) / AV_TIME_BASE);
     }
 
-    avformat_close_input(&fmt_ctx);
-
-    g_input_ctx = (VideoContext*)calloc(1, sizeof(VideoContext));
-    if (!g_input_ctx) {
-        return false;
+    if (config->start_time > 0 || config->end_time > 0) {
+        double duration = fmt_ctx->duration != AV_NOPTS_VALUE ? fmt_ctx->duration / (double)AV_TIME_BASE :
+            (*fps > 0 ? *frame_count / *fps : 0);
+        double end_time = config->end_time > 0 && config->end_time < duration ? config->end_time : duration;
+        *frame_count = end_time > config->start_time ? (int64_t)((end_time - config->start_time) * (*fps) + 0.5) : 0;
     }
 
-    BlurConfig dummy_config = { 0 };
-    dummy_config.gpu_decoding = false;
-    dummy_config.threads = 1;
-    strcpy(dummy_config.gpu_type, "nvidia");
+    return true;
+}
 
-    bool result = open_input_video(g_input_ctx, filename, &dummy_config);
-    if (!result && g_input_ctx) {
-        free(g_input_ctx);
-        g_input_ctx = NULL;
+static void close_output_video(VideoContext* output) {
+    if (!output) return;
+
+    raw_sink_close(output->raw_sink);
+    shm_sink_close(output->shm_sink);
+    image_sink_close(output->image_sink);
+    if (output->frame) av_frame_free(&output->frame);
+    if (output->packet) av_packet_free(&output->packet);
+    if (output->codec_ctx) avcodec_free_context(&output->codec_ctx);
+    if (output->sws_ctx) sws_freeContext(output->sws_ctx);
+    if (output->fmt_ctx) {
+        if (output->output_io) {
+            output_io_close(output->output_io);
+            output->fmt_ctx->pb = NULL;
+        }
+        else if (output->fmt_ctx->pb) {
+            avio_closep(&output->fmt_ctx->pb);
+        }
+        avformat_free_context(output->fmt_ctx);
     }
-
-    return result;
+    free(output);
 }
 
 void video_cleanup(void) {
-    if (g_frame_queue) {
-        frame_queue_destroy(g_frame_queue);
-        free(g_frame_queue);
-        g_frame_queue = NULL;
+    mux_stop();
+
+    for (int i = 0; i < g_branch_count; i++) {
+        RenderBranch* branch = &g_branches[i];
+        if (branch->queue) {
+            frame_queue_destroy(branch->queue);
+            free(branch->queue);
+        }
+        close_output_video(branch->output);
+
+        for (int j = 0; j < branch->rendition_count; j++) {
+            Rendition* rendition = &branch->renditions[j];
+            if (rendition->queue) {
+                frame_queue_destroy(rendition->queue);
+                free(rendition->queue);
+            }
+            close_output_video(rendition->output);
+            if (!g_render_complete) {
+                remove(rendition->filename);
+            }
+        }
+        free(branch->renditions);
+        free(branch->rendition_queues);
     }
+    free(g_branches);
+    free(g_branch_queues);
+    g_branches = NULL;
+    g_branch_queues = NULL;
+    g_branch_count = 0;
+    shared_frame_pool_destroy();
 
     if (g_filter_graph) {
         avfilter_graph_free(&g_filter_graph);
@@ -1434,29 +8756,22 @@ void video_cleanup(void) {
         if (g_input_ctx->packet) av_packet_free(&g_input_ctx->packet);
         if (g_input_ctx->codec_ctx) avcodec_free_context(&g_input_ctx->codec_ctx);
         if (g_input_ctx->fmt_ctx) avformat_close_input(&g_input_ctx->fmt_ctx);
+        if (g_input_ctx->input_io) input_io_close(g_input_ctx->input_io);
+        if (g_input_ctx->raw_source) raw_source_close(g_input_ctx->raw_source);
+        if (g_input_ctx->image_sequence) image_sequence_close(g_input_ctx->image_sequence);
+        if (g_input_ctx->packet_index) packet_index_close(g_input_ctx->packet_index);
         if (g_input_ctx->hw_device_ctx) av_buffer_unref(&g_input_ctx->hw_device_ctx);
         if (g_input_ctx->sws_ctx) sws_freeContext(g_input_ctx->sws_ctx);
+        if (g_ingest_frame) av_frame_free(&g_ingest_frame);
         free(g_input_ctx);
         g_input_ctx = NULL;
     }
 
-    if (g_output_ctx) {
-        if (g_output_ctx->frame) av_frame_free(&g_output_ctx->frame);
-        if (g_output_ctx->packet) av_packet_free(&g_output_ctx->packet);
-        if (g_output_ctx->codec_ctx) avcodec_free_context(&g_output_ctx->codec_ctx);
-        if (g_output_ctx->fmt_ctx) {
-            if (g_output_ctx->fmt_ctx->pb) avio_closep(&g_output_ctx->fmt_ctx->pb);
-            avformat_free_context(g_output_ctx->fmt_ctx);
-        }
-        free(g_output_ctx);
-        g_output_ctx = NULL;
-    }
-
 #ifdef HAVE_VAPOURSYNTH
     if (g_vs_ctx) {
         if (g_vs_ctx->node) g_vs_ctx->vsapi->freeNode(g_vs_ctx->node);
         if (g_vs_ctx->script) vsscript_freeScript(g_vs_ctx->script);
-        if (g_vs_ctx->core) g_vs_ctx->vsapi->freeCore(g_vs_ctx->core);
+        if (g_vs_ctx->vsapi) vsscript_finalize();
         if (g_vs_ctx->library) {
 #ifdef _WIN32
             FreeLibrary(g_vs_ctx->library);